@@ -0,0 +1,223 @@
+#include "fixed_point.h"
+
+#define MANTISSA_LIMIT  100000000000000000ull      // 10^17, digits beyond are dropped
+#define EXPONENT_LIMIT  1000
+
+static const uint64_t pow10[19] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull,
+};
+
+/**
+ * Check for a decimal digit
+ */
+static bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * Apply sign to a magnitude, failing if it does not fit in int32_t
+ */
+static bool apply_sign(uint64_t magnitude, bool negative, int32_t *value)
+{
+    if (magnitude > (negative ? 2147483648ull : 2147483647ull)) {
+        return false;
+    }
+    *value = negative ? (int32_t)(0 - (int64_t)magnitude) : (int32_t)magnitude;
+    return true;
+}
+
+/**
+ * Parse decimal number
+ */
+bool fixed_parse(const char *text, size_t len, int decimals, int32_t *value)
+{
+    size_t i = 0;
+    bool negative = false;
+    bool digits = false;
+    uint64_t mantissa = 0;
+    int shift = decimals;       // Power of ten still to apply to the mantissa
+
+    if (decimals < 0 || decimals > FIXED_MAX_DECIMALS) {
+        return false;
+    }
+
+    if (i < len && (text[i] == '-' || text[i] == '+')) {
+        negative = (text[i] == '-');
+        i++;
+    }
+
+    // Integer part, then fraction
+    for (; i < len && is_digit(text[i]); i++) {
+        digits = true;
+        if (mantissa < MANTISSA_LIMIT) {
+            mantissa = mantissa * 10 + (uint64_t)(text[i] - '0');
+        } else {
+            shift++;
+        }
+    }
+    if (i < len && text[i] == '.') {
+        for (i++; i < len && is_digit(text[i]); i++) {
+            digits = true;
+            if (mantissa < MANTISSA_LIMIT) {
+                mantissa = mantissa * 10 + (uint64_t)(text[i] - '0');
+                shift--;
+            }
+        }
+    }
+    if (!digits) {
+        return false;
+    }
+
+    if (i < len && (text[i] == 'e' || text[i] == 'E')) {
+        bool exp_negative = false;
+        int exponent = 0;
+        i++;
+        if (i < len && (text[i] == '-' || text[i] == '+')) {
+            exp_negative = (text[i] == '-');
+            i++;
+        }
+        if (i >= len || !is_digit(text[i])) {
+            return false;
+        }
+        for (; i < len && is_digit(text[i]); i++) {
+            if (exponent < EXPONENT_LIMIT) {
+                exponent = exponent * 10 + (text[i] - '0');
+            }
+        }
+        shift += exp_negative ? -exponent : exponent;
+    }
+    if (i != len) {
+        return false;
+    }
+
+    if (mantissa == 0) {
+        *value = 0;
+        return true;
+    }
+    if (shift >= 0) {
+        if (shift > 9 || mantissa > 2147483648ull / pow10[shift]) {
+            return false;
+        }
+        mantissa *= pow10[shift];
+    } else if (shift < -18) {
+        mantissa = 0;
+    } else {
+        mantissa = (mantissa + pow10[-shift] / 2) / pow10[-shift];
+    }
+    return apply_sign(mantissa, negative, value);
+}
+
+/**
+ * Convert binary32 bit pattern
+ */
+bool fixed_from_float_bits(uint32_t bits, int decimals, int32_t *value)
+{
+    uint32_t exponent = (bits >> 23) & 0xFF;
+    uint32_t fraction = bits & 0x7FFFFF;
+
+    if (exponent == 0xFF || decimals < 0 || decimals > FIXED_MAX_DECIMALS) {
+        return false;
+    }
+
+    // value = mantissa * 2^shift, subnormals have no implicit bit
+    uint64_t mantissa = exponent ? (fraction | 0x800000) : fraction;
+    int shift = (exponent ? (int)exponent : 1) - 150;
+
+    mantissa *= pow10[decimals];
+    if (mantissa == 0) {
+        *value = 0;
+        return true;
+    }
+    if (shift >= 0) {
+        if (shift > 31 || mantissa > (2147483648ull >> shift)) {
+            return false;
+        }
+        mantissa <<= shift;
+    } else if (shift <= -64) {
+        mantissa = 0;
+    } else {
+        mantissa = (mantissa + (1ull << (-shift - 1))) >> -shift;
+    }
+    return apply_sign(mantissa, (bits >> 31) != 0, value);
+}
+
+/**
+ * Rescale value
+ */
+int32_t fixed_rescale(int32_t value, int from_decimals, int to_decimals)
+{
+    if (to_decimals >= from_decimals) {
+        return (int32_t)((int64_t)value * (int64_t)pow10[to_decimals - from_decimals]);
+    }
+    return fixed_div_round(value, (int64_t)pow10[from_decimals - to_decimals]);
+}
+
+/**
+ * Rounded division
+ */
+int32_t fixed_div_round(int64_t num, int64_t den)
+{
+    if (den < 0) {
+        num = -num;
+        den = -den;
+    }
+
+    int64_t q = (num >= 0) ? (num + den / 2) / den : -((-num + den / 2) / den);
+    if (q > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (q < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)q;
+}
+
+/**
+ * Format value
+ */
+size_t fixed_format(char *buf, size_t size, int32_t value, int decimals)
+{
+    char digits[20];        // Least significant first
+    int n = 0;
+    uint32_t magnitude = (value < 0) ? 0u - (uint32_t)value : (uint32_t)value;
+
+    if (decimals < 0 || decimals > FIXED_MAX_DECIMALS) {
+        return 0;
+    }
+
+    // At least one integer digit
+    do {
+        digits[n++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0 || n <= decimals);
+
+    int skip = 0;           // Trailing fractional zeros
+    while (skip < decimals && digits[skip] == '0') {
+        skip++;
+    }
+
+    size_t len = (value < 0) + (size_t)(n - decimals) + ((skip < decimals) ? (size_t)(1 + decimals - skip) : 0);
+    if (len >= size) {
+        return 0;
+    }
+
+    char *out = buf;
+    if (value < 0) {
+        *out++ = '-';
+    }
+    for (int i = n - 1; i >= decimals; i--) {
+        *out++ = digits[i];
+    }
+    if (skip < decimals) {
+        *out++ = '.';
+        for (int i = decimals - 1; i >= skip; i--) {
+            *out++ = digits[i];
+        }
+    }
+    *out = '\0';
+    return len;
+}
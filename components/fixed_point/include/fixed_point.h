@@ -0,0 +1,55 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Decimal fixed-point numbers: an integer scaled by 10^decimals.
+ *
+ * The ESP32-C6 has no FPU, so weather values stay integers from the response
+ * body to the JSON output. Parsing, float bit pattern conversion and
+ * formatting use integer arithmetic only; rounding is half away from zero.
+ */
+
+// Weather value scales
+#define FIXED_TEMP_DECIMALS     2       // Temperature in 0.01 °C
+#define FIXED_HUM_DECIMALS      1       // Relative humidity in 0.1 % (per mille)
+#define FIXED_TEMP_SCALE        100
+#define FIXED_HUM_SCALE         10
+
+#define FIXED_MAX_DECIMALS      9
+#define FIXED_FORMAT_MAX_LEN    13      // "-2147483.648" plus terminator
+
+/**
+ * Parse a decimal number ("-12.345", "7", "1.5e2")
+ * Digits beyond the requested decimals are rounded.
+ * @param len Text length (the text need not be terminated)
+ * @return false if the text is not a number or the result does not fit
+ */
+bool fixed_parse(const char *text, size_t len, int decimals, int32_t *value);
+
+/**
+ * Convert an IEEE 754 binary32 bit pattern without floating-point instructions
+ * @return false for NaN, infinity or a result that does not fit
+ */
+bool fixed_from_float_bits(uint32_t bits, int decimals, int32_t *value);
+
+/**
+ * Change the number of decimals of a value (rounded when reducing)
+ */
+int32_t fixed_rescale(int32_t value, int from_decimals, int to_decimals);
+
+/**
+ * Divide with rounding (den must not be 0)
+ */
+int32_t fixed_div_round(int64_t num, int64_t den);
+
+/**
+ * Format a value, trailing fractional zeros dropped ("26.4", "-0.05", "31")
+ * @return length written (excluding terminator), 0 if buf is too small
+ */
+size_t fixed_format(char *buf, size_t size, int32_t value, int decimals);
+
+#endif // FIXED_POINT_H
@@ -0,0 +1,90 @@
+#include "heap_stats.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "metrics.h"
+#include "sdkconfig.h"
+
+#ifndef CONFIG_HEAP_USE_HOOKS
+#error "heap_stats needs CONFIG_HEAP_USE_HOOKS=y"
+#endif
+
+static atomic_uint alloc_count;
+static atomic_uint free_count;
+static atomic_uint alloc_bytes;
+
+/**
+ * Called by the heap after every successful allocation (may run in an ISR)
+ */
+IRAM_ATTR void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&alloc_bytes, size, memory_order_relaxed);
+}
+
+/**
+ * Called by the heap on every free
+ */
+IRAM_ATTR void esp_heap_trace_free_hook(void *ptr)
+{
+    atomic_fetch_add_explicit(&free_count, 1, memory_order_relaxed);
+}
+
+static int64_t read_allocs(void)
+{
+    return atomic_load_explicit(&alloc_count, memory_order_relaxed);
+}
+
+static int64_t read_alloc_bytes(void)
+{
+    return atomic_load_explicit(&alloc_bytes, memory_order_relaxed);
+}
+
+static int64_t read_free_bytes(void)
+{
+    return heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+}
+
+static int64_t read_min_free_bytes(void)
+{
+    return heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+}
+
+static int64_t read_largest_free_block(void)
+{
+    return heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+}
+
+// Exported metrics (/metrics), read when rendered
+static metric_t heap_metrics[] = {
+    METRIC_READ_INIT("heap_allocs_total", "Heap allocations", NULL, METRIC_COUNTER, read_allocs),
+    METRIC_READ_INIT("heap_alloc_bytes_total", "Heap bytes allocated", NULL, METRIC_COUNTER, read_alloc_bytes),
+    METRIC_READ_INIT("heap_free_bytes", "Free heap", NULL, METRIC_GAUGE, read_free_bytes),
+    METRIC_READ_INIT("heap_min_free_bytes", "Lowest free heap since boot", NULL, METRIC_GAUGE, read_min_free_bytes),
+    METRIC_READ_INIT("heap_largest_free_block_bytes", "Largest free heap block", NULL, METRIC_GAUGE,
+                     read_largest_free_block),
+};
+
+/**
+ * Register metrics
+ */
+void heap_stats_init(void)
+{
+    for (size_t i = 0; i < sizeof(heap_metrics) / sizeof(heap_metrics[0]); i++) {
+        metrics_register(&heap_metrics[i]);
+    }
+}
+
+/**
+ * Read counters
+ */
+void heap_stats_get(heap_stats_t *stats)
+{
+    stats->allocs = atomic_load_explicit(&alloc_count, memory_order_relaxed);
+    stats->frees = atomic_load_explicit(&free_count, memory_order_relaxed);
+    stats->alloc_bytes = atomic_load_explicit(&alloc_bytes, memory_order_relaxed);
+    stats->free_bytes = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    stats->min_free_bytes = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+    stats->largest_free_block = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+}
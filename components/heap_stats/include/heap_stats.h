@@ -0,0 +1,35 @@
+#ifndef HEAP_STATS_H
+#define HEAP_STATS_H
+
+#include <stdint.h>
+
+/*
+ * Heap allocation counters.
+ *
+ * With CONFIG_HEAP_USE_HOOKS the heap calls a hook on every allocation and
+ * free; the hooks here count them with one atomic add each. A client
+ * subtracts two readings to get the heap traffic in between, e.g. per HTTP
+ * request under load (tools/http_bench.py). Counters wrap at 2^32, so take
+ * differences in uint32_t arithmetic.
+ */
+
+typedef struct {
+    uint32_t allocs;                // Allocations since boot
+    uint32_t frees;                 // Frees since boot
+    uint32_t alloc_bytes;           // Bytes requested since boot
+    uint32_t free_bytes;            // Free heap now
+    uint32_t min_free_bytes;        // Lowest free heap since boot
+    uint32_t largest_free_block;    // Largest allocation possible now
+} heap_stats_t;
+
+/**
+ * Register the heap metrics (/metrics), once at boot
+ */
+void heap_stats_init(void);
+
+/**
+ * Read counters and current heap state (any task, never blocks)
+ */
+void heap_stats_get(heap_stats_t *stats);
+
+#endif // HEAP_STATS_H
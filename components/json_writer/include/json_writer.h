@@ -0,0 +1,95 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Streaming JSON writer.
+ *
+ * Emits compact JSON straight into a caller-provided buffer (usually on the
+ * stack) and hands it to a flush callback whenever it fills up, so building
+ * a response allocates nothing. Without a callback the whole document must
+ * fit in the buffer.
+ *
+ * Members are written with their key; pass NULL as key for array elements
+ * and the root value. Errors (buffer full without callback, failed flush,
+ * nesting too deep) are sticky and reported by json_writer_end().
+ */
+
+// Nesting levels of objects and arrays
+#define JSON_WRITER_MAX_DEPTH   16
+
+// Compare the writer with cJSON tree + print (heap use and documents per
+// second), logged once at startup (see json_writer_benchmark)
+#define JSON_WRITER_BENCHMARK   0
+
+/**
+ * Flush callback
+ * @return false to abort the document
+ */
+typedef bool (*json_writer_flush_t)(void *ctx, const char *data, size_t len);
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;                 // Bytes waiting in buf
+    size_t flushed;             // Bytes already handed to the callback
+    json_writer_flush_t flush;
+    void *ctx;
+    uint32_t has_members;       // Bit per level: a value was already written
+    uint8_t depth;
+    bool error;
+} json_writer_t;
+
+/**
+ * Start a document
+ * @param flush Callback for full buffers, NULL if the document must fit in buf
+ */
+void json_writer_init(json_writer_t *writer, char *buf, size_t size, json_writer_flush_t flush, void *ctx);
+
+void json_writer_object_begin(json_writer_t *writer, const char *key);
+void json_writer_object_end(json_writer_t *writer);
+void json_writer_array_begin(json_writer_t *writer, const char *key);
+void json_writer_array_end(json_writer_t *writer);
+
+/**
+ * Write a string, escaped (NULL is written as null)
+ */
+void json_writer_string(json_writer_t *writer, const char *key, const char *value);
+
+void json_writer_int(json_writer_t *writer, const char *key, int64_t value);
+void json_writer_bool(json_writer_t *writer, const char *key, bool value);
+void json_writer_null(json_writer_t *writer, const char *key);
+
+/**
+ * Write a decimal fixed-point value as a number (see fixed_point.h)
+ */
+void json_writer_fixed(json_writer_t *writer, const char *key, int32_t value, int decimals);
+
+/**
+ * Write text that already is valid JSON
+ */
+void json_writer_raw(json_writer_t *writer, const char *key, const char *json);
+
+/**
+ * Check that the document is complete (buffered bytes are not flushed)
+ * @return false on error or unclosed objects/arrays
+ */
+bool json_writer_end(json_writer_t *writer);
+
+/**
+ * Hand the buffered bytes to the flush callback
+ */
+bool json_writer_flush(json_writer_t *writer);
+
+#if JSON_WRITER_BENCHMARK
+/**
+ * Log documents per second and heap allocations per document of the writer
+ * against cJSON, for a document shaped like the /api/weather response
+ */
+void json_writer_benchmark(void);
+#endif
+
+#endif // JSON_WRITER_H
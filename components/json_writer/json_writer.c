@@ -0,0 +1,249 @@
+#include "json_writer.h"
+#include "fixed_point.h"
+#include <string.h>
+
+_Static_assert(JSON_WRITER_MAX_DEPTH < 32, "Levels are tracked in a 32-bit mask");
+
+/**
+ * Initialize writer
+ */
+void json_writer_init(json_writer_t *writer, char *buf, size_t size, json_writer_flush_t flush, void *ctx)
+{
+    writer->buf = buf;
+    writer->size = size;
+    writer->len = 0;
+    writer->flushed = 0;
+    writer->flush = flush;
+    writer->ctx = ctx;
+    writer->has_members = 0;
+    writer->depth = 0;
+    writer->error = (buf == NULL || size == 0);
+}
+
+/**
+ * Flush buffered bytes
+ */
+bool json_writer_flush(json_writer_t *writer)
+{
+    if (writer->error) {
+        return false;
+    }
+    if (writer->len == 0) {
+        return true;
+    }
+    if (writer->flush == NULL || !writer->flush(writer->ctx, writer->buf, writer->len)) {
+        writer->error = true;
+        return false;
+    }
+    writer->flushed += writer->len;
+    writer->len = 0;
+    return true;
+}
+
+/**
+ * Append bytes, flushing whenever the buffer is full
+ */
+static void put(json_writer_t *writer, const char *data, size_t len)
+{
+    while (len > 0 && !writer->error) {
+        size_t room = writer->size - writer->len;
+        if (room == 0) {
+            json_writer_flush(writer);
+            continue;
+        }
+        size_t n = len < room ? len : room;
+        memcpy(writer->buf + writer->len, data, n);
+        writer->len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+static void put_char(json_writer_t *writer, char c)
+{
+    if (writer->len < writer->size) {
+        writer->buf[writer->len++] = c;
+    } else {
+        put(writer, &c, 1);
+    }
+}
+
+/**
+ * Write a string literal with escaping
+ */
+static void put_string(json_writer_t *writer, const char *value)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    put_char(writer, '"');
+    const char *run = value;
+    for (const char *p = value; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        // Copy the plain run before the character, then its escape
+        put(writer, run, p - run);
+        run = p + 1;
+        switch (c) {
+        case '"':  put(writer, "\\\"", 2); break;
+        case '\\': put(writer, "\\\\", 2); break;
+        case '\n': put(writer, "\\n", 2); break;
+        case '\r': put(writer, "\\r", 2); break;
+        case '\t': put(writer, "\\t", 2); break;
+        default: {
+            char escape[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+            put(writer, escape, sizeof(escape));
+            break;
+        }
+        }
+    }
+    put(writer, run, strlen(run));
+    put_char(writer, '"');
+}
+
+/**
+ * Separator and key before a value
+ */
+static void begin_value(json_writer_t *writer, const char *key)
+{
+    uint32_t bit = 1u << writer->depth;
+    if (writer->has_members & bit) {
+        put_char(writer, ',');
+    }
+    writer->has_members |= bit;
+
+    if (key) {
+        put_string(writer, key);
+        put_char(writer, ':');
+    }
+}
+
+/**
+ * Open an object or array
+ */
+static void open_level(json_writer_t *writer, const char *key, char bracket)
+{
+    begin_value(writer, key);
+    if (writer->depth + 1 >= JSON_WRITER_MAX_DEPTH) {
+        writer->error = true;
+        return;
+    }
+    writer->depth++;
+    writer->has_members &= ~(1u << writer->depth);
+    put_char(writer, bracket);
+}
+
+/**
+ * Close an object or array
+ */
+static void close_level(json_writer_t *writer, char bracket)
+{
+    if (writer->depth == 0) {
+        writer->error = true;
+        return;
+    }
+    writer->depth--;
+    put_char(writer, bracket);
+}
+
+void json_writer_object_begin(json_writer_t *writer, const char *key)
+{
+    open_level(writer, key, '{');
+}
+
+void json_writer_object_end(json_writer_t *writer)
+{
+    close_level(writer, '}');
+}
+
+void json_writer_array_begin(json_writer_t *writer, const char *key)
+{
+    open_level(writer, key, '[');
+}
+
+void json_writer_array_end(json_writer_t *writer)
+{
+    close_level(writer, ']');
+}
+
+/**
+ * Write string
+ */
+void json_writer_string(json_writer_t *writer, const char *key, const char *value)
+{
+    begin_value(writer, key);
+    if (value) {
+        put_string(writer, value);
+    } else {
+        put(writer, "null", 4);
+    }
+}
+
+/**
+ * Write integer
+ */
+void json_writer_int(json_writer_t *writer, const char *key, int64_t value)
+{
+    char text[21];
+    char *p = text + sizeof(text);
+    uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+
+    do {
+        *--p = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        *--p = '-';
+    }
+
+    begin_value(writer, key);
+    put(writer, p, text + sizeof(text) - p);
+}
+
+void json_writer_bool(json_writer_t *writer, const char *key, bool value)
+{
+    begin_value(writer, key);
+    if (value) {
+        put(writer, "true", 4);
+    } else {
+        put(writer, "false", 5);
+    }
+}
+
+void json_writer_null(json_writer_t *writer, const char *key)
+{
+    begin_value(writer, key);
+    put(writer, "null", 4);
+}
+
+/**
+ * Write fixed-point number
+ */
+void json_writer_fixed(json_writer_t *writer, const char *key, int32_t value, int decimals)
+{
+    char text[FIXED_FORMAT_MAX_LEN];
+    size_t len = fixed_format(text, sizeof(text), value, decimals);
+
+    begin_value(writer, key);
+    if (len > 0) {
+        put(writer, text, len);
+    } else {
+        put(writer, "null", 4);
+    }
+}
+
+void json_writer_raw(json_writer_t *writer, const char *key, const char *json)
+{
+    begin_value(writer, key);
+    put(writer, json, strlen(json));
+}
+
+/**
+ * Check document
+ */
+bool json_writer_end(json_writer_t *writer)
+{
+    return !writer->error && writer->depth == 0;
+}
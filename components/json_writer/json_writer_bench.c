@@ -0,0 +1,159 @@
+#include "json_writer.h"
+
+#if JSON_WRITER_BENCHMARK
+#include <stdlib.h>
+#include <string.h>
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "fixed_point.h"
+
+#define BENCH_ITERATIONS    500
+#define BENCH_BUF_SIZE      768     // Same as the web server's response buffer
+
+static const char *TAG = "json_bench";
+
+// Heap traffic of the cJSON path, counted through cJSON_InitHooks
+static uint32_t alloc_count;
+static uint32_t alloc_bytes;
+
+// Output size, kept so the work is not optimized away
+static volatile size_t output_sink;
+
+static void *counting_malloc(size_t size)
+{
+    alloc_count++;
+    alloc_bytes += size;
+    return malloc(size);
+}
+
+/**
+ * Document as the handlers built it before: cJSON tree, cJSON_Print, free
+ */
+static void build_cjson(int i)
+{
+    char text[FIXED_FORMAT_MAX_LEN];
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "station", "Jakarta");
+    cJSON_AddNumberToObject(root, "station_index", 0);
+    cJSON_AddNumberToObject(root, "station_count", 3);
+    cJSON_AddBoolToObject(root, "valid", true);
+    fixed_format(text, sizeof(text), 2640 + i % 100, FIXED_TEMP_DECIMALS);
+    cJSON_AddRawToObject(root, "temperature", text);
+    fixed_format(text, sizeof(text), 910, FIXED_HUM_DECIMALS);
+    cJSON_AddRawToObject(root, "humidity", text);
+    cJSON_AddBoolToObject(root, "interpolated", false);
+    for (int w = 0; w < 2; w++) {
+        cJSON *window = cJSON_AddObjectToObject(root, w ? "last_24h" : "last_1h");
+        cJSON_AddNumberToObject(window, "samples", 4 + w * 92);
+        cJSON_AddRawToObject(window, "temp_min", "25.9");
+        cJSON_AddRawToObject(window, "temp_max", "27.35");
+        cJSON_AddRawToObject(window, "temp_mean", "26.61");
+    }
+    cJSON_AddNumberToObject(root, "last_update", 1771259073);
+    cJSON_AddStringToObject(root, "last_update_str", "16.02.2026 23:44:33");
+    cJSON *fetch = cJSON_AddObjectToObject(root, "fetch");
+    static const char *const counters[] = {
+        "count", "failures", "reused", "resumed", "full_handshake", "last_duration_ms",
+        "consecutive_failures", "next_fetch_in_s", "triggers", "last_body_bytes", "last_decode_us",
+    };
+    for (size_t c = 0; c < sizeof(counters) / sizeof(counters[0]); c++) {
+        cJSON_AddNumberToObject(fetch, counters[c], 1000 + i + c);
+    }
+    cJSON_AddStringToObject(fetch, "last_connection", "reused");
+
+    char *json = cJSON_Print(root);
+    output_sink = strlen(json);
+    free(json);
+    cJSON_Delete(root);
+}
+
+/**
+ * Discard output, as httpd_resp_send_chunk would consume it
+ */
+static bool discard_flush(void *ctx, const char *data, size_t len)
+{
+    return true;
+}
+
+/**
+ * Same document through the writer
+ */
+static void build_writer(int i)
+{
+    char buf[BENCH_BUF_SIZE];
+    json_writer_t json;
+    json_writer_init(&json, buf, sizeof(buf), discard_flush, NULL);
+
+    json_writer_object_begin(&json, NULL);
+    json_writer_string(&json, "station", "Jakarta");
+    json_writer_int(&json, "station_index", 0);
+    json_writer_int(&json, "station_count", 3);
+    json_writer_bool(&json, "valid", true);
+    json_writer_fixed(&json, "temperature", 2640 + i % 100, FIXED_TEMP_DECIMALS);
+    json_writer_fixed(&json, "humidity", 910, FIXED_HUM_DECIMALS);
+    json_writer_bool(&json, "interpolated", false);
+    for (int w = 0; w < 2; w++) {
+        json_writer_object_begin(&json, w ? "last_24h" : "last_1h");
+        json_writer_int(&json, "samples", 4 + w * 92);
+        json_writer_raw(&json, "temp_min", "25.9");
+        json_writer_raw(&json, "temp_max", "27.35");
+        json_writer_raw(&json, "temp_mean", "26.61");
+        json_writer_object_end(&json);
+    }
+    json_writer_int(&json, "last_update", 1771259073);
+    json_writer_string(&json, "last_update_str", "16.02.2026 23:44:33");
+    json_writer_object_begin(&json, "fetch");
+    static const char *const counters[] = {
+        "count", "failures", "reused", "resumed", "full_handshake", "last_duration_ms",
+        "consecutive_failures", "next_fetch_in_s", "triggers", "last_body_bytes", "last_decode_us",
+    };
+    for (size_t c = 0; c < sizeof(counters) / sizeof(counters[0]); c++) {
+        json_writer_int(&json, counters[c], 1000 + i + c);
+    }
+    json_writer_string(&json, "last_connection", "reused");
+    json_writer_object_end(&json);
+    json_writer_object_end(&json);
+
+    output_sink = json.flushed + json.len;
+    json_writer_flush(&json);
+}
+
+/**
+ * Run one path, log documents per second and heap traffic per document
+ */
+static void bench_path(const char *name, void (*fn)(int))
+{
+    // Warm up caches before measuring
+    fn(0);
+
+    alloc_count = 0;
+    alloc_bytes = 0;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        fn(i);
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start;
+    size_t output = output_sink;
+
+    ESP_LOGI(TAG, "%-6s  %6lu docs/s  %3lu allocs/doc  %5lu heap bytes/doc  %4u output bytes", name,
+             (unsigned long)(BENCH_ITERATIONS * 1000000LL / (elapsed_us ? elapsed_us : 1)),
+             (unsigned long)(alloc_count / BENCH_ITERATIONS), (unsigned long)(alloc_bytes / BENCH_ITERATIONS),
+             (unsigned)output);
+}
+
+/**
+ * Run benchmark
+ */
+void json_writer_benchmark(void)
+{
+    cJSON_Hooks hooks = {.malloc_fn = counting_malloc, .free_fn = free};
+    cJSON_InitHooks(&hooks);
+
+    ESP_LOGI(TAG, "/api/weather-shaped document, mean of %d", BENCH_ITERATIONS);
+    bench_path("cJSON", build_cjson);
+    bench_path("writer", build_writer);
+
+    cJSON_InitHooks(NULL);
+}
+#endif
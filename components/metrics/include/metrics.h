@@ -0,0 +1,118 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Registry of counters, gauges and histograms, rendered in the Prometheus
+ * text exposition format (/metrics).
+ *
+ * Metrics are static objects owned by the component that updates them and
+ * registered once at init. Every update is one relaxed atomic operation on
+ * 32-bit values (two for a histogram: its bucket and its sum), so any task
+ * can update without a lock. Registration pushes onto a lock-free
+ * list. A rendered scrape is not a consistent snapshot across metrics,
+ * which Prometheus does not expect anyway.
+ *
+ * Counters and histogram sums wrap at 2^32; Prometheus treats the wrap as a
+ * counter reset. A metric can also be read through a callback at render
+ * time instead of being updated (e.g. free heap).
+ */
+
+typedef enum {
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM,
+} metric_type_t;
+
+typedef struct metric {
+    const char *name;           // Family name, e.g. "weather_fetch_total"
+    const char *help;
+    const char *labels;         // e.g. "result=\"success\"", NULL for none
+    metric_type_t type;
+    int64_t (*read)(void);      // Read at render time instead of value, or NULL
+    atomic_uint value;          // Counter, or gauge as int32
+    // Histogram: observations <= bounds[i] land in buckets[i], larger ones
+    // in buckets[bucket_count] (+Inf)
+    const uint32_t *bounds;
+    atomic_uint *buckets;
+    uint8_t bucket_count;
+    uint8_t decimals;           // Histogram unit scale, e.g. 3 for ms -> s
+    atomic_uint sum;
+    struct metric *next;
+} metric_t;
+
+// Static initializers (labels may be NULL)
+#define METRIC_COUNTER_INIT(name_, help_, labels_) \
+    { .name = (name_), .help = (help_), .labels = (labels_), .type = METRIC_COUNTER }
+
+#define METRIC_GAUGE_INIT(name_, help_, labels_) \
+    { .name = (name_), .help = (help_), .labels = (labels_), .type = METRIC_GAUGE }
+
+// Counter or gauge read from fn() when rendered
+#define METRIC_READ_INIT(name_, help_, labels_, type_, fn_) \
+    { .name = (name_), .help = (help_), .labels = (labels_), .type = (type_), .read = (fn_) }
+
+// bounds_ is a static uint32_t array; buckets_ has one more entry than bounds_
+#define METRIC_HISTOGRAM_INIT(name_, help_, labels_, bounds_, buckets_, decimals_) \
+    { .name = (name_), .help = (help_), .labels = (labels_), .type = METRIC_HISTOGRAM, \
+      .bounds = (bounds_), .buckets = (buckets_), \
+      .bucket_count = sizeof(bounds_) / sizeof((bounds_)[0]), .decimals = (decimals_) }
+
+/**
+ * Add a metric to the registry (once per metric, any task)
+ * Metrics sharing a name are rendered as one family; give them the same
+ * type and help text and distinct labels.
+ */
+void metrics_register(metric_t *metric);
+
+static inline void metrics_counter_add(metric_t *metric, uint32_t n)
+{
+    atomic_fetch_add_explicit(&metric->value, n, memory_order_relaxed);
+}
+
+static inline void metrics_counter_inc(metric_t *metric)
+{
+    metrics_counter_add(metric, 1);
+}
+
+static inline void metrics_gauge_set(metric_t *metric, int32_t value)
+{
+    atomic_store_explicit(&metric->value, (unsigned)value, memory_order_relaxed);
+}
+
+static inline void metrics_gauge_add(metric_t *metric, int32_t delta)
+{
+    atomic_fetch_add_explicit(&metric->value, (unsigned)delta, memory_order_relaxed);
+}
+
+/**
+ * Record one observation in a histogram
+ */
+void metrics_observe(metric_t *metric, uint32_t value);
+
+/**
+ * Get the number of observations of a histogram
+ */
+uint32_t metrics_histogram_count(const metric_t *metric);
+
+/**
+ * Estimate a percentile of a histogram
+ * @return upper bound of the bucket holding it, UINT32_MAX for the +Inf
+ *         bucket, 0 without observations
+ */
+uint32_t metrics_histogram_percentile(const metric_t *metric, uint32_t percent);
+
+// Receives rendered text in pieces of at most the buffer size
+typedef bool (*metrics_flush_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * Render all metrics in text exposition format through buf
+ * @return false if a flush failed
+ */
+bool metrics_render(char *buf, size_t size, metrics_flush_t flush, void *ctx);
+
+#endif // METRICS_H
@@ -0,0 +1,253 @@
+#include "metrics.h"
+#include <string.h>
+
+// Registered metrics, newest first
+static _Atomic(metric_t *) registry = NULL;
+
+/**
+ * Register metric
+ */
+void metrics_register(metric_t *metric)
+{
+    metric_t *head = atomic_load_explicit(&registry, memory_order_relaxed);
+    do {
+        metric->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&registry, &head, metric,
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+/**
+ * Record observation
+ */
+void metrics_observe(metric_t *metric, uint32_t value)
+{
+    uint8_t i = 0;
+    while (i < metric->bucket_count && value > metric->bounds[i]) {
+        i++;
+    }
+    atomic_fetch_add_explicit(&metric->buckets[i], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&metric->sum, value, memory_order_relaxed);
+}
+
+/**
+ * Get observation count
+ */
+uint32_t metrics_histogram_count(const metric_t *metric)
+{
+    uint32_t count = 0;
+    for (uint8_t i = 0; i <= metric->bucket_count; i++) {
+        count += atomic_load_explicit(&metric->buckets[i], memory_order_relaxed);
+    }
+    return count;
+}
+
+/**
+ * Estimate percentile
+ */
+uint32_t metrics_histogram_percentile(const metric_t *metric, uint32_t percent)
+{
+    uint32_t count = metrics_histogram_count(metric);
+    if (count == 0) {
+        return 0;
+    }
+
+    // Rank of the observation, 1-based and rounded up
+    uint32_t rank = (uint32_t)(((uint64_t)count * percent + 99) / 100);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < metric->bucket_count; i++) {
+        seen += atomic_load_explicit(&metric->buckets[i], memory_order_relaxed);
+        if (seen >= rank) {
+            return metric->bounds[i];
+        }
+    }
+    return UINT32_MAX;
+}
+
+// Output buffer handed to the flush callback whenever it is full
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+    metrics_flush_t flush;
+    void *ctx;
+    bool error;
+} render_t;
+
+static void flush_out(render_t *out)
+{
+    if (out->len > 0 && !out->error && !out->flush(out->ctx, out->buf, out->len)) {
+        out->error = true;
+    }
+    out->len = 0;
+}
+
+static void put(render_t *out, const char *data, size_t len)
+{
+    while (len > 0 && !out->error) {
+        if (out->len == out->size) {
+            flush_out(out);
+            continue;
+        }
+        size_t n = out->size - out->len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(out->buf + out->len, data, n);
+        out->len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+static void put_str(render_t *out, const char *s)
+{
+    put(out, s, strlen(s));
+}
+
+#define NUMBER_TEXT_LEN     24
+
+/**
+ * Format a signed value with an implied decimal point (decimals digits)
+ * @return start of the text, which ends at text + NUMBER_TEXT_LEN
+ */
+static char *format_number(char *text, int64_t value, uint8_t decimals)
+{
+    char *p = text + NUMBER_TEXT_LEN;
+    uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+
+    for (uint8_t i = 0; i < decimals; i++) {
+        *--p = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    }
+    if (decimals > 0) {
+        *--p = '.';
+    }
+    do {
+        *--p = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        *--p = '-';
+    }
+    return p;
+}
+
+static void put_number(render_t *out, int64_t value, uint8_t decimals)
+{
+    char text[NUMBER_TEXT_LEN];
+    char *p = format_number(text, value, decimals);
+    put(out, p, text + NUMBER_TEXT_LEN - p);
+}
+
+/**
+ * Write "name<suffix>{labels[,extra]} "
+ */
+static void put_series(render_t *out, const metric_t *metric, const char *suffix, const char *extra)
+{
+    put_str(out, metric->name);
+    put_str(out, suffix);
+    if (metric->labels || extra) {
+        put(out, "{", 1);
+        if (metric->labels) {
+            put_str(out, metric->labels);
+        }
+        if (metric->labels && extra) {
+            put(out, ",", 1);
+        }
+        if (extra) {
+            put_str(out, extra);
+        }
+        put(out, "}", 1);
+    }
+    put(out, " ", 1);
+}
+
+/**
+ * Write the samples of one metric
+ */
+static void render_samples(render_t *out, const metric_t *metric)
+{
+    if (metric->type != METRIC_HISTOGRAM) {
+        int64_t value;
+        if (metric->read) {
+            value = metric->read();
+        } else {
+            unsigned raw = atomic_load_explicit(&metric->value, memory_order_relaxed);
+            value = metric->type == METRIC_GAUGE ? (int64_t)(int32_t)raw : (int64_t)raw;
+        }
+        put_series(out, metric, "", NULL);
+        put_number(out, value, 0);
+        put(out, "\n", 1);
+        return;
+    }
+
+    // Buckets are stored per range and exposed cumulatively
+    uint32_t count = 0;
+    for (uint8_t i = 0; i <= metric->bucket_count; i++) {
+        count += atomic_load_explicit(&metric->buckets[i], memory_order_relaxed);
+
+        char le[NUMBER_TEXT_LEN + 6] = "le=\"+Inf\"";
+        if (i < metric->bucket_count) {
+            char text[NUMBER_TEXT_LEN];
+            char *bound = format_number(text, metric->bounds[i], metric->decimals);
+            size_t len = text + NUMBER_TEXT_LEN - bound;
+            memcpy(le + 4, bound, len);
+            memcpy(le + 4 + len, "\"", 2);
+        }
+        put_series(out, metric, "_bucket", le);
+        put_number(out, count, 0);
+        put(out, "\n", 1);
+    }
+    put_series(out, metric, "_sum", NULL);
+    put_number(out, atomic_load_explicit(&metric->sum, memory_order_relaxed), metric->decimals);
+    put(out, "\n", 1);
+    put_series(out, metric, "_count", NULL);
+    put_number(out, count, 0);
+    put(out, "\n", 1);
+}
+
+/**
+ * Render all metrics
+ */
+bool metrics_render(char *buf, size_t size, metrics_flush_t flush, void *ctx)
+{
+    static const char *const type_names[] = {"counter", "gauge", "histogram"};
+    render_t out = {.buf = buf, .size = size, .flush = flush, .ctx = ctx};
+    metric_t *head = atomic_load_explicit(&registry, memory_order_acquire);
+
+    for (metric_t *metric = head; metric && !out.error; metric = metric->next) {
+        // A family is written where its first member appears in the list
+        bool seen = false;
+        for (metric_t *prev = head; prev != metric; prev = prev->next) {
+            if (strcmp(prev->name, metric->name) == 0) {
+                seen = true;
+                break;
+            }
+        }
+        if (seen) {
+            continue;
+        }
+
+        put_str(&out, "# HELP ");
+        put_str(&out, metric->name);
+        put(&out, " ", 1);
+        put_str(&out, metric->help);
+        put_str(&out, "\n# TYPE ");
+        put_str(&out, metric->name);
+        put(&out, " ", 1);
+        put_str(&out, type_names[metric->type]);
+        put(&out, "\n", 1);
+
+        for (metric_t *member = metric; member; member = member->next) {
+            if (strcmp(member->name, metric->name) == 0) {
+                render_samples(&out, member);
+            }
+        }
+    }
+
+    flush_out(&out);
+    return !out.error;
+}
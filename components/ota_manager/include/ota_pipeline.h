@@ -0,0 +1,74 @@
+#ifndef OTA_PIPELINE_H
+#define OTA_PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/*
+ * Pipelined firmware upload.
+ *
+ * The receiving task (the upload handler) fills buffers from a small pool
+ * and submits them; a writer task drains them into the OTA partition with
+ * ota_manager_write(). Receiving and flash writes/erases overlap instead of
+ * alternating. The pool bounds the data in flight: when all buffers wait
+ * for the flash, acquiring the next one blocks and the socket is not read,
+ * so TCP flow control slows the sender down.
+ */
+
+#define OTA_PIPELINE_BUF_SIZE       4096    // One flash sector
+#define OTA_PIPELINE_BUF_COUNT      4       // Pool size (bounds queue depth)
+#define OTA_PIPELINE_TASK_STACK     4096
+#define OTA_PIPELINE_TASK_PRIORITY  5       // Same as the receiving task
+
+// Time per stage of the last upload (ms) and queue use
+typedef struct {
+    uint32_t bytes;
+    uint32_t elapsed_ms;            // Start to finish, the OTA window
+    uint32_t receive_ms;            // Producer filling buffers
+    uint32_t write_ms;              // Writer in ota_manager_write (erase + program)
+    uint32_t receive_stall_ms;      // Producer waiting for a free buffer (flash bound)
+    uint32_t write_idle_ms;         // Writer waiting for a full buffer (network bound)
+    uint32_t max_queued;            // Most buffers waiting for the writer
+} ota_pipeline_stats_t;
+
+/**
+ * Begin an OTA update, allocate the pool and start the writer task
+ * @param file_size Total size (for progress), 0 if unknown
+ */
+esp_err_t ota_pipeline_start(size_t file_size);
+
+/**
+ * Get an empty buffer of OTA_PIPELINE_BUF_SIZE bytes
+ * Blocks while all buffers are queued for the writer.
+ * @return NULL if the writer failed
+ */
+uint8_t* ota_pipeline_acquire(void);
+
+/**
+ * Queue a filled buffer for writing (len may be less than the buffer size)
+ * @return error of an earlier write, if any
+ */
+esp_err_t ota_pipeline_submit(uint8_t *buf, size_t len);
+
+/**
+ * Wait until all buffers are written, then finalize the update
+ */
+esp_err_t ota_pipeline_finish(void);
+
+/**
+ * Stop the writer and abort the update
+ */
+void ota_pipeline_abort(void);
+
+/**
+ * Get statistics of the last (or running) upload
+ */
+void ota_pipeline_get_stats(ota_pipeline_stats_t *stats);
+
+/**
+ * Throughput of a stage in KB/s (0 if no time was spent)
+ */
+uint32_t ota_pipeline_kbps(uint32_t bytes, uint32_t ms);
+
+#endif // OTA_PIPELINE_H
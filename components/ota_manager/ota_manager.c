@@ -2,6 +2,7 @@
 #include "esp_log.h"
 #include "esp_ota_ops.h"
 #include "led_indicator.h"
+#include "metrics.h"
 #include <string.h>
 
 static const char *TAG = "OTA_MANAGER";
@@ -16,11 +17,20 @@ static bool ota_in_progress = false;
 // Progress callback
 static ota_progress_cb_t progress_callback = NULL;
 
+// Exported metrics (/metrics)
+static metric_t written_metric = METRIC_COUNTER_INIT("ota_written_bytes_total", "Firmware bytes written to flash", NULL);
+static metric_t success_metric = METRIC_COUNTER_INIT("ota_updates_total", "OTA updates by result", "result=\"success\"");
+static metric_t failure_metric = METRIC_COUNTER_INIT("ota_updates_total", "OTA updates by result", "result=\"failure\"");
+
 /**
  * Initialize OTA manager
  */
 esp_err_t ota_manager_init(void)
 {
+    metrics_register(&written_metric);
+    metrics_register(&success_metric);
+    metrics_register(&failure_metric);
+    
     ESP_LOGI(TAG, "OTA Manager initialized");
     ESP_LOGI(TAG, "Firmware Version: %s", FIRMWARE_VERSION);
     ESP_LOGI(TAG, "Running Partition: %s", ota_manager_get_partition());
@@ -49,8 +59,9 @@ esp_err_t ota_manager_begin(size_t file_size)
     ESP_LOGI(TAG, "Writing to partition '%s' at offset 0x%lx", 
              update_partition->label, update_partition->address);
     
-    // Begin OTA
-    esp_err_t err = esp_ota_begin(update_partition, OTA_SIZE_UNKNOWN, &ota_handle);
+    // Begin OTA: sectors are erased as the writes reach them, not all up front,
+    // so the upload starts at once and erasing overlaps with receiving
+    esp_err_t err = esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &ota_handle);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "OTA begin failed: %s", esp_err_to_name(err));
         return err;
@@ -84,6 +95,7 @@ esp_err_t ota_manager_write(const void *data, size_t size)
     }
     
     total_written += size;
+    metrics_counter_add(&written_metric, size);
     
     // Call progress callback
     if (progress_callback) {
@@ -121,6 +133,7 @@ esp_err_t ota_manager_end(void)
         ESP_LOGE(TAG, "OTA end failed: %s", esp_err_to_name(err));
         led_set_system_status(LED_SYSTEM_RECOVERY);
         ota_in_progress = false;
+        metrics_counter_inc(&failure_metric);
         return err;
     }
     
@@ -130,10 +143,12 @@ esp_err_t ota_manager_end(void)
         ESP_LOGE(TAG, "Set boot partition failed: %s", esp_err_to_name(err));
         led_set_system_status(LED_SYSTEM_RECOVERY);
         ota_in_progress = false;
+        metrics_counter_inc(&failure_metric);
         return err;
     }
     
     ota_in_progress = false;
+    metrics_counter_inc(&success_metric);
     
     ESP_LOGI(TAG, "OTA update successful!");
     ESP_LOGI(TAG, "New partition: %s", update_partition->label);
@@ -150,6 +165,7 @@ void ota_manager_abort(void)
         ESP_LOGW(TAG, "Aborting OTA update");
         esp_ota_abort(ota_handle);
         ota_in_progress = false;
+        metrics_counter_inc(&failure_metric);
         led_set_system_status(LED_SYSTEM_RECOVERY);
     }
 }
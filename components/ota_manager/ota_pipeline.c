@@ -0,0 +1,263 @@
+#include "ota_pipeline.h"
+#include "ota_manager.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "OTA_PIPELINE";
+
+// Filled buffer on its way to the writer (buf NULL ends the writer)
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+} ota_chunk_t;
+
+static uint8_t *pool = NULL;
+static QueueHandle_t free_queue = NULL;     // Empty buffers
+static QueueHandle_t full_queue = NULL;     // Chunks to write
+static SemaphoreHandle_t writer_done = NULL;
+static volatile esp_err_t writer_err = ESP_OK;
+static bool running = false;
+static portMUX_TYPE running_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Stage times in microseconds (producer fields are only touched by the
+// receiving task, writer fields only by the writer task)
+static int64_t start_us;
+static int64_t fill_start_us;
+static int64_t receive_us;
+static int64_t receive_stall_us;
+static int64_t write_us;
+static int64_t write_idle_us;
+static uint32_t bytes_total;
+static uint32_t max_queued;
+static uint32_t elapsed_ms;
+
+/**
+ * Writer task - drains filled buffers into the OTA partition
+ */
+static void writer_task(void *pvParameters)
+{
+    ota_chunk_t chunk;
+
+    for (;;) {
+        int64_t wait_start = esp_timer_get_time();
+        xQueueReceive(full_queue, &chunk, portMAX_DELAY);
+        write_idle_us += esp_timer_get_time() - wait_start;
+
+        if (chunk.buf == NULL) {
+            break;
+        }
+
+        // After a failure buffers are only recycled, so the producer never blocks forever
+        if (writer_err == ESP_OK) {
+            int64_t write_start = esp_timer_get_time();
+            esp_err_t err = ota_manager_write(chunk.buf, chunk.len);
+            write_us += esp_timer_get_time() - write_start;
+            if (err != ESP_OK) {
+                writer_err = err;
+            }
+        }
+        xQueueSend(free_queue, &chunk.buf, 0);
+    }
+
+    xSemaphoreGive(writer_done);
+    vTaskDelete(NULL);
+}
+
+/**
+ * Free pool, queues and semaphore
+ */
+static void release_resources(void)
+{
+    if (full_queue) {
+        vQueueDelete(full_queue);
+        full_queue = NULL;
+    }
+    if (free_queue) {
+        vQueueDelete(free_queue);
+        free_queue = NULL;
+    }
+    if (writer_done) {
+        vSemaphoreDelete(writer_done);
+        writer_done = NULL;
+    }
+    free(pool);
+    pool = NULL;
+    taskENTER_CRITICAL(&running_lock);
+    running = false;
+    taskEXIT_CRITICAL(&running_lock);
+}
+
+/**
+ * Send the end marker and wait for the writer to exit
+ */
+static void stop_writer(void)
+{
+    ota_chunk_t end = {NULL, 0};
+    xQueueSend(full_queue, &end, portMAX_DELAY);
+    xSemaphoreTake(writer_done, portMAX_DELAY);
+    elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+}
+
+/**
+ * Start pipeline
+ */
+esp_err_t ota_pipeline_start(size_t file_size)
+{
+    // Claim the pipeline atomically: uploads can arrive on different workers
+    taskENTER_CRITICAL(&running_lock);
+    bool busy = running;
+    running = true;
+    taskEXIT_CRITICAL(&running_lock);
+    if (busy) {
+        ESP_LOGE(TAG, "Upload already in progress");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    pool = malloc(OTA_PIPELINE_BUF_COUNT * OTA_PIPELINE_BUF_SIZE);
+    free_queue = xQueueCreate(OTA_PIPELINE_BUF_COUNT, sizeof(uint8_t *));
+    full_queue = xQueueCreate(OTA_PIPELINE_BUF_COUNT + 1, sizeof(ota_chunk_t));
+    writer_done = xSemaphoreCreateBinary();
+    if (!pool || !free_queue || !full_queue || !writer_done) {
+        ESP_LOGE(TAG, "Out of memory for %d x %d byte buffers", OTA_PIPELINE_BUF_COUNT, OTA_PIPELINE_BUF_SIZE);
+        release_resources();
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < OTA_PIPELINE_BUF_COUNT; i++) {
+        uint8_t *buf = pool + i * OTA_PIPELINE_BUF_SIZE;
+        xQueueSend(free_queue, &buf, 0);
+    }
+
+    esp_err_t err = ota_manager_begin(file_size);
+    if (err != ESP_OK) {
+        release_resources();
+        return err;
+    }
+
+    writer_err = ESP_OK;
+    receive_us = receive_stall_us = write_us = write_idle_us = 0;
+    bytes_total = 0;
+    max_queued = 0;
+    elapsed_ms = 0;
+    start_us = esp_timer_get_time();
+
+    if (xTaskCreate(writer_task, "ota_writer", OTA_PIPELINE_TASK_STACK, NULL,
+                    OTA_PIPELINE_TASK_PRIORITY, NULL) != pdPASS) {
+        ota_manager_abort();
+        release_resources();
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Get empty buffer
+ */
+uint8_t* ota_pipeline_acquire(void)
+{
+    uint8_t *buf;
+    int64_t wait_start = esp_timer_get_time();
+    xQueueReceive(free_queue, &buf, portMAX_DELAY);
+    fill_start_us = esp_timer_get_time();
+    receive_stall_us += fill_start_us - wait_start;
+
+    if (writer_err != ESP_OK) {
+        xQueueSend(free_queue, &buf, 0);
+        return NULL;
+    }
+    return buf;
+}
+
+/**
+ * Queue filled buffer
+ */
+esp_err_t ota_pipeline_submit(uint8_t *buf, size_t len)
+{
+    receive_us += esp_timer_get_time() - fill_start_us;
+    bytes_total += len;
+
+    // Never blocks: the queue has room for every buffer of the pool
+    ota_chunk_t chunk = {buf, len};
+    xQueueSend(full_queue, &chunk, portMAX_DELAY);
+
+    uint32_t queued = uxQueueMessagesWaiting(full_queue);
+    if (queued > max_queued) {
+        max_queued = queued;
+    }
+    return writer_err;
+}
+
+/**
+ * Finish upload
+ */
+esp_err_t ota_pipeline_finish(void)
+{
+    if (!running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    stop_writer();
+    esp_err_t err = writer_err;
+    release_resources();
+
+    if (err != ESP_OK) {
+        ota_manager_abort();
+        return err;
+    }
+
+    ota_pipeline_stats_t stats;
+    ota_pipeline_get_stats(&stats);
+    ESP_LOGI(TAG, "%lu bytes in %lu ms (%lu KB/s), receive %lu KB/s, flash %lu KB/s",
+             (unsigned long)stats.bytes, (unsigned long)stats.elapsed_ms,
+             (unsigned long)ota_pipeline_kbps(stats.bytes, stats.elapsed_ms),
+             (unsigned long)ota_pipeline_kbps(stats.bytes, stats.receive_ms),
+             (unsigned long)ota_pipeline_kbps(stats.bytes, stats.write_ms));
+    ESP_LOGI(TAG, "Sequential receive + write would take %lu ms; stalled on flash %lu ms, on network %lu ms, "
+             "max %lu buffers queued", (unsigned long)(stats.receive_ms + stats.write_ms),
+             (unsigned long)stats.receive_stall_ms, (unsigned long)stats.write_idle_ms,
+             (unsigned long)stats.max_queued);
+
+    return ota_manager_end();
+}
+
+/**
+ * Abort upload
+ */
+void ota_pipeline_abort(void)
+{
+    if (!running) {
+        return;
+    }
+
+    stop_writer();
+    release_resources();
+    ota_manager_abort();
+}
+
+/**
+ * Get statistics
+ */
+void ota_pipeline_get_stats(ota_pipeline_stats_t *stats)
+{
+    stats->bytes = bytes_total;
+    stats->elapsed_ms = running ? (uint32_t)((esp_timer_get_time() - start_us) / 1000) : elapsed_ms;
+    stats->receive_ms = (uint32_t)(receive_us / 1000);
+    stats->write_ms = (uint32_t)(write_us / 1000);
+    stats->receive_stall_ms = (uint32_t)(receive_stall_us / 1000);
+    stats->write_idle_ms = (uint32_t)(write_idle_us / 1000);
+    stats->max_queued = max_queued;
+}
+
+/**
+ * Stage throughput
+ */
+uint32_t ota_pipeline_kbps(uint32_t bytes, uint32_t ms)
+{
+    return ms ? (uint32_t)((uint64_t)bytes * 1000 / 1024 / ms) : 0;
+}
@@ -0,0 +1,51 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+/*
+ * Versioned publication of a small struct between tasks (seqlock).
+ *
+ * Writers copy the new value in a short critical section and bump the
+ * sequence counter before and after. Readers never take a lock: they copy
+ * the value and retry if the counter moved or was odd (write in progress),
+ * so they never see a torn update. The completed write count doubles as a
+ * cheap change indicator.
+ */
+typedef struct {
+    atomic_uint seq;        // Odd while a write is in progress
+    portMUX_TYPE lock;      // Serializes writers
+    void *data;
+    size_t size;
+} snapshot_t;
+
+// Static initializer for a snapshot over existing storage
+#define SNAPSHOT_INIT(storage, storage_size) \
+    { .seq = 0, .lock = portMUX_INITIALIZER_UNLOCKED, .data = (storage), .size = (storage_size) }
+
+/**
+ * Initialize a snapshot at runtime
+ * @param storage Backing storage, holds the initial value
+ */
+void snapshot_init(snapshot_t *snap, void *storage, size_t size);
+
+/**
+ * Publish a new value (any task, not from ISR)
+ */
+void snapshot_write(snapshot_t *snap, const void *value);
+
+/**
+ * Copy the latest value (never blocks)
+ * @return version of the value copied
+ */
+uint32_t snapshot_read(snapshot_t *snap, void *out);
+
+/**
+ * Get the number of completed writes
+ */
+uint32_t snapshot_version(snapshot_t *snap);
+
+#endif // SNAPSHOT_H
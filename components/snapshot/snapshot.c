@@ -0,0 +1,61 @@
+#include "snapshot.h"
+#include <string.h>
+
+/**
+ * Initialize snapshot
+ */
+void snapshot_init(snapshot_t *snap, void *storage, size_t size)
+{
+    atomic_init(&snap->seq, 0);
+    portMUX_INITIALIZE(&snap->lock);
+    snap->data = storage;
+    snap->size = size;
+}
+
+/**
+ * Publish value
+ */
+void snapshot_write(snapshot_t *snap, const void *value)
+{
+    taskENTER_CRITICAL(&snap->lock);
+
+    unsigned seq = atomic_load_explicit(&snap->seq, memory_order_relaxed);
+    atomic_store_explicit(&snap->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    memcpy(snap->data, value, snap->size);
+
+    atomic_store_explicit(&snap->seq, seq + 2, memory_order_release);
+
+    taskEXIT_CRITICAL(&snap->lock);
+}
+
+/**
+ * Read value
+ */
+uint32_t snapshot_read(snapshot_t *snap, void *out)
+{
+    unsigned before;
+    unsigned after = 0;
+
+    do {
+        before = atomic_load_explicit(&snap->seq, memory_order_acquire);
+        if (before & 1) {
+            // Writer on the other core, its critical section is short
+            continue;
+        }
+        memcpy(out, snap->data, snap->size);
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&snap->seq, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    return before >> 1;
+}
+
+/**
+ * Completed writes
+ */
+uint32_t snapshot_version(snapshot_t *snap)
+{
+    return atomic_load_explicit(&snap->seq, memory_order_acquire) >> 1;
+}
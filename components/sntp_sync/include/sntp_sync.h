@@ -2,6 +2,7 @@
 #define SNTP_SYNC_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 
 // Task configuration
@@ -33,6 +34,18 @@ bool sntp_sync_get_time(struct tm *timeinfo);
  */
 bool sntp_sync_is_synced(void);
 
+/**
+ * Get time of the last NTP update
+ * @return epoch of the last update, 0 if none yet
+ */
+time_t sntp_sync_get_last_sync(void);
+
+/**
+ * Get sync status version
+ * @return counter that increases whenever the sync status changes
+ */
+uint32_t sntp_sync_get_version(void);
+
 /**
  * Get epoch timestamp
  * @return current epoch time
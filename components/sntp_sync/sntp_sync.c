@@ -3,6 +3,7 @@
 #include "esp_sntp.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "snapshot.h"
 #include <string.h>
 #include <time.h>
 #include <sys/time.h>
@@ -11,14 +12,36 @@ static const char *TAG = "SNTP_SYNC";
 
 // SNTP operating mode set status
 static bool sntp_initialized = false;
-static bool time_synced = false;
+
+// Sync status (written from the SNTP callback and sync task, read from any task)
+typedef struct {
+    bool synced;
+    time_t last_sync;       // Epoch of the last NTP update (0 = none)
+} sync_status_t;
+
+static sync_status_t sync_status = {0};
+static snapshot_t sync_snapshot = SNAPSHOT_INIT(&sync_status, sizeof(sync_status));
+
+/**
+ * Publish sync status
+ */
+static void set_synced(time_t last_sync)
+{
+    sync_status_t status;
+    snapshot_read(&sync_snapshot, &status);
+    status.synced = true;
+    if (last_sync != 0) {
+        status.last_sync = last_sync;
+    }
+    snapshot_write(&sync_snapshot, &status);
+}
 
 /**
  * SNTP sync notification callback
  */
 static void sntp_sync_time_cb(struct timeval *tv)
 {
-    time_synced = true;
+    set_synced(tv ? tv->tv_sec : time(NULL));
     ESP_LOGI(TAG, "Time synchronized with NTP server");
 }
 
@@ -75,8 +98,8 @@ static void sntp_sync_obtain_time(void)
     }
     
     // Update sync status
-    if (timeinfo.tm_year >= (2016 - 1900)) {
-        time_synced = true;
+    if (timeinfo.tm_year >= (2016 - 1900) && !sntp_sync_is_synced()) {
+        set_synced(0);
     }
 }
 
@@ -90,7 +113,7 @@ static void sntp_sync_task(void *pvParam)
     while (1) {
         sntp_sync_obtain_time();
         
-        if (time_synced) {
+        if (sntp_sync_is_synced()) {
             // Log time every 1 hour after synced
             vTaskDelay(pdMS_TO_TICKS(3600000));
         } else {
@@ -151,7 +174,27 @@ bool sntp_sync_get_time(struct tm *timeinfo)
  */
 bool sntp_sync_is_synced(void)
 {
-    return time_synced;
+    sync_status_t status;
+    snapshot_read(&sync_snapshot, &status);
+    return status.synced;
+}
+
+/**
+ * Get time of the last NTP update
+ */
+time_t sntp_sync_get_last_sync(void)
+{
+    sync_status_t status;
+    snapshot_read(&sync_snapshot, &status);
+    return status.last_sync;
+}
+
+/**
+ * Get sync status version
+ */
+uint32_t sntp_sync_get_version(void)
+{
+    return snapshot_version(&sync_snapshot);
 }
 
 /**
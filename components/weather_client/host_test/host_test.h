@@ -0,0 +1,35 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+/*
+ * Minimal assertions for the host tests (one test file per executable).
+ * A failed CHECK prints its location and the test goes on; main() returns
+ * HOST_TEST_RESULT() so ctest sees the failure.
+ */
+
+static int host_test_checks;
+static int host_test_failures;
+
+#define CHECK(cond) do { \
+        host_test_checks++; \
+        if (!(cond)) { \
+            host_test_failures++; \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+        long long a_ = (long long)(actual), e_ = (long long)(expected); \
+        host_test_checks++; \
+        if (a_ != e_) { \
+            host_test_failures++; \
+            printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+        } \
+    } while (0)
+
+#define HOST_TEST_RESULT() \
+    (printf("%d checks, %d failed\n", host_test_checks, host_test_failures), host_test_failures ? 1 : 0)
+
+#endif // HOST_TEST_H
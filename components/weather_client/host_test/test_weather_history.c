@@ -0,0 +1,233 @@
+/*
+ * Tiered weather history (weather_history.c): ring wraparound of every tier,
+ * hourly and daily bucket rollover at hour and local midnight boundaries,
+ * incremental min/max/mean against aggregates recomputed from the samples,
+ * and range queries that span the wrap point of a ring.
+ */
+#include <stdlib.h>
+#include "host_test.h"
+#include "fixed_point.h"
+#include "weather_history.h"
+
+#define HOUR_S      3600u
+#define DAY_S       86400u
+#define DAY0_S      1771174800u     // 2026-02-16 00:00 local (WIB)
+
+#define STEP_S      (10 * 60)       // Sample spacing of the long run
+#define RUN_DAYS    40              // Long run, past every ring's capacity
+#define RUN_SAMPLES (RUN_DAYS * DAY_S / STEP_S + 20)    // No ring ends at its array end
+
+static weather_history_t history;
+static weather_history_agg_t out[WEATHER_HISTORY_MAX_POINTS];
+
+// Samples of the long run, for recomputing the aggregates
+static int16_t run_temp[RUN_SAMPLES];
+static uint16_t run_hum[RUN_SAMPLES];
+
+static uint32_t run_time(size_t i)
+{
+    return DAY0_S + (uint32_t)(i * STEP_S);
+}
+
+/**
+ * Aggregate of the run samples in [start, start + len) computed in one pass
+ */
+static weather_history_agg_t reference(uint32_t start, uint32_t len)
+{
+    weather_history_agg_t agg = { .start = start };
+    for (size_t i = 0; i < RUN_SAMPLES; i++) {
+        uint32_t t = run_time(i);
+        if (t < start || t >= start + len) {
+            continue;
+        }
+        if (agg.count == 0 || run_temp[i] < agg.temp_min) agg.temp_min = run_temp[i];
+        if (agg.count == 0 || run_temp[i] > agg.temp_max) agg.temp_max = run_temp[i];
+        if (agg.count == 0 || run_hum[i] < agg.hum_min) agg.hum_min = run_hum[i];
+        if (agg.count == 0 || run_hum[i] > agg.hum_max) agg.hum_max = run_hum[i];
+        agg.temp_sum += run_temp[i];
+        agg.hum_sum += run_hum[i];
+        agg.count++;
+    }
+    if (agg.count > 0) {
+        agg.temp_mean = (int16_t)fixed_div_round(agg.temp_sum, agg.count);
+        agg.hum_mean = (uint16_t)fixed_div_round(agg.hum_sum, agg.count);
+    }
+    return agg;
+}
+
+static void check_agg(const weather_history_agg_t *actual, const weather_history_agg_t *expected)
+{
+    CHECK_EQ(actual->start, expected->start);
+    CHECK_EQ(actual->count, expected->count);
+    CHECK_EQ(actual->temp_min, expected->temp_min);
+    CHECK_EQ(actual->temp_max, expected->temp_max);
+    CHECK_EQ(actual->temp_mean, expected->temp_mean);
+    CHECK_EQ(actual->hum_min, expected->hum_min);
+    CHECK_EQ(actual->hum_max, expected->hum_max);
+    CHECK_EQ(actual->hum_mean, expected->hum_mean);
+}
+
+static void test_buckets(void)
+{
+    weather_history_init(&history);
+
+    // Three samples in one hour, one in the next: the first hour closes
+    CHECK(weather_history_add(&history, DAY0_S + 10 * 60, 2510, 700));
+    CHECK(weather_history_add(&history, DAY0_S + 20 * 60, 2490, 720));
+    CHECK(weather_history_add(&history, DAY0_S + 59 * 60 + 59, 2503, 655));
+    size_t n = weather_history_query(&history, WEATHER_HISTORY_HOURLY, 0, UINT32_MAX, out, WEATHER_HISTORY_MAX_POINTS);
+    CHECK_EQ(n, 1);
+    CHECK_EQ(history.hourly_ring.count, 0);
+
+    CHECK(weather_history_add(&history, DAY0_S + HOUR_S, 2600, 600));
+    n = weather_history_query(&history, WEATHER_HISTORY_HOURLY, 0, UINT32_MAX, out, WEATHER_HISTORY_MAX_POINTS);
+    CHECK_EQ(n, 2);
+    CHECK_EQ(history.hourly_ring.count, 1);
+    CHECK_EQ(out[0].start, DAY0_S);
+    CHECK_EQ(out[0].count, 3);
+    CHECK_EQ(out[0].temp_min, 2490);
+    CHECK_EQ(out[0].temp_max, 2510);
+    CHECK_EQ(out[0].temp_mean, 2501);   // 7503 / 3 rounded
+    CHECK_EQ(out[0].hum_min, 655);
+    CHECK_EQ(out[0].hum_max, 720);
+    CHECK_EQ(out[0].hum_mean, 692);     // 2075 / 3 rounded
+    CHECK_EQ(out[1].start, DAY0_S + HOUR_S);
+    CHECK_EQ(out[1].count, 1);
+
+    // Negative temperatures round away from zero like the sums they come from
+    weather_history_init(&history);
+    weather_history_add(&history, DAY0_S, -5, 0);
+    weather_history_add(&history, DAY0_S + 1, -10, 1);
+    n = weather_history_query(&history, WEATHER_HISTORY_HOURLY, 0, UINT32_MAX, out, WEATHER_HISTORY_MAX_POINTS);
+    CHECK_EQ(n, 1);
+    CHECK_EQ(out[0].temp_mean, -8);
+    CHECK_EQ(out[0].hum_mean, 1);
+
+    // Local midnight, not UTC midnight, starts a day
+    weather_history_init(&history);
+    weather_history_add(&history, DAY0_S - 1, 2800, 500);
+    weather_history_add(&history, DAY0_S + DAY_S - 1, 2400, 800);
+    weather_history_add(&history, DAY0_S + DAY_S, 2300, 900);
+    n = weather_history_query(&history, WEATHER_HISTORY_DAILY, 0, UINT32_MAX, out, WEATHER_HISTORY_MAX_POINTS);
+    CHECK_EQ(n, 3);
+    CHECK_EQ(out[0].start, DAY0_S - DAY_S);
+    CHECK_EQ(out[0].count, 1);
+    CHECK_EQ(out[1].start, DAY0_S);
+    CHECK_EQ(out[1].count, 1);
+    CHECK_EQ(out[2].start, DAY0_S + DAY_S);
+
+    // A sample older than the last one is dropped, an equal one is kept
+    CHECK(!weather_history_add(&history, DAY0_S, 2000, 500));
+    CHECK(weather_history_add(&history, DAY0_S + DAY_S, 2100, 500));
+    n = weather_history_query(&history, WEATHER_HISTORY_RAW, 0, UINT32_MAX, out, WEATHER_HISTORY_MAX_POINTS);
+    CHECK_EQ(n, 4);
+
+    // A gap of several hours closes one bucket, it does not invent empty ones
+    weather_history_init(&history);
+    weather_history_add(&history, DAY0_S, 2000, 500);
+    weather_history_add(&history, DAY0_S + 5 * HOUR_S, 2000, 500);
+    n = weather_history_query(&history, WEATHER_HISTORY_HOURLY, 0, UINT32_MAX, out, WEATHER_HISTORY_MAX_POINTS);
+    CHECK_EQ(n, 2);
+    CHECK_EQ(out[1].start - out[0].start, 5 * HOUR_S);
+}
+
+/**
+ * Check a tier after the long run: full ring plus the open bucket, oldest
+ * first, each bucket equal to the one recomputed from the samples
+ */
+static void check_tier(weather_history_tier_t tier, uint32_t len, uint16_t slots)
+{
+    uint32_t last = run_time(RUN_SAMPLES - 1);
+    uint32_t open_start = DAY0_S + (last - DAY0_S) / len * len;
+    uint32_t first_start = open_start - slots * len;
+
+    size_t n = weather_history_query(&history, tier, 0, UINT32_MAX, out, WEATHER_HISTORY_MAX_POINTS);
+    CHECK_EQ(n, slots + 1u);
+    for (size_t i = 0; i < n; i++) {
+        weather_history_agg_t expected = reference(first_start + (uint32_t)i * len, len);
+        check_agg(&out[i], &expected);
+    }
+
+    // Range across the wrap point: the oldest slot sits at the ring head,
+    // so the last slot of the array and slot 0 are consecutive buckets
+    const weather_history_ring_t *ring = (tier == WEATHER_HISTORY_HOURLY) ? &history.hourly_ring
+                                                                           : &history.daily_ring;
+    CHECK(ring->head != 0);
+    uint32_t wrap_start = first_start + (uint32_t)(slots - ring->head - 1) * len;
+    n = weather_history_query(&history, tier, wrap_start - len, wrap_start + 2 * len,
+                              out, WEATHER_HISTORY_MAX_POINTS);
+    CHECK_EQ(n, 4);
+    for (size_t i = 0; i < n; i++) {
+        CHECK_EQ(out[i].start, wrap_start + (uint32_t)(i - 1) * len);
+    }
+
+    // Buckets are selected by their start, bounds inclusive
+    n = weather_history_query(&history, tier, wrap_start + 1, wrap_start + len, out, WEATHER_HISTORY_MAX_POINTS);
+    CHECK_EQ(n, 1);
+    CHECK_EQ(out[0].start, wrap_start + len);
+
+    // Capacity of out caps the result, oldest kept
+    n = weather_history_query(&history, tier, 0, UINT32_MAX, out, 3);
+    CHECK_EQ(n, 3);
+    CHECK_EQ(out[0].start, first_start);
+}
+
+static void test_long_run(void)
+{
+    uint32_t seed = 12345;
+    weather_history_init(&history);
+    for (size_t i = 0; i < RUN_SAMPLES; i++) {
+        seed = seed * 1103515245u + 12345u;
+        run_temp[i] = (int16_t)((int)(seed >> 16) % 6001 - 1000);   // -10.00 .. 50.00 °C
+        seed = seed * 1103515245u + 12345u;
+        run_hum[i] = (uint16_t)((seed >> 16) % 1001);               // 0.0 .. 100.0 %
+        CHECK(weather_history_add(&history, run_time(i), run_temp[i], run_hum[i]));
+    }
+
+    // Raw: the last samples only, oldest first, also across the wrap point
+    size_t n = weather_history_query(&history, WEATHER_HISTORY_RAW, 0, UINT32_MAX, out, WEATHER_HISTORY_MAX_POINTS);
+    CHECK_EQ(n, WEATHER_HISTORY_RAW_SAMPLES);
+    size_t first = RUN_SAMPLES - WEATHER_HISTORY_RAW_SAMPLES;
+    for (size_t i = 0; i < n; i++) {
+        CHECK_EQ(out[i].start, run_time(first + i));
+        CHECK_EQ(out[i].temp_mean, run_temp[first + i]);
+        CHECK_EQ(out[i].hum_mean, run_hum[first + i]);
+        CHECK_EQ(out[i].count, 1);
+    }
+
+    size_t wrap = first + (WEATHER_HISTORY_RAW_SAMPLES - history.raw_ring.head) - 1;
+    CHECK(history.raw_ring.head != 0);
+    n = weather_history_query(&history, WEATHER_HISTORY_RAW, run_time(wrap - 2), run_time(wrap + 3),
+                              out, WEATHER_HISTORY_MAX_POINTS);
+    CHECK_EQ(n, 6);
+    for (size_t i = 0; i < n; i++) {
+        CHECK_EQ(out[i].start, run_time(wrap - 2 + i));
+    }
+
+    check_tier(WEATHER_HISTORY_HOURLY, HOUR_S, WEATHER_HISTORY_HOURLY_SLOTS);
+    check_tier(WEATHER_HISTORY_DAILY, DAY_S, WEATHER_HISTORY_DAILY_SLOTS);
+
+    // Nothing in range
+    n = weather_history_query(&history, WEATHER_HISTORY_DAILY, 0, DAY0_S, out, WEATHER_HISTORY_MAX_POINTS);
+    CHECK_EQ(n, 0);
+}
+
+static void test_tier_names(void)
+{
+    weather_history_tier_t tier;
+    for (int i = 0; i < WEATHER_HISTORY_TIER_COUNT; i++) {
+        CHECK(weather_history_tier_from_str(weather_history_tier_str((weather_history_tier_t)i), &tier));
+        CHECK_EQ(tier, i);
+    }
+    CHECK(weather_history_tier_from_str("Hourly", &tier));
+    CHECK_EQ(tier, WEATHER_HISTORY_HOURLY);
+    CHECK(!weather_history_tier_from_str("weekly", &tier));
+}
+
+int main(void)
+{
+    test_buckets();
+    test_long_run();
+    test_tier_names();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,357 @@
+/*
+ * Streaming JSON parser (weather_json.c) and the Open-Meteo decoder
+ * (weather_openmeteo.c) on response bodies in the shape the API returns for
+ * our query, single-location and batch. Every split of a body into chunks
+ * must decode to the same result as the whole body. The FlatBuffers body
+ * (tools/weather_fb_encode.py of the batch body) must decode like the JSON.
+ */
+#include "host_test.h"
+#include "weather_json.h"
+#include "weather_provider.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RANDOM_SPLITS       500
+#define RANDOM_CHUNK_MAX    64
+
+static uint32_t rng = 12345;
+
+/**
+ * Deterministic random numbers (xorshift32), so failures reproduce
+ */
+static uint32_t next_random(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static char *read_body(const char *name, size_t *len)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", TEST_DATA_DIR, name);
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        printf("cannot open %s\n", path);
+        exit(1);
+    }
+    fseek(f, 0, SEEK_END);
+    *len = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *body = malloc(*len);
+    if (body == NULL || fread(body, 1, *len, f) != *len) {
+        exit(1);
+    }
+    fclose(f);
+    return body;
+}
+
+/**
+ * Decode a body of either format fed in chunks of the given sizes (cycled)
+ * @return result of finish(), false if a feed failed
+ */
+static bool decode_format(weather_decoder_t *decoder, bool flatbuffers, const char *body, size_t len,
+                          const size_t *chunks, size_t chunk_count)
+{
+    const weather_provider_t *provider = &weather_provider_open_meteo;
+    weather_open_meteo_begin(decoder, flatbuffers);
+
+    size_t pos = 0;
+    for (size_t i = 0; pos < len; i++) {
+        size_t n = chunks[i % chunk_count];
+        if (n > len - pos) {
+            n = len - pos;
+        }
+        if (!provider->feed(decoder, body + pos, n)) {
+            return false;
+        }
+        pos += n;
+    }
+    return provider->finish(decoder);
+}
+
+static bool decode(weather_decoder_t *decoder, const char *body, size_t len, const size_t *chunks, size_t chunk_count)
+{
+    return decode_format(decoder, false, body, len, chunks, chunk_count);
+}
+
+static void test_whole_body(void)
+{
+    static weather_decoder_t decoder;
+    size_t len;
+    char *body = read_body("open_meteo_single.json", &len);
+
+    CHECK(decode(&decoder, body, len, &len, 1));
+    weather_result_t *result = &decoder.result;
+    CHECK_EQ(result->fields[0], (1u << WEATHER_FIELD_COUNT) - 1);
+    CHECK_EQ(result->current[0].temperature, 2740);
+    CHECK_EQ(result->current[0].humidity, 840);
+    CHECK_EQ(result->forecast[0].start, 1771254000);
+    for (int column = 0; column < WEATHER_HOURLY_COLUMNS; column++) {
+        CHECK_EQ(result->hourly_len[0][column], WEATHER_FORECAST_SLOTS);
+    }
+    CHECK_EQ(result->forecast[0].temperature[0], 2790);
+    CHECK_EQ(result->forecast[0].temperature[12], 2750);
+    CHECK_EQ(result->forecast[0].humidity[12], 850);
+    CHECK_EQ(result->fields[1], 0);
+    free(body);
+
+    // Batch body: one array element per station, larger than the old 2 KB buffer
+    body = read_body("open_meteo_batch.json", &len);
+    CHECK(len > 2048);
+    CHECK(decode(&decoder, body, len, &len, 1));
+    CHECK_EQ(result->current[0].temperature, 2740);
+    CHECK_EQ(result->current[1].temperature, 2210);
+    CHECK_EQ(result->current[1].humidity, 910);
+    CHECK_EQ(result->current[2].temperature, 2890);
+    CHECK_EQ(result->current[2].humidity, 760);
+    for (int station = 0; station < 3; station++) {
+        CHECK_EQ(result->fields[station], (1u << WEATHER_FIELD_COUNT) - 1);
+        CHECK_EQ(result->hourly_len[station][WEATHER_HOURLY_TIME], WEATHER_FORECAST_SLOTS);
+    }
+    CHECK_EQ(result->forecast[2].temperature[6], 2740);
+    CHECK_EQ(result->forecast[1].humidity[10], 970);
+    free(body);
+}
+
+/**
+ * Byte by byte and random splits decode exactly like the whole body
+ */
+static void test_splits(const char *name)
+{
+    static weather_decoder_t whole;
+    static weather_decoder_t split;
+    size_t len;
+    char *body = read_body(name, &len);
+    CHECK(decode(&whole, body, len, &len, 1));
+
+    size_t one = 1;
+    CHECK(decode(&split, body, len, &one, 1));
+    CHECK(memcmp(&split.result, &whole.result, sizeof(whole.result)) == 0);
+
+    for (int i = 0; i < RANDOM_SPLITS; i++) {
+        size_t chunks[16];
+        for (size_t c = 0; c < 16; c++) {
+            chunks[c] = 1 + next_random() % RANDOM_CHUNK_MAX;
+        }
+        bool ok = decode(&split, body, len, chunks, 16);
+        CHECK(ok);
+        CHECK(memcmp(&split.result, &whole.result, sizeof(whole.result)) == 0);
+        if (!ok) {
+            break;
+        }
+    }
+
+    // One split point anywhere in the body
+    for (size_t at = 1; at < len; at++) {
+        size_t chunks[2] = {at, len - at};
+        CHECK(decode(&split, body, len, chunks, 2));
+        CHECK(memcmp(&split.result, &whole.result, sizeof(whole.result)) == 0);
+    }
+    free(body);
+}
+
+/**
+ * A body cut anywhere before its closing bracket is not complete
+ */
+static void test_truncated(const char *name)
+{
+    static weather_decoder_t decoder;
+    size_t len;
+    char *body = read_body(name, &len);
+
+    int complete = 0;
+    for (size_t cut = 0; cut < len; cut++) {
+        size_t chunk = cut ? cut : 1;
+        if (cut == 0) {
+            weather_provider_open_meteo.begin(&decoder);
+            complete += weather_provider_open_meteo.finish(&decoder);
+            continue;
+        }
+        complete += decode(&decoder, body, cut, &chunk, 1);
+    }
+    CHECK_EQ(complete, 0);
+    free(body);
+}
+
+static void test_trailing_garbage(void)
+{
+    static weather_decoder_t decoder;
+    size_t len;
+    char *body = read_body("open_meteo_single.json", &len);
+    static const char *const tails[] = {"x", "}", "]", ",", "{}", "1", "\"a\""};
+
+    char *longer = malloc(len + 8);
+    for (size_t i = 0; i < sizeof(tails) / sizeof(tails[0]); i++) {
+        size_t n = strlen(tails[i]);
+        memcpy(longer, body, len);
+        memcpy(longer + len, tails[i], n);
+        size_t total = len + n;
+        CHECK(!decode(&decoder, longer, total, &total, 1));
+    }
+
+    // Whitespace after the value is fine
+    memcpy(longer, body, len);
+    memcpy(longer + len, " \r\n", 3);
+    size_t total = len + 3;
+    CHECK(decode(&decoder, longer, total, &total, 1));
+    free(longer);
+    free(body);
+}
+
+/**
+ * FlatBuffers stream of the batch body decodes to the same result, however split
+ */
+static void test_flatbuffers(void)
+{
+    static weather_decoder_t json;
+    static weather_decoder_t fb;
+    size_t json_len;
+    size_t len;
+    char *json_body = read_body("open_meteo_batch.json", &json_len);
+    char *body = read_body("open_meteo_batch.fb", &len);
+
+    CHECK(decode(&json, json_body, json_len, &json_len, 1));
+    CHECK(decode_format(&fb, true, body, len, &len, 1));
+    CHECK(memcmp(&fb.result, &json.result, sizeof(json.result)) == 0);
+
+    size_t one = 1;
+    CHECK(decode_format(&fb, true, body, len, &one, 1));
+    CHECK(memcmp(&fb.result, &json.result, sizeof(json.result)) == 0);
+    for (size_t at = 1; at < len; at++) {
+        size_t chunks[2] = {at, len - at};
+        CHECK(decode_format(&fb, true, body, len, chunks, 2));
+        CHECK(memcmp(&fb.result, &json.result, sizeof(json.result)) == 0);
+    }
+
+    // Only a cut on a message boundary is complete: one per station
+    int complete = 0;
+    for (size_t cut = 1; cut < len; cut++) {
+        complete += decode_format(&fb, true, body, cut, &cut, 1);
+    }
+    CHECK_EQ(complete, 2);
+
+    // A size prefix beyond WEATHER_FB_MAX_MESSAGE_LEN is rejected
+    static const char huge[] = {0x01, 0x10, 0x00, 0x00};
+    size_t huge_len = sizeof(huge);
+    CHECK(!decode_format(&fb, true, huge, huge_len, &huge_len, 1));
+    free(body);
+    free(json_body);
+}
+
+static void count_value(const weather_json_parser_t *parser, weather_json_type_t type,
+                        const char *value, size_t len, void *ctx)
+{
+    (*(int *)ctx)++;
+}
+
+static bool parse(const char *text, int *values)
+{
+    weather_json_parser_t parser;
+    *values = 0;
+    weather_json_init(&parser, count_value, values);
+    return weather_json_feed(&parser, text, strlen(text)) && weather_json_finish(&parser);
+}
+
+static void test_depth(void)
+{
+    char text[2 * WEATHER_JSON_MAX_DEPTH + 8];
+    int values;
+
+    // Deepest allowed nesting
+    memset(text, '[', WEATHER_JSON_MAX_DEPTH);
+    text[WEATHER_JSON_MAX_DEPTH] = '1';
+    memset(text + WEATHER_JSON_MAX_DEPTH + 1, ']', WEATHER_JSON_MAX_DEPTH);
+    text[2 * WEATHER_JSON_MAX_DEPTH + 1] = '\0';
+    CHECK(parse(text, &values));
+    CHECK_EQ(values, 1);
+
+    // One level more fails, without writing past the frame stack
+    memset(text, '[', WEATHER_JSON_MAX_DEPTH + 1);
+    text[WEATHER_JSON_MAX_DEPTH + 1] = '\0';
+    CHECK(!parse(text, &values));
+    CHECK(!parse("{\"a\":{\"b\":{\"c\":{\"d\":{\"e\":{\"f\":{\"g\":{\"h\":{}}}}}}}}}", &values));
+
+    // The parser stays in its error state
+    weather_json_parser_t parser;
+    weather_json_init(&parser, count_value, &values);
+    CHECK(!weather_json_feed(&parser, text, strlen(text)));
+    CHECK(!weather_json_feed(&parser, "1", 1));
+    CHECK(!weather_json_finish(&parser));
+}
+
+static void test_syntax(void)
+{
+    int values;
+    CHECK(parse("{\"a\":[1,-2.5e3,true,false,null,\"s\\\"\\u00b0\"]}", &values));
+    CHECK_EQ(values, 6);
+    CHECK(parse(" 42 ", &values));
+    CHECK_EQ(values, 1);
+
+    // Values longer than WEATHER_JSON_MAX_TOKEN_LEN are skipped, not truncated
+    CHECK(parse("{\"long\":\"0123456789012345678901234567890123456789\",\"n\":1}", &values));
+    CHECK_EQ(values, 1);
+
+    static const char *const bad[] = {
+        "", "{", "{\"a\"}", "{\"a\":}", "{\"a\":1,}", "[1,]", "[1 2]", "{1:2}", "[tru]", "[nul1]",
+        "{\"a\":1]", "[1}", "\"unterminated", "[\"ctrl\x01\"]",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        bool ok = parse(bad[i], &values);
+        if (ok) {
+            printf("accepted: %s\n", bad[i]);
+        }
+        CHECK(!ok);
+    }
+}
+
+// Last value matched by the pattern passed as ctx, "" for none
+static char matched[WEATHER_JSON_MAX_TOKEN_LEN + 1];
+
+static void match_value(const weather_json_parser_t *parser, weather_json_type_t type,
+                        const char *value, size_t len, void *ctx)
+{
+    if (weather_json_match(parser, (const char *)ctx)) {
+        memcpy(matched, value, len + 1);
+    }
+}
+
+static void test_match(void)
+{
+    static const char text[] = "[{\"current\":{\"t\":1,\"x\":{\"t\":2}}},{\"current\":{\"t\":3}}]";
+    static const struct {
+        const char *pattern;
+        const char *value;      // Last value matched, "" for none
+    } cases[] = {
+        {"[].current.t", "3"},
+        {"[].current.x.t", "2"},
+        {"current.t", ""},
+        {"[].current", ""},
+        {"[].cur.t", ""},
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        weather_json_parser_t parser;
+        matched[0] = '\0';
+        weather_json_init(&parser, match_value, (void *)cases[i].pattern);
+        CHECK(weather_json_feed(&parser, text, sizeof(text) - 1));
+        CHECK(weather_json_finish(&parser));
+        CHECK(strcmp(matched, cases[i].value) == 0);
+    }
+}
+
+int main(void)
+{
+    test_whole_body();
+    test_splits("open_meteo_single.json");
+    test_splits("open_meteo_batch.json");
+    test_truncated("open_meteo_single.json");
+    test_truncated("open_meteo_batch.json");
+    test_trailing_garbage();
+    test_flatbuffers();
+    test_depth();
+    test_syntax();
+    test_match();
+    return HOST_TEST_RESULT();
+}
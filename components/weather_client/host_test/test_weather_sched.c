@@ -0,0 +1,225 @@
+/*
+ * Fetch scheduler (weather_sched.c) on a simulated clock, with the firmware's
+ * configuration: backoff growth and jitter bounds, the max_age clamp before
+ * and after the cached forecast runs out, trigger collapsing and deadline
+ * merging, and alignment of regular fetches to the model update.
+ */
+#include "host_test.h"
+#include "weather_sched.h"
+
+#define HOUR_MS     3600000LL
+#define WALL_S      1771250000LL    // 2026-02-16 13:53:20 UTC
+
+static const weather_sched_config_t firmware_config = {
+    .fetch_interval_ms = 6 * HOUR_MS,
+    .sample_interval_ms = HOUR_MS,
+    .align_period_s = 3600,
+    .align_delay_s = 600,
+    .backoff_min_ms = 5000,
+    .backoff_max_ms = 1800000,
+    .max_age_ms = 11 * HOUR_MS,
+    .trigger_spacing_ms = 10000,
+};
+
+/**
+ * Delay the scheduler picks after a failed fetch at now_ms
+ */
+static int64_t fail_at(weather_sched_t *sched, int64_t now_ms)
+{
+    weather_sched_fetch_done(sched, now_ms, 0, false);
+    return sched->next_fetch_ms - now_ms;
+}
+
+static void test_backoff(void)
+{
+    weather_sched_config_t config = firmware_config;
+    config.max_age_ms = 0;
+
+    for (uint32_t seed = 1; seed <= 50; seed++) {
+        weather_sched_t sched;
+        weather_sched_init(&sched, &config, 0, seed);
+
+        int64_t now_ms = 0;
+        int64_t base_ms = config.backoff_min_ms;
+        for (int i = 1; i <= 20; i++) {
+            int64_t delay_ms = fail_at(&sched, now_ms);
+            // Half fixed, half jitter
+            CHECK(delay_ms >= base_ms / 2);
+            CHECK(delay_ms <= base_ms);
+            CHECK_EQ(sched.failures, i);
+            now_ms += delay_ms;
+            base_ms = (base_ms * 2 > config.backoff_max_ms) ? config.backoff_max_ms : base_ms * 2;
+        }
+        CHECK_EQ(base_ms, config.backoff_max_ms);
+
+        // A success resets the backoff
+        weather_sched_fetch_done(&sched, now_ms, 0, true);
+        CHECK_EQ(sched.failures, 0);
+        CHECK(fail_at(&sched, now_ms) <= config.backoff_min_ms);
+    }
+
+    // Jitter spreads devices that fail together
+    weather_sched_t a;
+    weather_sched_t b;
+    weather_sched_init(&a, &config, 0, 1);
+    weather_sched_init(&b, &config, 0, 2);
+    for (int i = 0; i < 8; i++) {
+        fail_at(&a, 0);
+        fail_at(&b, 0);
+    }
+    CHECK(a.next_fetch_ms != b.next_fetch_ms);
+}
+
+/**
+ * Run a 24 hour outage starting at outage_ms, from the scheduler's point of view
+ * @return fetch attempts made
+ */
+static int run_outage(weather_sched_t *sched, int64_t outage_ms, int64_t *last_delay_ms)
+{
+    int attempts = 0;
+    int64_t now_ms = outage_ms;
+    while (now_ms < outage_ms + 24 * HOUR_MS) {
+        uint32_t wait_ms;
+        weather_sched_action_t action = weather_sched_next(sched, now_ms, &wait_ms);
+        if (action == WEATHER_SCHED_WAIT) {
+            now_ms += wait_ms;
+        } else if (action == WEATHER_SCHED_SAMPLE) {
+            weather_sched_sample_done(sched, now_ms);
+        } else {
+            attempts++;
+            *last_delay_ms = fail_at(sched, now_ms);
+        }
+    }
+    return attempts;
+}
+
+static void test_max_age(void)
+{
+    const int64_t max_age_ms = firmware_config.max_age_ms;
+    weather_sched_t sched;
+    weather_sched_init(&sched, &firmware_config, 0, 7);
+    weather_sched_fetch_done(&sched, 0, 0, true);
+
+    // While the cache is still good, no retry lands past its end
+    int64_t now_ms = max_age_ms - HOUR_MS;
+    for (int i = 0; i < 10; i++) {
+        fail_at(&sched, now_ms);
+        CHECK(sched.next_fetch_ms <= max_age_ms);
+    }
+    // ...but never closer than the minimum delay
+    now_ms = max_age_ms - 1000;
+    CHECK(fail_at(&sched, now_ms) >= firmware_config.backoff_min_ms);
+
+    // Past the deadline the backoff keeps growing instead of restarting at 5 s
+    now_ms = max_age_ms + 1000;
+    int64_t delay_ms = fail_at(&sched, now_ms);
+    CHECK(delay_ms >= firmware_config.backoff_max_ms / 2);
+
+    // A day-long outage from a fresh success costs a bounded number of attempts:
+    // the cap (30 min, half jitter) allows at most 96 per day plus the ramp-up
+    weather_sched_init(&sched, &firmware_config, 0, 11);
+    weather_sched_fetch_done(&sched, 0, WALL_S, true);
+    int64_t last_delay_ms = 0;
+    int attempts = run_outage(&sched, 0, &last_delay_ms);
+    printf("24 h outage: %d fetch attempts, last delay %lld s\n", attempts, (long long)(last_delay_ms / 1000));
+    CHECK(attempts > 24);
+    CHECK(attempts < 120);
+    CHECK(last_delay_ms >= firmware_config.backoff_max_ms / 2);
+
+    // Outage that starts without any success yet: plain backoff
+    weather_sched_init(&sched, &firmware_config, 0, 13);
+    attempts = run_outage(&sched, 0, &last_delay_ms);
+    CHECK(attempts < 120);
+}
+
+static void test_collapse(void)
+{
+    const int64_t spacing_ms = firmware_config.trigger_spacing_ms;
+    weather_sched_t sched;
+    weather_sched_init(&sched, &firmware_config, 0, 3);
+    weather_sched_fetch_done(&sched, 1000, 0, true);
+    int64_t regular_ms = sched.next_fetch_ms;
+
+    // Right after a success: served by its data, nothing scheduled
+    weather_sched_request(&sched, 1000, 1000);
+    weather_sched_request(&sched, 1000 + spacing_ms - 1, 1000 + spacing_ms - 1);
+    CHECK_EQ(sched.triggers, 2);
+    CHECK_EQ(sched.collapsed, 2);
+    CHECK_EQ(sched.next_fetch_ms, regular_ms);
+
+    // Later: fetch now
+    int64_t now_ms = 1000 + spacing_ms;
+    weather_sched_request(&sched, now_ms, now_ms);
+    CHECK_EQ(sched.collapsed, 2);
+    CHECK_EQ(sched.next_fetch_ms, now_ms);
+
+    // Requests while that fetch is pending merge into it
+    weather_sched_request(&sched, now_ms + 1, now_ms + 1);
+    weather_sched_request(&sched, now_ms + 1, now_ms + HOUR_MS);
+    CHECK_EQ(sched.collapsed, 4);
+    CHECK_EQ(sched.next_fetch_ms, now_ms);
+
+    // Earliest deadline wins
+    weather_sched_init(&sched, &firmware_config, 0, 3);
+    weather_sched_fetch_done(&sched, 0, 0, true);
+    weather_sched_request(&sched, HOUR_MS, 3 * HOUR_MS);
+    CHECK_EQ(sched.next_fetch_ms, 3 * HOUR_MS);
+    weather_sched_request(&sched, HOUR_MS, 2 * HOUR_MS);
+    CHECK_EQ(sched.next_fetch_ms, 2 * HOUR_MS);
+    CHECK_EQ(sched.collapsed, 0);
+
+    // Right after a failure: not collapsed, but spaced from the failed attempt
+    weather_sched_config_t config = firmware_config;
+    config.backoff_min_ms = 60000;
+    weather_sched_init(&sched, &config, 0, 3);
+    weather_sched_fetch_done(&sched, 5000, 0, false);
+    weather_sched_request(&sched, 6000, 6000);
+    CHECK_EQ(sched.collapsed, 0);
+    CHECK_EQ(sched.next_fetch_ms, 5000 + spacing_ms);
+
+    // A failure after an earlier success is still a failure
+    weather_sched_init(&sched, &config, 0, 3);
+    weather_sched_fetch_done(&sched, 0, 0, true);
+    weather_sched_fetch_done(&sched, HOUR_MS, 0, false);
+    weather_sched_request(&sched, HOUR_MS + 1, HOUR_MS + 1);
+    CHECK_EQ(sched.collapsed, 0);
+    CHECK_EQ(sched.next_fetch_ms, HOUR_MS + spacing_ms);
+}
+
+static void test_alignment(void)
+{
+    weather_sched_t sched;
+    weather_sched_init(&sched, &firmware_config, 0, 5);
+
+    // With wall time: the last hh:10 within the interval
+    for (int64_t offset_s = 0; offset_s < 3600; offset_s += 60) {
+        int64_t wall_s = WALL_S + offset_s;
+        weather_sched_fetch_done(&sched, 1000, wall_s, true);
+        int64_t next_wall_s = wall_s + (sched.next_fetch_ms - 1000) / 1000;
+        CHECK_EQ(next_wall_s % 3600, 600);
+        CHECK(next_wall_s <= wall_s + 6 * 3600);
+        CHECK(next_wall_s > wall_s + 5 * 3600);
+    }
+
+    // Without wall time: plain interval
+    weather_sched_fetch_done(&sched, 1000, 0, true);
+    CHECK_EQ(sched.next_fetch_ms, 1000 + 6 * HOUR_MS);
+
+    // Samples every hour between fetches
+    uint32_t wait_ms;
+    CHECK_EQ(weather_sched_next(&sched, 1000, &wait_ms), WEATHER_SCHED_WAIT);
+    CHECK_EQ(wait_ms, HOUR_MS);
+    CHECK_EQ(weather_sched_next(&sched, 1000 + HOUR_MS, &wait_ms), WEATHER_SCHED_SAMPLE);
+    weather_sched_sample_done(&sched, 1000 + HOUR_MS);
+    CHECK_EQ(sched.next_sample_ms, 1000 + 2 * HOUR_MS);
+    CHECK_EQ(weather_sched_next(&sched, 1000 + 6 * HOUR_MS, &wait_ms), WEATHER_SCHED_FETCH);
+}
+
+int main(void)
+{
+    test_backoff();
+    test_max_age();
+    test_collapse();
+    test_alignment();
+    return HOST_TEST_RESULT();
+}
@@ -2,28 +2,145 @@
 #define WEATHER_CLIENT_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <time.h>
+#include "weather_history.h"
+#include "weather_metrics.h"
+#include "weather_trace.h"
 
 // Weather data structure
 typedef struct {
-    float temperature;      // Temperature in Celsius
-    int humidity;          // Relative humidity in %
+    int16_t temperature;   // Temperature in 0.01 °C (see fixed_point.h)
+    uint16_t humidity;     // Relative humidity in 0.1 %
     time_t last_update;    // Timestamp of last update
     bool is_valid;         // Data validity flag
+    bool is_interpolated;  // Values interpolated from the hourly forecast for the current time
+    int16_t dew_point;              // 0.01 °C, derived from temperature and humidity
+    int16_t heat_index;             // 0.01 °C (NOAA)
+    int16_t apparent_temperature;   // 0.01 °C (Steadman, calm air)
+    weather_window_stats_t window_1h;   // Recorded samples of the hour up to the last sample
+    weather_window_stats_t window_24h;  // Recorded samples of the 24 hours up to the last sample
 } weather_data_t;
 
+// How the connection for a fetch was obtained
+typedef enum {
+    WEATHER_CONN_NONE = 0,      // Failed before a connection was made
+    WEATHER_CONN_REUSED,        // Kept-alive connection, no handshake
+    WEATHER_CONN_RESUMED,       // New connection, server resumed the cached TLS session (no certificate sent)
+    WEATHER_CONN_FULL           // New connection, full TLS handshake
+} weather_conn_type_t;
+
+// Trust anchors a connection is verified against
+typedef enum {
+    WEATHER_TLS_TRUST_BUNDLE = 0,   // Full certificate bundle (esp_crt_bundle)
+    WEATHER_TLS_TRUST_PINNED,       // Pinned roots and SPKI hashes (see weather_tls.h)
+    WEATHER_TLS_TRUST_COUNT
+} weather_tls_trust_t;
+
+// Full handshakes of one trust mode
+typedef struct {
+    uint32_t handshakes;            // Successful full handshakes
+    uint32_t avg_handshake_ms;      // Mean TCP connect + TLS handshake time
+    uint32_t max_handshake_ms;
+    uint32_t peak_heap_bytes;       // Largest heap drop over a request with a full handshake
+} weather_tls_stats_t;
+
+// Fetch statistics
+typedef struct {
+    uint32_t fetch_count;           // Fetch attempts
+    uint32_t success_count;         // Fetches that produced valid data
+    uint32_t failure_count;         // Fetches that failed
+    uint32_t reused_count;          // Fetches on a kept-alive connection
+    uint32_t resumed_count;         // Fetches with TLS session resumption
+    uint32_t full_handshake_count;  // Fetches with a full TLS handshake
+    uint32_t consecutive_failures;  // Failures since the last success (drives backoff)
+    uint32_t triggers;              // Fetch-now requests
+    uint32_t collapsed_triggers;    // Requests served by an already scheduled fetch
+    uint32_t next_fetch_in_s;       // Time until the next scheduled fetch
+    weather_conn_type_t last_conn_type;
+    uint32_t last_fetch_ms;         // Duration of the last fetch
+    uint32_t last_body_bytes;       // Response body size of the last fetch
+    uint32_t last_decode_us;        // Time spent decoding the last response body
+    uint32_t hedged_count;          // Fetches where the primary was slow and the secondary was started
+    uint32_t failover_count;        // Fetches where the primary failed and the secondary was started
+    uint32_t secondary_wins;        // Fetches answered by the secondary
+    uint8_t last_endpoint;          // Endpoint that answered the last fetch (0 = primary)
+    uint32_t timeout_ms;            // Current request timeout of the primary
+    uint32_t hedge_delay_ms;        // Current hedge delay (0 = no latency data yet, failover only)
+    weather_tls_trust_t tls_trust;  // Trust mode of the primary connection
+    uint32_t tls_fallbacks;         // Chains not covered by the pinned anchors, retried with the bundle
+    weather_tls_stats_t tls[WEATHER_TLS_TRUST_COUNT];
+} weather_fetch_stats_t;
+
 // Configuration
-#define WEATHER_FETCH_INTERVAL_MS   (3600000)  // 1 hour in milliseconds
-#define WEATHER_RETRY_INTERVAL_MS   (60000)    // 1 minute retry on failure
+#define WEATHER_FETCH_INTERVAL_MS   (21600000) // 6 hours in milliseconds
+#define WEATHER_SAMPLE_INTERVAL_MS  (3600000)  // 1 hour, forecast values recorded between fetches
+#define WEATHER_FORECAST_HOURS      12         // Hours of hourly forecast cached per fetch
+
+// Fetch scheduling
+#define WEATHER_MODEL_UPDATE_PERIOD_S   3600        // Provider model update cadence (0 = no alignment)
+#define WEATHER_MODEL_UPDATE_DELAY_S    600         // Fetch 10 minutes after a model update
+#define WEATHER_BACKOFF_MIN_MS          (5000)      // First retry after a failure
+#define WEATHER_BACKOFF_MAX_MS          (1800000)   // Retry delay cap (30 minutes)
+#define WEATHER_TRIGGER_SPACING_MS      (10000)     // Fetch-now requests within this time of a fetch are merged
+
+// Weather stations: X(name, latitude, longitude), fetched together in one request.
+// The first entry is the primary station shown on the dashboard.
+#define WEATHER_STATIONS(X) \
+    X("Jakarta",    "-6.1818",  "106.8223") \
+    X("Bandung",    "-6.9175",  "107.6191") \
+    X("Surabaya",   "-7.2575",  "112.7521")
+
+#define WEATHER_MAX_STATIONS        24      // Station table capacity
+#define WEATHER_HISTORY_MAX_STATIONS 4      // History is kept for the first N stations
+
+// API endpoints (coordinate lists are appended at init). The secondary serves
+// hedged requests and failover: a mirror or self-hosted Open-Meteo instance,
+// or the same URL for a second independent connection.
+#define WEATHER_API_BASE_URL        "https://api.open-meteo.com/v1/forecast"
+#define WEATHER_API_SECONDARY_URL   "https://api.open-meteo.com/v1/forecast"
+// Same variable list for current and hourly values (forecast_hours is appended at init)
+#define WEATHER_API_VARIABLES       "temperature_2m,relative_humidity_2m"
+#define WEATHER_API_QUERY           "&current=" WEATHER_API_VARIABLES "&hourly=" WEATHER_API_VARIABLES \
+                                    "&timeformat=unixtime&past_hours=1"
+#define WEATHER_API_URL_MAX_LEN     1024
+
+// Response format: 0 = JSON (streaming parser), 1 = FlatBuffers (values read in place)
+#define WEATHER_API_USE_FLATBUFFERS 0
+#define WEATHER_API_FORMAT_NAME     (WEATHER_API_USE_FLATBUFFERS ? "flatbuffers" : "json")
+
+// Request timeouts follow the observed latency of each endpoint (see weather_rtt.h)
+#define WEATHER_TIMEOUT_INITIAL_MS  (10000)     // Until the first answer
+#define WEATHER_TIMEOUT_MIN_MS      (2000)
+#define WEATHER_TIMEOUT_MAX_MS      (20000)
+#define WEATHER_FETCH_DEADLINE_MS   (45000)     // A fetch gives up after this long
+
+// Hedging: when the primary has not answered by its p95 latency, or has failed,
+// the same request is started on the secondary. The first valid answer wins.
+#define WEATHER_HEDGE_ENABLE        1
+#define WEATHER_HEDGE_PERCENTILE    95
+#define WEATHER_HEDGE_MIN_MS        (300)       // Never hedge earlier than this
 
-// Jakarta coordinates
-#define WEATHER_LATITUDE    "-6.1818"
-#define WEATHER_LONGITUDE   "106.8223"
+// Server certificates are verified against a few pinned trust anchors instead
+// of the whole bundle (smaller handshake cost). A chain the pins do not cover
+// falls back to the bundle, and pinning is tried again after the retry time.
+#define WEATHER_TLS_TRUST_MODE      WEATHER_TLS_TRUST_PINNED
+#define WEATHER_TLS_PIN_RETRY_MS    (86400000)  // 24 hours
 
-// API URL
-#define WEATHER_API_URL     "https://api.open-meteo.com/v1/forecast?latitude=" WEATHER_LATITUDE \
-                            "&longitude=" WEATHER_LONGITUDE \
-                            "&current=temperature_2m,relative_humidity_2m&forecast_days=1"
+// Handshake time and peak heap of both trust modes against the primary
+// endpoint, logged once before the first fetch (see weather_tls_benchmark)
+#define WEATHER_TLS_BENCHMARK       0
+#define WEATHER_TLS_BENCHMARK_RUNS  10
+
+// Cycles, heap allocations and peak heap of decoding the same captured batch
+// response as a cJSON tree, with the streaming JSON decoder and as FlatBuffers,
+// logged once at startup (see weather_decode_benchmark). Set by the component
+// CMakeLists.txt: idf.py -DWEATHER_DECODE_BENCHMARK=1 build
+#ifndef WEATHER_DECODE_BENCHMARK
+#define WEATHER_DECODE_BENCHMARK        0
+#endif
+#define WEATHER_DECODE_BENCHMARK_RUNS   20
 
 /**
  * Initialize weather client
@@ -41,20 +158,98 @@ void weather_client_start(void);
 void weather_client_stop(void);
 
 /**
- * Get latest weather data
+ * Get latest weather data for the primary station
+ * Values are interpolated from the cached hourly forecast when it covers the
+ * current time, otherwise the last fetched current values are returned.
  * @param data Pointer to weather_data_t structure to fill
  * @return true if data is valid, false otherwise
  */
 bool weather_client_get_data(weather_data_t *data);
 
+/**
+ * Get latest weather data for a station
+ * @param station Station index (order of WEATHER_STATIONS)
+ * @param data Pointer to weather_data_t structure to fill
+ * @return true if data is valid, false otherwise
+ */
+bool weather_client_get_station_data(size_t station, weather_data_t *data);
+
+/**
+ * Query station history (see weather_history_query)
+ * @param station Station index, must be below WEATHER_HISTORY_MAX_STATIONS
+ * @return number of entries written to out
+ */
+size_t weather_client_get_history(size_t station, weather_history_tier_t tier,
+                                  uint32_t from, uint32_t to,
+                                  weather_history_agg_t *out, size_t max_out);
+
+/**
+ * Get number of configured stations
+ */
+size_t weather_client_get_station_count(void);
+
+/**
+ * Get station name
+ * @return name, or NULL if index is out of range
+ */
+const char* weather_client_get_station_name(size_t station);
+
+/**
+ * Find station by name (case insensitive)
+ * @return station index, or -1 if not found
+ */
+int weather_client_find_station(const char *name);
+
 /**
  * Force immediate weather fetch
+ * Requests arriving while a fetch is scheduled or just finished are merged into it.
  */
 void weather_client_fetch_now(void);
 
+/**
+ * Get weather data version
+ * Increases every time station data is published; compare with a previous
+ * value to see whether anything changed without copying the data.
+ */
+uint32_t weather_client_get_version(void);
+
 /**
  * Check if weather client is running
  */
 bool weather_client_is_running(void);
 
+/**
+ * Get fetch statistics (connection reuse / TLS resumption counters)
+ * @param stats Pointer to weather_fetch_stats_t structure to fill
+ * @return true on success
+ */
+bool weather_client_get_fetch_stats(weather_fetch_stats_t *stats);
+
+/**
+ * Get phase traces of the last WEATHER_TRACE_LEN fetches
+ * Each trace is the request that answered the fetch (or the last failed one),
+ * split into DNS, connect + TLS, time to first byte, transfer and decode.
+ * @param trace Pointer to weather_trace_t structure to fill (~1.3 KB)
+ * @return true on success
+ */
+bool weather_client_get_trace(weather_trace_t *trace);
+
+/**
+ * Get connection type name ("reused", "resumed", "full", "none")
+ */
+const char* weather_client_conn_type_str(weather_conn_type_t type);
+
+/**
+ * Get trust mode name ("pinned", "bundle")
+ */
+const char* weather_client_tls_trust_str(weather_tls_trust_t trust);
+
+#if WEATHER_DECODE_BENCHMARK
+/**
+ * Log cycles, allocations and peak heap per decode of a captured batch
+ * response: cJSON tree, streaming JSON decoder and FlatBuffers decoder
+ */
+void weather_decode_benchmark(void);
+#endif
+
 #endif // WEATHER_CLIENT_H
\ No newline at end of file
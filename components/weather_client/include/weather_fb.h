@@ -0,0 +1,82 @@
+#ifndef WEATHER_FB_H
+#define WEATHER_FB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Largest single WeatherApiResponse message accepted (one per location)
+#define WEATHER_FB_MAX_MESSAGE_LEN  1024
+
+typedef struct weather_fb_stream weather_fb_stream_t;
+
+/**
+ * Message callback
+ * Called once per complete WeatherApiResponse, in location order.
+ * @param msg Message (FlatBuffer root, without the size prefix), valid during the call only
+ * @param len Message length
+ * @param index Location index (position in the request coordinate lists)
+ * @param ctx User context from weather_fb_stream_init()
+ */
+typedef void (*weather_fb_message_cb_t)(const uint8_t *msg, size_t len, size_t index, void *ctx);
+
+// Splitter for the size-prefixed message stream (opaque, allocate statically)
+struct weather_fb_stream {
+    uint8_t buf[WEATHER_FB_MAX_MESSAGE_LEN];
+    uint32_t msg_len;       // Length of the message being received
+    uint32_t received;      // Bytes of prefix or message received so far
+    uint8_t prefix[4];
+    bool in_message;        // Prefix complete, receiving message body
+    bool error;
+    size_t index;
+    weather_fb_message_cb_t message_cb;
+    void *ctx;
+};
+
+/**
+ * Reset stream for a new response
+ */
+void weather_fb_stream_init(weather_fb_stream_t *stream, weather_fb_message_cb_t message_cb, void *ctx);
+
+/**
+ * Feed the next chunk of the response (chunks may split messages anywhere)
+ * @return false if a message exceeds WEATHER_FB_MAX_MESSAGE_LEN (stream stays in error state)
+ */
+bool weather_fb_stream_feed(weather_fb_stream_t *stream, const uint8_t *data, size_t len);
+
+/**
+ * Signal end of input
+ * @return true if the response ended on a message boundary without errors
+ */
+bool weather_fb_stream_finish(weather_fb_stream_t *stream);
+
+/**
+ * Read a value of the "current" block straight from a message
+ * Values are returned as IEEE 754 binary32 bit patterns, left for the caller
+ * to convert (see fixed_from_float_bits).
+ * @param variable Position of the variable in the request's current= list
+ * @return false if the message is malformed or has no such variable
+ */
+bool weather_fb_current_value(const uint8_t *msg, size_t len, size_t variable, uint32_t *bits);
+
+/**
+ * Read the time of the "current" block
+ */
+bool weather_fb_current_time(const uint8_t *msg, size_t len, int64_t *time);
+
+/**
+ * Read the time axis of the "hourly" block
+ * @param start Time of the first value (unix time)
+ * @param interval Seconds between values
+ */
+bool weather_fb_hourly_time(const uint8_t *msg, size_t len, int64_t *start, int32_t *interval);
+
+/**
+ * Copy the values of an "hourly" variable (binary32 bit patterns)
+ * @param variable Position of the variable in the request's hourly= list
+ * @return number of values written to out (0 if absent or malformed)
+ */
+size_t weather_fb_hourly_values(const uint8_t *msg, size_t len, size_t variable,
+                                uint32_t *out, size_t max_out);
+
+#endif // WEATHER_FB_H
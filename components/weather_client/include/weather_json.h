@@ -0,0 +1,89 @@
+#ifndef WEATHER_JSON_H
+#define WEATHER_JSON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Parser limits (all storage lives inside weather_json_parser_t, no heap)
+#define WEATHER_JSON_MAX_DEPTH      8     // Maximum object/array nesting
+#define WEATHER_JSON_MAX_KEY_LEN    32    // Longer keys never match a path
+#define WEATHER_JSON_MAX_TOKEN_LEN  32    // Longer scalar values are skipped
+
+// Scalar value types reported to the value callback
+typedef enum {
+    WEATHER_JSON_NUMBER = 0,
+    WEATHER_JSON_STRING,
+    WEATHER_JSON_TRUE,
+    WEATHER_JSON_FALSE,
+    WEATHER_JSON_NULL
+} weather_json_type_t;
+
+typedef struct weather_json_parser weather_json_parser_t;
+
+/**
+ * Scalar value callback
+ * Called for every scalar whose text fits in WEATHER_JSON_MAX_TOKEN_LEN.
+ * Use weather_json_match() inside the callback to select the fields of interest.
+ * @param parser Parser positioned at the value (path is valid during the call)
+ * @param type Value type
+ * @param value Raw value text, NUL terminated (strings are unquoted, escapes kept)
+ * @param len Value length
+ * @param ctx User context from weather_json_init()
+ */
+typedef void (*weather_json_value_cb_t)(const weather_json_parser_t *parser,
+                                        weather_json_type_t type,
+                                        const char *value, size_t len,
+                                        void *ctx);
+
+// One level of the current path
+typedef struct {
+    char key[WEATHER_JSON_MAX_KEY_LEN];     // Member name (objects)
+    int index;                              // Element index (arrays), -1 for objects
+} weather_json_frame_t;
+
+// Streaming parser state (opaque, allocate statically or on the stack)
+struct weather_json_parser {
+    weather_json_frame_t stack[WEATHER_JSON_MAX_DEPTH];
+    char token[WEATHER_JSON_MAX_TOKEN_LEN + 1];
+    uint8_t depth;
+    uint8_t state;
+    uint8_t token_len;
+    uint8_t escape_left;
+    bool token_overflow;
+    bool string_is_key;
+    weather_json_value_cb_t value_cb;
+    void *ctx;
+};
+
+/**
+ * Reset parser for a new document
+ */
+void weather_json_init(weather_json_parser_t *parser, weather_json_value_cb_t value_cb, void *ctx);
+
+/**
+ * Feed the next chunk of the document (chunks may split tokens anywhere)
+ * @return false on syntax error or nesting overflow (parser stays in error state)
+ */
+bool weather_json_feed(weather_json_parser_t *parser, const char *data, size_t len);
+
+/**
+ * Signal end of input
+ * @return true if exactly one complete top-level value was parsed
+ */
+bool weather_json_finish(weather_json_parser_t *parser);
+
+/**
+ * Match the path of the value being reported against a pattern
+ * Pattern is dot separated member names, "[]" matches any array element,
+ * e.g. "current.temperature_2m", "hourly.time[]", "[].current.temperature_2m"
+ */
+bool weather_json_match(const weather_json_parser_t *parser, const char *pattern);
+
+/**
+ * Get array index at a path level
+ * @return element index, or -1 if the level is not an array
+ */
+int weather_json_index(const weather_json_parser_t *parser, uint8_t level);
+
+#endif // WEATHER_JSON_H
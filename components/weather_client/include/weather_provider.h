@@ -0,0 +1,101 @@
+#ifndef WEATHER_PROVIDER_H
+#define WEATHER_PROVIDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "weather_client.h"
+#include "weather_fb.h"
+#include "weather_json.h"
+
+// Number of entries in WEATHER_STATIONS
+#define WEATHER_STATION_ONE(name, lat, lon) + 1
+#define WEATHER_STATION_COUNT   (0 WEATHER_STATIONS(WEATHER_STATION_ONE))
+
+// Hourly forecast cache, one slot per hour starting at the previous full hour
+#define WEATHER_FORECAST_SLOTS  (WEATHER_FORECAST_HOURS + 1)
+
+// Configured station
+typedef struct {
+    const char *name;
+    const char *latitude;
+    const char *longitude;
+} weather_station_t;
+
+// Hourly forecast of one station
+typedef struct {
+    uint32_t start;                                 // Time of slot 0
+    uint8_t count;                                  // Valid slots
+    int16_t temperature[WEATHER_FORECAST_SLOTS];    // 0.01 °C
+    uint16_t humidity[WEATHER_FORECAST_SLOTS];      // 0.1 %
+} weather_forecast_t;
+
+// Fields extracted from a response
+typedef enum {
+    WEATHER_FIELD_TEMPERATURE = 0,
+    WEATHER_FIELD_HUMIDITY,
+    WEATHER_FIELD_COUNT
+} weather_field_t;
+
+// Hourly columns: one per field, plus the time axis
+#define WEATHER_HOURLY_TIME     WEATHER_FIELD_COUNT
+#define WEATHER_HOURLY_COLUMNS  (WEATHER_FIELD_COUNT + 1)
+
+// Decoded response (index = position in WEATHER_STATIONS)
+typedef struct {
+    weather_data_t current[WEATHER_STATION_COUNT];
+    uint32_t fields[WEATHER_STATION_COUNT];                         // Bit per weather_field_t received
+    weather_forecast_t forecast[WEATHER_STATION_COUNT];
+    uint8_t hourly_len[WEATHER_STATION_COUNT][WEATHER_HOURLY_COLUMNS]; // Slots received per column
+} weather_result_t;
+
+// Decoder state of one request (requests running in parallel each have their own)
+typedef struct {
+    union {
+        weather_json_parser_t json;
+        weather_fb_stream_t fb;
+    } parser;
+    weather_result_t result;
+    bool flatbuffers;           // Format of the body being decoded
+} weather_decoder_t;
+
+// Weather provider
+typedef struct {
+    const char *name;
+
+    /**
+     * Build the request URL covering all stations
+     * @return false if the URL does not fit in len
+     */
+    bool (*build_url)(const char *base_url, const weather_station_t *stations, size_t count,
+                      char *url, size_t len);
+
+    /**
+     * Reset decoder for a new response body
+     */
+    void (*begin)(weather_decoder_t *decoder);
+
+    /**
+     * Decode the next body chunk (chunks may split tokens anywhere)
+     * @return false on malformed data
+     */
+    bool (*feed)(weather_decoder_t *decoder, const char *data, size_t len);
+
+    /**
+     * Signal end of body
+     * @return false if the body was incomplete or malformed
+     */
+    bool (*finish)(weather_decoder_t *decoder);
+} weather_provider_t;
+
+// Open-Meteo forecast API (JSON or FlatBuffers, see WEATHER_API_USE_FLATBUFFERS)
+extern const weather_provider_t weather_provider_open_meteo;
+
+/**
+ * Reset an Open-Meteo decoder for either response format
+ * The provider's begin() picks WEATHER_API_USE_FLATBUFFERS; feed() and
+ * finish() follow the format chosen here (benchmarks, host tests).
+ */
+void weather_open_meteo_begin(weather_decoder_t *decoder, bool flatbuffers);
+
+#endif // WEATHER_PROVIDER_H
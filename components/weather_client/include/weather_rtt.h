@@ -0,0 +1,53 @@
+#ifndef WEATHER_RTT_H
+#define WEATHER_RTT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WEATHER_RTT_WINDOW          32  // Latency samples kept for percentiles
+#define WEATHER_RTT_MIN_SAMPLES     8   // Samples needed before percentiles are reported
+
+// Request latency estimator of one endpoint (all times in milliseconds)
+// Timeout follows RFC 6298: smoothed latency plus four times its mean
+// deviation, doubled after each timeout. Percentiles come from a window of
+// the most recent successful requests.
+typedef struct {
+    uint32_t srtt_ms;                       // Smoothed latency (0 = no sample yet)
+    uint32_t rttvar_ms;                     // Smoothed mean deviation
+    uint32_t timeout_ms;                    // Current timeout
+    uint32_t min_ms;                        // Timeout lower bound
+    uint32_t max_ms;                        // Timeout upper bound
+    uint16_t window[WEATHER_RTT_WINDOW];    // Recent latencies (ring)
+    uint8_t count;                          // Valid window entries
+    uint8_t next;                           // Next window slot
+} weather_rtt_t;
+
+/**
+ * Initialize estimator
+ * @param initial_ms Timeout until the first sample
+ */
+void weather_rtt_init(weather_rtt_t *rtt, uint32_t initial_ms, uint32_t min_ms, uint32_t max_ms);
+
+/**
+ * Add the latency of a completed request
+ */
+void weather_rtt_sample(weather_rtt_t *rtt, uint32_t latency_ms);
+
+/**
+ * Report a request that timed out (backs the timeout off)
+ */
+void weather_rtt_timeout(weather_rtt_t *rtt);
+
+/**
+ * Get the timeout for the next request
+ */
+uint32_t weather_rtt_timeout_ms(const weather_rtt_t *rtt);
+
+/**
+ * Get a latency percentile of the recent window
+ * @param percent 1-100
+ * @return latency, or 0 if fewer than WEATHER_RTT_MIN_SAMPLES samples were seen
+ */
+uint32_t weather_rtt_percentile(const weather_rtt_t *rtt, uint32_t percent);
+
+#endif // WEATHER_RTT_H
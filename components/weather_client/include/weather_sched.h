@@ -0,0 +1,73 @@
+#ifndef WEATHER_SCHED_H
+#define WEATHER_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Scheduler configuration (all times in milliseconds unless noted)
+typedef struct {
+    uint32_t fetch_interval_ms;     // Regular fetch interval
+    uint32_t sample_interval_ms;    // Interval of forecast samples between fetches (0 = off)
+    uint32_t align_period_s;        // Provider model update cadence in wall time (0 = no alignment)
+    uint32_t align_delay_s;         // Fetch this long after a model update
+    uint32_t backoff_min_ms;        // First retry delay after a failure
+    uint32_t backoff_max_ms;        // Retry delay cap
+    uint32_t max_age_ms;            // Retries before last success + max_age are never scheduled after it
+    uint32_t trigger_spacing_ms;    // Minimum time between a fetch and a triggered one
+} weather_sched_config_t;
+
+// Next action
+typedef enum {
+    WEATHER_SCHED_WAIT = 0,         // Nothing due, sleep for wait_ms
+    WEATHER_SCHED_FETCH,            // Fetch now, then call weather_sched_fetch_done()
+    WEATHER_SCHED_SAMPLE            // Record a forecast sample, then call weather_sched_sample_done()
+} weather_sched_action_t;
+
+// Scheduler state (pure data, time is passed in by the caller)
+typedef struct {
+    weather_sched_config_t config;
+    int64_t next_fetch_ms;          // Monotonic time of the next fetch
+    int64_t next_sample_ms;         // Monotonic time of the next sample
+    int64_t last_fetch_ms;          // End of the last fetch attempt (-1 = none)
+    int64_t last_success_ms;        // End of the last successful fetch (-1 = none)
+    uint32_t failures;              // Consecutive failures
+    uint32_t rng;                   // Jitter state (xorshift32)
+    uint32_t triggers;              // Trigger requests received
+    uint32_t collapsed;             // Triggers absorbed by an already scheduled fetch
+} weather_sched_t;
+
+/**
+ * Initialize scheduler, first fetch is due immediately
+ * @param now_ms Monotonic time
+ * @param seed Jitter seed (non-zero)
+ */
+void weather_sched_init(weather_sched_t *sched, const weather_sched_config_t *config,
+                        int64_t now_ms, uint32_t seed);
+
+/**
+ * Request a fetch no later than a deadline
+ * Requests are merged: the earliest deadline wins, and an already scheduled
+ * earlier fetch absorbs the request. So does a successful fetch less than
+ * trigger_spacing_ms ago.
+ * @param deadline_ms Monotonic time (now for an immediate fetch)
+ */
+void weather_sched_request(weather_sched_t *sched, int64_t now_ms, int64_t deadline_ms);
+
+/**
+ * Get the next action
+ * @param wait_ms Filled with the time until the next action when WAIT is returned
+ */
+weather_sched_action_t weather_sched_next(const weather_sched_t *sched, int64_t now_ms, uint32_t *wait_ms);
+
+/**
+ * Report the end of a fetch
+ * @param wall_s Wall clock time in seconds (used for alignment, ignored if not set)
+ */
+void weather_sched_fetch_done(weather_sched_t *sched, int64_t now_ms, int64_t wall_s, bool success);
+
+/**
+ * Report the end of a sample
+ */
+void weather_sched_sample_done(weather_sched_t *sched, int64_t now_ms);
+
+#endif // WEATHER_SCHED_H
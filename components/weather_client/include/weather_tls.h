@@ -0,0 +1,84 @@
+#ifndef WEATHER_TLS_H
+#define WEATHER_TLS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "weather_client.h"
+
+/*
+ * Pinned trust anchors for the weather endpoints.
+ *
+ * Instead of the full certificate bundle, the server chain is verified
+ * against the roots in certs/weather_roots.pem (parsed once at init). A
+ * certificate at the top of the chain the server sends whose public key
+ * matches an SPKI pin is trusted as well, which lets an intermediate or a
+ * root sent by the server be pinned by key alone. Signatures, validity and
+ * host name are checked by mbedTLS as usual.
+ *
+ * Generate a pin with:
+ *   openssl x509 -in cert.pem -pubkey -noout | openssl pkey -pubin -outform der |
+ *       openssl dgst -sha256 -binary | base64
+ */
+#define WEATHER_TLS_SPKI_PINS(X) \
+    X("C5+lpZ7tcVwmwQIMcRtPbsQtWLABXhQzejna0wHFr8M=")   /* ISRG Root X1 */ \
+    X("diGVwiVYbubAI3RW4hB9xU8e/CH2GnkuvVFZE8zmgzI=")   /* ISRG Root X2 */ \
+    X("hxqRlPTu1bMS/0DITB1SSu0vd4u/8l8TjPgfaAp63Gc=")   /* GTS Root R1 */ \
+    X("mEflZT5enoR1FuXLgYYGqnVEoZvmf9c2bVBpiOjYQ0c=")   /* GTS Root R4 */
+
+// Heap drop over a request, see weather_tls_heap_probe_start
+typedef struct {
+    size_t free_before;
+    bool active;            // Only one probe can run at a time
+} weather_tls_heap_probe_t;
+
+/**
+ * Parse the pinned roots and SPKI pins
+ * @return ESP_OK if at least one root or pin is usable
+ */
+esp_err_t weather_tls_init(void);
+
+/**
+ * Check if pinned verification is available
+ */
+bool weather_tls_pinned_ready(void);
+
+/**
+ * Attach the pinned anchors to an mbedTLS configuration
+ * Has the signature of esp_crt_bundle_attach, for esp_http_client_config_t.crt_bundle_attach.
+ */
+esp_err_t weather_tls_attach_pinned(void *conf);
+
+/**
+ * Attach the full certificate bundle (esp_crt_bundle_attach), counting verified chains
+ */
+esp_err_t weather_tls_attach_bundle(void *conf);
+
+/**
+ * Get the number of server certificate chains verified by the calling task
+ * Both attach functions count; a handshake that completes without verifying a
+ * chain resumed a session (the server sent no certificate).
+ */
+uint32_t weather_tls_chains_verified(void);
+
+/**
+ * Start measuring the lowest free heap (fails while another probe runs)
+ */
+void weather_tls_heap_probe_start(weather_tls_heap_probe_t *probe);
+
+/**
+ * Stop measuring
+ * @return largest heap drop since start in bytes, 0 if the probe did not run
+ */
+uint32_t weather_tls_heap_probe_stop(weather_tls_heap_probe_t *probe);
+
+#if WEATHER_TLS_BENCHMARK
+/**
+ * Log handshake time and peak heap of WEATHER_TLS_BENCHMARK_RUNS fresh
+ * connections (no keep-alive, no session resumption) in each trust mode
+ */
+void weather_tls_benchmark(const char *url);
+#endif
+
+#endif // WEATHER_TLS_H
@@ -0,0 +1,68 @@
+#ifndef WEATHER_TRACE_H
+#define WEATHER_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WEATHER_TRACE_LEN   32      // Fetches kept for percentiles
+
+// Phases of one request (microseconds)
+typedef enum {
+    WEATHER_PHASE_DNS = 0,          // Host name resolution (new connections only)
+    WEATHER_PHASE_CONNECT,          // TCP connect and TLS handshake (new connections only)
+    WEATHER_PHASE_TTFB,             // Request sent until the first response header
+    WEATHER_PHASE_TRANSFER,         // First header until end of body, decoding excluded
+    WEATHER_PHASE_DECODE,           // Body decoding
+    WEATHER_PHASE_TOTAL,            // Whole request, including a reconnect retry
+    WEATHER_PHASE_COUNT
+} weather_phase_t;
+
+// Trace of the request that answered a fetch (or the last one that failed)
+typedef struct {
+    uint32_t time;                              // Wall clock time of the fetch
+    uint32_t phase_us[WEATHER_PHASE_COUNT];
+    uint8_t measured;                           // Bit per phase that was reached
+    uint8_t endpoint;                           // 0 = primary
+    uint8_t conn_type;                          // weather_conn_type_t
+    bool success;
+} weather_trace_entry_t;
+
+// Ring of the most recent traces
+typedef struct {
+    weather_trace_entry_t entries[WEATHER_TRACE_LEN];
+    uint8_t count;                              // Valid entries
+    uint8_t next;                               // Next slot
+    uint32_t total;                             // Traces recorded since boot
+} weather_trace_t;
+
+/**
+ * Clear ring
+ */
+void weather_trace_init(weather_trace_t *trace);
+
+/**
+ * Add a trace, replacing the oldest when full
+ */
+void weather_trace_add(weather_trace_t *trace, const weather_trace_entry_t *entry);
+
+/**
+ * Get the n-th most recent trace
+ * @return NULL if n >= count
+ */
+const weather_trace_entry_t* weather_trace_get(const weather_trace_t *trace, uint32_t n);
+
+/**
+ * Get a phase percentile over the traces that reached the phase
+ * @param percent 1-100
+ * @param samples Filled with the number of traces considered (may be NULL)
+ * @return duration in microseconds, 0 if no trace reached the phase
+ */
+uint32_t weather_trace_percentile(const weather_trace_t *trace, weather_phase_t phase,
+                                  uint32_t percent, uint32_t *samples);
+
+/**
+ * Get phase name ("dns", "connect", "ttfb", "transfer", "decode", "total")
+ */
+const char* weather_trace_phase_name(weather_phase_t phase);
+
+#endif // WEATHER_TRACE_H
@@ -1,12 +1,27 @@
 #include "weather_client.h"
+#include "sdkconfig.h"
 #include "esp_log.h"
 #include "esp_http_client.h"
 #include "esp_crt_bundle.h"
-#include "cJSON.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "led_indicator.h"
+#include "weather_log.h"
+#include "weather_provider.h"
+#include "weather_rtt.h"
+#include "weather_sched.h"
+#include "weather_tls.h"
+#include "snapshot.h"
+#include "metrics.h"
+#include "fixed_point.h"
+#include "esp_random.h"
+#include "lwip/netdb.h"
+#include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
 
 static const char *TAG = "WEATHER_CLIENT";
@@ -15,38 +30,202 @@ static const char *TAG = "WEATHER_CLIENT";
 static TaskHandle_t weather_task_handle = NULL;
 static bool is_running = false;
 
-// Current weather data
-static weather_data_t current_weather = {
-    .temperature = 0.0,
-    .humidity = 0,
-    .last_update = 0,
-    .is_valid = false
+// Task notification bits
+#define WEATHER_NOTIFY_FETCH    (1u << 0)   // Fetch requested
+#define WEATHER_NOTIFY_STOP     (1u << 1)   // Leave the task loop
+
+// Fetch scheduler, owned by the fetch task
+static weather_sched_t fetch_sched;
+
+#define WEATHER_STATION_ENTRY(name, lat, lon) { name, lat, lon },
+static const weather_station_t weather_stations[] = {
+    WEATHER_STATIONS(WEATHER_STATION_ENTRY)
+};
+
+_Static_assert(WEATHER_STATION_COUNT <= WEATHER_MAX_STATIONS, "Too many weather stations");
+
+// Per-station history (first WEATHER_HISTORY_STATIONS stations), guarded by history_mutex
+#define WEATHER_HISTORY_STATIONS \
+    (WEATHER_STATION_COUNT < WEATHER_HISTORY_MAX_STATIONS ? WEATHER_STATION_COUNT : WEATHER_HISTORY_MAX_STATIONS)
+
+static weather_history_t station_history[WEATHER_HISTORY_STATIONS];
+static SemaphoreHandle_t history_mutex = NULL;
+
+_Static_assert(WEATHER_FORECAST_HOURS * 3600000LL > WEATHER_FETCH_INTERVAL_MS,
+               "Forecast must cover the fetch interval");
+
+// Per-station state (index = position in WEATHER_STATIONS), written by the
+// fetch task and read from any task through the snapshots
+typedef struct {
+    weather_data_t current;         // Last fetched current values
+    weather_forecast_t forecast;    // Hourly forecast cache
+} station_state_t;
+
+static station_state_t station_state[WEATHER_STATION_COUNT];
+static snapshot_t station_snapshot[WEATHER_STATION_COUNT];
+
+// Rolling window metrics per station, owned by the fetch task (and init before it starts)
+static weather_metrics_t station_metrics[WEATHER_STATION_COUNT];
+
+// Request endpoints: the first is the primary, the second is hedged to
+typedef struct {
+    const weather_provider_t *provider;
+    const char *base_url;
+} weather_endpoint_t;
+
+static const weather_endpoint_t weather_endpoints[] = {
+    { &weather_provider_open_meteo, WEATHER_API_BASE_URL },
+#if WEATHER_HEDGE_ENABLE
+    { &weather_provider_open_meteo, WEATHER_API_SECONDARY_URL },
+#endif
 };
 
-// HTTP response buffer
-#define HTTP_BUFFER_SIZE 2048
-static char http_buffer[HTTP_BUFFER_SIZE];
-static int http_buffer_index = 0;
+#define WEATHER_ENDPOINT_COUNT  (sizeof(weather_endpoints) / sizeof(weather_endpoints[0]))
+
+// Request lane: one task per endpoint with its own persistent HTTP client
+// (keep-alive and TLS session reuse) and decoder, so a hedged request runs
+// next to the primary one
+typedef struct {
+    const weather_endpoint_t *endpoint;
+    char url[WEATHER_API_URL_MAX_LEN];      // Built once at init
+    char host[64];                          // Host part of url, resolved before each request
+    TaskHandle_t task;
+    esp_http_client_handle_t client;
+    bool tls_session_cached;                // A completed handshake left a session ticket in client
+    weather_tls_trust_t trust;              // Trust anchors of the client
+    int64_t pin_retry_at_us;                // Pinned anchors are tried again after this (0 = never)
+    bool connected_this_fetch;              // HTTP_EVENT_ON_CONNECTED seen during perform
+    weather_decoder_t decoder;
+    uint32_t body_bytes;
+    int64_t decode_time_us;
+    int64_t dns_us;                         // Phase timing of the last attempt (esp_timer_get_time)
+    int64_t perform_start_us;
+    int64_t connected_at_us;
+    int64_t first_header_at_us;
+    int64_t perform_end_us;
+    uint32_t heap_peak_bytes;               // Heap drop over the last attempt
+    uint32_t timeout_ms;                    // Set by the fetch task before each request
+    uint32_t generation;                    // Fetch the request belongs to
+    volatile bool busy;                     // Request running, cleared once its result is posted
+    weather_rtt_t rtt;                      // Latency estimator, owned by the fetch task
+} fetch_lane_t;
+
+// Outcome of one request, posted by the lane to the fetch task
+typedef struct {
+    uint8_t lane;
+    uint32_t generation;
+    bool success;                           // Complete answer for every station
+    bool timed_out;
+    weather_conn_type_t conn_type;
+    weather_tls_trust_t trust;              // Trust mode of the connection
+    bool tls_fallback;                      // Pinned anchors rejected the chain, bundle used
+    uint32_t heap_peak_bytes;
+    uint32_t latency_ms;
+    uint32_t body_bytes;
+    uint32_t decode_us;
+    weather_trace_entry_t trace;
+} lane_result_t;
+
+static fetch_lane_t fetch_lanes[WEATHER_ENDPOINT_COUNT];
+static QueueHandle_t lane_result_queue = NULL;
+static uint32_t fetch_generation = 0;
+
+// Fetch statistics (working copy owned by the fetch task, published after each fetch)
+typedef struct {
+    weather_fetch_stats_t stats;
+    int64_t next_fetch_ms;          // Monotonic time of the next scheduled fetch
+} fetch_status_t;
+
+static fetch_status_t fetch_status_published;
+static snapshot_t fetch_status_snapshot = SNAPSHOT_INIT(&fetch_status_published, sizeof(fetch_status_t));
+static weather_fetch_stats_t fetch_stats = {0};
+
+// Exported metrics (/metrics)
+static const uint32_t fetch_duration_bounds_ms[] = {250, 500, 1000, 2000, 5000, 10000, 20000};
+static atomic_uint fetch_duration_buckets[sizeof(fetch_duration_bounds_ms) / sizeof(fetch_duration_bounds_ms[0]) + 1];
+static metric_t fetch_success_metric = METRIC_COUNTER_INIT("weather_fetch_total", "Weather fetches by result",
+                                                           "result=\"success\"");
+static metric_t fetch_failure_metric = METRIC_COUNTER_INIT("weather_fetch_total", "Weather fetches by result",
+                                                           "result=\"failure\"");
+static metric_t fetch_duration_metric = METRIC_HISTOGRAM_INIT("weather_fetch_duration_seconds",
+                                                              "Weather fetch time, hedging included", NULL,
+                                                              fetch_duration_bounds_ms, fetch_duration_buckets, 3);
+
+// Phase traces of recent fetches (working copy owned by the fetch task)
+static weather_trace_t fetch_trace;
+static weather_trace_t fetch_trace_published;
+static snapshot_t fetch_trace_snapshot = SNAPSHOT_INIT(&fetch_trace_published, sizeof(weather_trace_t));
+
+/**
+ * Interpolate a forecast for a point in time
+ * @return false if the forecast does not cover the time
+ */
+static bool forecast_interpolate(const weather_forecast_t *forecast, time_t now,
+                                 int16_t *temperature, uint16_t *humidity)
+{
+    if (forecast->count < 2 || now < (time_t)forecast->start) {
+        return false;
+    }
+    
+    uint32_t offset = (uint32_t)(now - forecast->start);
+    size_t slot = offset / 3600u;
+    if (slot + 1 >= forecast->count) {
+        return false;
+    }
+    
+    int64_t frac = offset % 3600u;
+    int32_t t0 = forecast->temperature[slot];
+    int32_t t1 = forecast->temperature[slot + 1];
+    int32_t h0 = forecast->humidity[slot];
+    int32_t h1 = forecast->humidity[slot + 1];
+    
+    *temperature = (int16_t)(t0 + fixed_div_round((t1 - t0) * frac, 3600));
+    *humidity = (uint16_t)(h0 + fixed_div_round((h1 - h0) * frac, 3600));
+    return true;
+}
+
+/**
+ * Endpoint name for logs
+ */
+static const char* lane_name(const fetch_lane_t *lane)
+{
+    return (lane == &fetch_lanes[0]) ? "primary" : "secondary";
+}
 
 /**
  * HTTP event handler
  */
 static esp_err_t http_event_handler(esp_http_client_event_t *evt)
 {
+    fetch_lane_t *lane = evt->user_data;
+    
     switch (evt->event_id) {
+        case HTTP_EVENT_ON_CONNECTED:
+            // Only raised for new connections (TCP + TLS handshake)
+            lane->connected_this_fetch = true;
+            lane->connected_at_us = esp_timer_get_time();
+            break;
+            
+        case HTTP_EVENT_ON_HEADER:
+            if (lane->first_header_at_us == 0) {
+                lane->first_header_at_us = esp_timer_get_time();
+            }
+            break;
+            
         case HTTP_EVENT_ON_DATA:
-            // Append data to buffer
-            if (http_buffer_index + evt->data_len < HTTP_BUFFER_SIZE - 1) {
-                memcpy(http_buffer + http_buffer_index, evt->data, evt->data_len);
-                http_buffer_index += evt->data_len;
-                http_buffer[http_buffer_index] = '\0';
-            } else {
-                ESP_LOGW(TAG, "HTTP buffer overflow");
+            // Decode body chunks as they arrive
+            if (esp_http_client_get_status_code(evt->client) == 200) {
+                int64_t start_us = esp_timer_get_time();
+                lane->body_bytes += evt->data_len;
+                if (!lane->endpoint->provider->feed(&lane->decoder, evt->data, evt->data_len)) {
+                    ESP_LOGW(TAG, "[%s] Malformed %s response", lane_name(lane), WEATHER_API_FORMAT_NAME);
+                }
+                lane->decode_time_us += esp_timer_get_time() - start_us;
             }
             break;
             
         case HTTP_EVENT_ERROR:
-            ESP_LOGE(TAG, "HTTP error");
+            ESP_LOGE(TAG, "[%s] HTTP error", lane_name(lane));
             break;
             
         default:
@@ -56,55 +235,458 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt)
 }
 
 /**
- * Parse JSON response from API
+ * Fill values derived from the reading (safe from any task)
  */
-static bool parse_weather_json(const char *json_str)
+static void fill_derived(weather_data_t *data)
 {
-    cJSON *root = cJSON_Parse(json_str);
-    if (root == NULL) {
-        ESP_LOGE(TAG, "Failed to parse JSON");
-        return false;
+    weather_derived_t derived;
+    weather_metrics_derive(data->temperature, data->humidity, &derived);
+    data->dew_point = derived.dew_point;
+    data->heat_index = derived.heat_index;
+    data->apparent_temperature = derived.apparent_temperature;
+}
+
+/**
+ * Fill derived values and window statistics of published station data (fetch task)
+ */
+static void update_metrics(size_t station, weather_data_t *data)
+{
+    fill_derived(data);
+    weather_metrics_get(&station_metrics[station], &data->window_1h, &data->window_24h);
+}
+
+/**
+ * Record a sample in the history store, the rolling windows and the flash log
+ */
+static void record_sample(size_t station, time_t now, int16_t temperature, uint16_t humidity)
+{
+    weather_metrics_add(&station_metrics[station], (uint32_t)now, temperature, humidity);
+    
+    if (station < WEATHER_HISTORY_STATIONS && history_mutex) {
+        xSemaphoreTake(history_mutex, portMAX_DELAY);
+        weather_history_add(&station_history[station], (uint32_t)now, temperature, humidity);
+        xSemaphoreGive(history_mutex);
     }
     
-    // Get "current" object
-    cJSON *current = cJSON_GetObjectItem(root, "current");
-    if (!cJSON_IsObject(current)) {
-        ESP_LOGE(TAG, "No 'current' object in JSON");
-        cJSON_Delete(root);
-        return false;
+    weather_log_append((uint32_t)now, (uint8_t)station, temperature, humidity);
+}
+
+/**
+ * Record interpolated samples between fetches
+ */
+static void record_forecast_samples(void)
+{
+    time_t now = time(NULL);
+    
+    for (size_t i = 0; i < WEATHER_STATION_COUNT; i++) {
+        weather_data_t data;
+        if (weather_client_get_station_data(i, &data) && data.is_interpolated) {
+            record_sample(i, now, data.temperature, data.humidity);
+            
+            // Publish the updated windows
+            station_state_t state;
+            snapshot_read(&station_snapshot[i], &state);
+            update_metrics(i, &state.current);
+            snapshot_write(&station_snapshot[i], &state);
+        }
     }
+}
+
+/**
+ * Check that a decoded response has every station
+ */
+static bool result_complete(const fetch_lane_t *lane)
+{
+    const weather_result_t *result = &lane->decoder.result;
     
-    // Get temperature
-    cJSON *temp = cJSON_GetObjectItem(current, "temperature_2m");
-    if (!cJSON_IsNumber(temp)) {
-        ESP_LOGE(TAG, "No temperature data");
-        cJSON_Delete(root);
-        return false;
+    for (size_t i = 0; i < WEATHER_STATION_COUNT; i++) {
+        if (!(result->fields[i] & (1u << WEATHER_FIELD_TEMPERATURE))) {
+            ESP_LOGE(TAG, "[%s] [%s] No temperature data", lane_name(lane), weather_stations[i].name);
+            return false;
+        }
+        
+        if (!(result->fields[i] & (1u << WEATHER_FIELD_HUMIDITY))) {
+            ESP_LOGE(TAG, "[%s] [%s] No humidity data", lane_name(lane), weather_stations[i].name);
+            return false;
+        }
     }
     
-    // Get humidity
-    cJSON *humidity = cJSON_GetObjectItem(current, "relative_humidity_2m");
-    if (!cJSON_IsNumber(humidity)) {
-        ESP_LOGE(TAG, "No humidity data");
-        cJSON_Delete(root);
+    return true;
+}
+
+/**
+ * Publish a decoded response
+ */
+static void publish_result(const weather_result_t *result)
+{
+    time_t now = time(NULL);
+    
+    for (size_t i = 0; i < WEATHER_STATION_COUNT; i++) {
+        // Update station weather data (this task is the only writer)
+        station_state_t state;
+        snapshot_read(&station_snapshot[i], &state);
+        state.current.temperature = result->current[i].temperature;
+        state.current.humidity = result->current[i].humidity;
+        state.current.last_update = now;
+        state.current.is_valid = true;
+        
+        record_sample(i, now, state.current.temperature, state.current.humidity);
+        update_metrics(i, &state.current);
+        
+        char temperature[FIXED_FORMAT_MAX_LEN];
+        char humidity[FIXED_FORMAT_MAX_LEN];
+        fixed_format(temperature, sizeof(temperature), state.current.temperature, FIXED_TEMP_DECIMALS);
+        fixed_format(humidity, sizeof(humidity), state.current.humidity, FIXED_HUM_DECIMALS);
+        ESP_LOGI(TAG, "[%s] Weather updated: %s°C, %s%% humidity", weather_stations[i].name,
+                 temperature, humidity);
+        
+        // Forecast cache: all columns must cover at least two slots
+        uint8_t slots = WEATHER_FORECAST_SLOTS;
+        for (int column = 0; column < WEATHER_HOURLY_COLUMNS; column++) {
+            if (result->hourly_len[i][column] < slots) {
+                slots = result->hourly_len[i][column];
+            }
+        }
+        if (slots >= 2) {
+            state.forecast = result->forecast[i];
+            state.forecast.count = slots;
+        } else {
+            ESP_LOGW(TAG, "[%s] No hourly forecast, keeping previous", weather_stations[i].name);
+        }
+        
+        snapshot_write(&station_snapshot[i], &state);
+    }
+}
+
+/**
+ * Create the persistent HTTP client of a lane
+ */
+static bool lane_client_open(fetch_lane_t *lane)
+{
+    esp_http_client_config_t config = {
+        .url = lane->url,
+        .event_handler = http_event_handler,
+        .user_data = lane,
+        .timeout_ms = WEATHER_TIMEOUT_INITIAL_MS,
+        .buffer_size = 512,
+        .keep_alive_enable = true,
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        .save_client_session = true,  // Offer the cached session ticket on reconnect
+#endif
+        // <-- WAJIB untuk HTTPS
+        .crt_bundle_attach = (lane->trust == WEATHER_TLS_TRUST_PINNED) ? weather_tls_attach_pinned
+                                                                       : weather_tls_attach_bundle,
+    };
+    
+    lane->client = esp_http_client_init(&config);
+    lane->tls_session_cached = false;
+    return lane->client != NULL;
+}
+
+/**
+ * Close the connection of a lane (next request reconnects, offering the
+ * session ticket the client keeps)
+ */
+static void lane_client_close(fetch_lane_t *lane)
+{
+    if (lane->client) {
+        esp_http_client_close(lane->client);
+    }
+}
+
+/**
+ * Drop the persistent HTTP client and its session ticket (next request starts
+ * with a full handshake, used when the trust anchors change)
+ */
+static void lane_client_discard(fetch_lane_t *lane)
+{
+    if (lane->client) {
+        esp_http_client_cleanup(lane->client);
+        lane->client = NULL;
+    }
+    lane->tls_session_cached = false;
+}
+
+/**
+ * Resolve the endpoint host ahead of the request so DNS is timed on its own
+ * (the client's lookup then hits the lwIP DNS cache)
+ */
+static void lane_resolve(fetch_lane_t *lane)
+{
+    struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_STREAM,
+    };
+    struct addrinfo *res = NULL;
+    
+    if (lane->host[0] == '\0') {
+        return;
+    }
+    
+    if (getaddrinfo(lane->host, NULL, &hints, &res) != 0 || res == NULL) {
+        ESP_LOGW(TAG, "[%s] DNS lookup of %s failed", lane_name(lane), lane->host);
+        return;
+    }
+    freeaddrinfo(res);
+}
+
+/**
+ * Perform one GET on the persistent client
+ * @param conn_type Filled with how the connection was obtained
+ */
+static esp_err_t lane_client_get(fetch_lane_t *lane, weather_conn_type_t *conn_type)
+{
+    // Reset streaming decoder
+    lane->endpoint->provider->begin(&lane->decoder);
+    lane->body_bytes = 0;
+    lane->decode_time_us = 0;
+    
+    uint32_t chains_before = weather_tls_chains_verified();
+    lane->connected_this_fetch = false;
+    
+    int64_t dns_start_us = esp_timer_get_time();
+    lane_resolve(lane);
+    lane->perform_start_us = esp_timer_get_time();
+    lane->dns_us = lane->perform_start_us - dns_start_us;
+    lane->connected_at_us = 0;
+    lane->first_header_at_us = 0;
+    
+    weather_tls_heap_probe_t heap_probe;
+    weather_tls_heap_probe_start(&heap_probe);
+    esp_http_client_set_timeout_ms(lane->client, lane->timeout_ms);
+    esp_err_t err = esp_http_client_perform(lane->client);
+    lane->perform_end_us = esp_timer_get_time();
+    lane->heap_peak_bytes = weather_tls_heap_probe_stop(&heap_probe);
+    
+    if (!lane->connected_this_fetch) {
+        *conn_type = (err == ESP_OK) ? WEATHER_CONN_REUSED : WEATHER_CONN_NONE;
+    } else {
+        // A resumed handshake skips the server certificate, so a new TLS
+        // connection that verified no chain is one the server resumed
+        bool verified = (weather_tls_chains_verified() != chains_before);
+        bool tls = (strncmp(lane->url, "https://", 8) == 0);
+        *conn_type = (tls && !verified) ? WEATHER_CONN_RESUMED : WEATHER_CONN_FULL;
+        lane->tls_session_cached = tls && (err == ESP_OK);
+    }
+    
+    return err;
+}
+
+/**
+ * Check if the last attempt failed on certificate verification
+ */
+static bool lane_cert_rejected(fetch_lane_t *lane)
+{
+    int tls_code = 0;
+    int cert_flags = 0;
+    
+    if (lane->client == NULL) {
         return false;
     }
     
-    // Update current weather data
-    current_weather.temperature = (float)temp->valuedouble;
-    current_weather.humidity = humidity->valueint;
-    current_weather.last_update = time(NULL);
-    current_weather.is_valid = true;
+    esp_http_client_get_and_clear_last_tls_error(lane->client, &tls_code, &cert_flags);
+    return cert_flags != 0;
+}
+
+/**
+ * Fill the phase trace of the last attempt
+ */
+static void lane_trace(const fetch_lane_t *lane, lane_result_t *result, int64_t start_us)
+{
+    weather_trace_entry_t *trace = &result->trace;
+    
+    trace->endpoint = result->lane;
+    trace->conn_type = (uint8_t)result->conn_type;
+    trace->success = result->success;
+    trace->phase_us[WEATHER_PHASE_TOTAL] = (uint32_t)(esp_timer_get_time() - start_us);
+    trace->measured = (1u << WEATHER_PHASE_TOTAL);
     
-    ESP_LOGI(TAG, "Weather updated: %.1f°C, %d%% humidity", 
-             current_weather.temperature, current_weather.humidity);
+    // DNS and connect only count for new connections
+    int64_t request_us = lane->perform_start_us;
+    if (lane->connected_this_fetch) {
+        request_us = lane->connected_at_us;
+        trace->phase_us[WEATHER_PHASE_DNS] = (uint32_t)lane->dns_us;
+        trace->phase_us[WEATHER_PHASE_CONNECT] = (uint32_t)(lane->connected_at_us - lane->perform_start_us);
+        trace->measured |= (1u << WEATHER_PHASE_DNS) | (1u << WEATHER_PHASE_CONNECT);
+    }
     
-    cJSON_Delete(root);
-    return true;
+    if (lane->first_header_at_us != 0) {
+        int64_t transfer_us = lane->perform_end_us - lane->first_header_at_us - lane->decode_time_us;
+        trace->phase_us[WEATHER_PHASE_TTFB] = (uint32_t)(lane->first_header_at_us - request_us);
+        trace->phase_us[WEATHER_PHASE_TRANSFER] = (transfer_us > 0) ? (uint32_t)transfer_us : 0;
+        trace->phase_us[WEATHER_PHASE_DECODE] = (uint32_t)lane->decode_time_us;
+        trace->measured |= (1u << WEATHER_PHASE_TTFB) | (1u << WEATHER_PHASE_TRANSFER) |
+                           (1u << WEATHER_PHASE_DECODE);
+    }
+}
+
+/**
+ * Run one request on a lane
+ */
+static void lane_request(fetch_lane_t *lane, lane_result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+    result->lane = (uint8_t)(lane - fetch_lanes);
+    result->generation = lane->generation;
+    result->conn_type = WEATHER_CONN_NONE;
+    
+    int64_t start_us = esp_timer_get_time();
+    
+    // Give the pinned anchors another chance some time after a fallback
+    if (lane->pin_retry_at_us != 0 && start_us >= lane->pin_retry_at_us) {
+        ESP_LOGI(TAG, "[%s] Retrying pinned trust anchors", lane_name(lane));
+        lane->trust = WEATHER_TLS_TRUST_PINNED;
+        lane->pin_retry_at_us = 0;
+        lane_client_discard(lane);
+    }
+    
+    if (lane->client == NULL && !lane_client_open(lane)) {
+        ESP_LOGE(TAG, "[%s] Failed to initialize HTTP client", lane_name(lane));
+        return;
+    }
+    
+    // Perform HTTP GET request on the kept-alive connection
+    bool had_cached_state = lane->tls_session_cached;
+    esp_err_t err = lane_client_get(lane, &result->conn_type);
+    
+    // Stale keep-alive socket or rejected session: retry once on a new
+    // connection (the server falls back to a full handshake for a bad ticket)
+    if (err != ESP_OK && had_cached_state) {
+        ESP_LOGW(TAG, "[%s] Request on cached connection failed (%s), reconnecting",
+                 lane_name(lane), esp_err_to_name(err));
+        lane_client_close(lane);
+        err = lane_client_get(lane, &result->conn_type);
+    }
+    
+    // Chain not covered by the pinned anchors: retry with the full bundle
+    if (err != ESP_OK && lane->trust == WEATHER_TLS_TRUST_PINNED && lane_cert_rejected(lane)) {
+        ESP_LOGW(TAG, "[%s] Certificate not covered by pinned anchors, falling back to the bundle",
+                 lane_name(lane));
+        lane->trust = WEATHER_TLS_TRUST_BUNDLE;
+        lane->pin_retry_at_us = esp_timer_get_time() + (int64_t)WEATHER_TLS_PIN_RETRY_MS * 1000;
+        result->tls_fallback = true;
+        lane_client_discard(lane);
+        if (lane_client_open(lane)) {
+            err = lane_client_get(lane, &result->conn_type);
+        }
+    }
+    
+    result->trust = lane->trust;
+    result->heap_peak_bytes = lane->heap_peak_bytes;
+    result->latency_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    
+    if (err == ESP_OK) {
+        int status_code = esp_http_client_get_status_code(lane->client);
+        
+        if (status_code != 200) {
+            ESP_LOGE(TAG, "[%s] HTTP GET failed, status code: %d", lane_name(lane), status_code);
+        } else {
+            int64_t finish_start_us = esp_timer_get_time();
+            bool complete = lane->endpoint->provider->finish(&lane->decoder);
+            lane->decode_time_us += esp_timer_get_time() - finish_start_us;
+            
+            if (!complete) {
+                ESP_LOGE(TAG, "[%s] Incomplete %s response", lane_name(lane), WEATHER_API_FORMAT_NAME);
+            } else {
+                result->success = result_complete(lane);
+            }
+        }
+    } else {
+        ESP_LOGE(TAG, "[%s] HTTP GET error: %s", lane_name(lane), esp_err_to_name(err));
+        result->timed_out = (result->latency_ms >= lane->timeout_ms);
+        lane_client_close(lane);
+    }
+    
+    result->body_bytes = lane->body_bytes;
+    result->decode_us = (uint32_t)lane->decode_time_us;
+    lane_trace(lane, result, start_us);
+}
+
+/**
+ * Request lane task - runs one request per notification
+ */
+static void fetch_lane_task(void *pvParameters)
+{
+    fetch_lane_t *lane = pvParameters;
+    
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        
+        lane_result_t result;
+        lane_request(lane, &result);
+        xQueueSend(lane_result_queue, &result, portMAX_DELAY);
+        lane->busy = false;
+    }
+}
+
+/**
+ * Start a request on an idle lane
+ */
+static void lane_start(fetch_lane_t *lane, uint32_t generation)
+{
+    lane->generation = generation;
+    lane->timeout_ms = weather_rtt_timeout_ms(&lane->rtt);
+    lane->busy = true;
+    xTaskNotifyGive(lane->task);
+}
+
+/**
+ * Account a finished request (including ones a fetch no longer waits for)
+ */
+static void lane_account(const lane_result_t *result)
+{
+    fetch_lane_t *lane = &fetch_lanes[result->lane];
+    
+    if (result->success) {
+        weather_rtt_sample(&lane->rtt, result->latency_ms);
+    } else if (result->timed_out) {
+        weather_rtt_timeout(&lane->rtt);
+    }
+    
+    switch (result->conn_type) {
+        case WEATHER_CONN_REUSED:  fetch_stats.reused_count++;         break;
+        case WEATHER_CONN_RESUMED: fetch_stats.resumed_count++;        break;
+        case WEATHER_CONN_FULL:    fetch_stats.full_handshake_count++; break;
+        default:                                                       break;
+    }
+    
+    if (result->tls_fallback) {
+        fetch_stats.tls_fallbacks++;
+    }
+    
+    // Handshake cost per trust mode, from successful full handshakes only
+    if (result->conn_type == WEATHER_CONN_FULL && result->success &&
+        (result->trace.measured & (1u << WEATHER_PHASE_CONNECT))) {
+        weather_tls_stats_t *tls = &fetch_stats.tls[result->trust];
+        uint32_t handshake_ms = result->trace.phase_us[WEATHER_PHASE_CONNECT] / 1000;
+        tls->avg_handshake_ms = (uint32_t)(((uint64_t)tls->avg_handshake_ms * tls->handshakes + handshake_ms) /
+                                           (tls->handshakes + 1));
+        tls->handshakes++;
+        if (handshake_ms > tls->max_handshake_ms) {
+            tls->max_handshake_ms = handshake_ms;
+        }
+        if (result->heap_peak_bytes > tls->peak_heap_bytes) {
+            tls->peak_heap_bytes = result->heap_peak_bytes;
+        }
+    }
+}
+
+/**
+ * Hedge delay of a lane: its p95 latency, 0 until enough answers were seen
+ */
+static uint32_t lane_hedge_delay(const fetch_lane_t *lane)
+{
+    uint32_t delay_ms = weather_rtt_percentile(&lane->rtt, WEATHER_HEDGE_PERCENTILE);
+    if (delay_ms > 0 && delay_ms < WEATHER_HEDGE_MIN_MS) {
+        delay_ms = WEATHER_HEDGE_MIN_MS;
+    }
+    return delay_ms;
 }
 
 /**
  * Fetch weather data from API
+ * The primary request starts at once; the secondary starts when the primary
+ * is slower than its p95 latency or fails. The first valid answer is published.
  */
 static bool fetch_weather_data(void)
 {
@@ -113,45 +695,139 @@ static bool fetch_weather_data(void)
     // Turn on weather fetch LED
     led_set_weather_fetch(true);
     
-    // Reset buffer
-    http_buffer_index = 0;
-    memset(http_buffer, 0, HTTP_BUFFER_SIZE);
+    fetch_stats.fetch_count++;
+    int64_t start_us = esp_timer_get_time();
     
-    // Configure HTTP client
-    esp_http_client_config_t config = {
-        .url = WEATHER_API_URL,
-        .event_handler = http_event_handler,
-        .timeout_ms = 10000,
-        .buffer_size = 512,
-        .crt_bundle_attach = esp_crt_bundle_attach,  // <-- WAJIB untuk HTTPS
-    };
+    // Requests abandoned by earlier fetches still feed the latency estimators
+    lane_result_t result;
+    while (xQueueReceive(lane_result_queue, &result, 0) == pdTRUE) {
+        lane_account(&result);
+    }
+    
+    // A lane still finishing an abandoned request sits this fetch out
+    fetch_lane_t *primary = NULL;
+    fetch_lane_t *secondary = NULL;
+    for (size_t i = 0; i < WEATHER_ENDPOINT_COUNT; i++) {
+        if (fetch_lanes[i].busy) {
+            continue;
+        }
+        if (!primary) {
+            primary = &fetch_lanes[i];
+        } else if (!secondary) {
+            secondary = &fetch_lanes[i];
+        }
+    }
     
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize HTTP client");
+    if (!primary) {
+        ESP_LOGE(TAG, "All request lanes busy");
+        fetch_stats.failure_count++;
+        metrics_counter_inc(&fetch_failure_metric);
         led_set_weather_fetch(false);
         return false;
     }
     
-    // Perform HTTP GET request
-    esp_err_t err = esp_http_client_perform(client);
+    uint32_t generation = ++fetch_generation;
+    lane_start(primary, generation);
     
+    uint32_t hedge_ms = secondary ? lane_hedge_delay(primary) : 0;
+    int64_t deadline_us = start_us + (int64_t)WEATHER_FETCH_DEADLINE_MS * 1000;
+    int running = 1;
     bool success = false;
+    lane_result_t last = { .lane = (uint8_t)(primary - fetch_lanes), .conn_type = WEATHER_CONN_NONE };
     
-    if (err == ESP_OK) {
-        int status_code = esp_http_client_get_status_code(client);
+    while (running > 0) {
+        int64_t now_us = esp_timer_get_time();
         
-        if (status_code == 200) {
-            ESP_LOGI(TAG, "HTTP GET successful, parsing data...");
-            success = parse_weather_json(http_buffer);
-        } else {
-            ESP_LOGE(TAG, "HTTP GET failed, status code: %d", status_code);
+        if (secondary && hedge_ms > 0 && now_us - start_us >= (int64_t)hedge_ms * 1000) {
+            ESP_LOGW(TAG, "No answer after %lu ms, hedging to %s", (unsigned long)hedge_ms, lane_name(secondary));
+            fetch_stats.hedged_count++;
+            lane_start(secondary, generation);
+            secondary = NULL;
+            running++;
+            continue;
+        }
+        
+        if (now_us >= deadline_us) {
+            ESP_LOGE(TAG, "No answer within %d ms", WEATHER_FETCH_DEADLINE_MS);
+            break;
+        }
+        
+        int64_t until_us = deadline_us;
+        if (secondary && hedge_ms > 0 && start_us + (int64_t)hedge_ms * 1000 < until_us) {
+            until_us = start_us + (int64_t)hedge_ms * 1000;
+        }
+        
+        if (xQueueReceive(lane_result_queue, &result, pdMS_TO_TICKS((until_us - now_us) / 1000) + 1) != pdTRUE) {
+            continue;
+        }
+        
+        lane_account(&result);
+        if (result.generation != generation) {
+            continue;
+        }
+        
+        running--;
+        last = result;
+        if (result.success) {
+            success = true;
+            break;
+        }
+        
+        // Primary failed before the hedge delay: fail over at once
+        if (secondary) {
+            ESP_LOGW(TAG, "Failing over to %s", lane_name(secondary));
+            fetch_stats.failover_count++;
+            lane_start(secondary, generation);
+            secondary = NULL;
+            running++;
+        }
+    }
+    
+    // Requests still running are abandoned, their results are discarded
+    if (success) {
+        ESP_LOGI(TAG, "HTTP GET successful (%s), publishing data...", lane_name(&fetch_lanes[last.lane]));
+        publish_result(&fetch_lanes[last.lane].decoder.result);
+        fetch_stats.success_count++;
+        metrics_counter_inc(&fetch_success_metric);
+        if (&fetch_lanes[last.lane] != primary) {
+            fetch_stats.secondary_wins++;
         }
     } else {
-        ESP_LOGE(TAG, "HTTP GET error: %s", esp_err_to_name(err));
+        fetch_stats.failure_count++;
+        metrics_counter_inc(&fetch_failure_metric);
+    }
+    
+    fetch_stats.last_endpoint = last.lane;
+    fetch_stats.last_conn_type = last.conn_type;
+    fetch_stats.last_fetch_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    metrics_observe(&fetch_duration_metric, fetch_stats.last_fetch_ms);
+    fetch_stats.last_body_bytes = last.body_bytes;
+    fetch_stats.last_decode_us = last.decode_us;
+    fetch_stats.timeout_ms = weather_rtt_timeout_ms(&fetch_lanes[0].rtt);
+    fetch_stats.hedge_delay_ms = (WEATHER_ENDPOINT_COUNT > 1) ? lane_hedge_delay(&fetch_lanes[0]) : 0;
+    fetch_stats.tls_trust = fetch_lanes[0].trust;
+    
+    ESP_LOGI(TAG, "Fetch took %lu ms (%s, %s), %s body %lu bytes decoded in %lu us",
+             (unsigned long)fetch_stats.last_fetch_ms, lane_name(&fetch_lanes[last.lane]),
+             weather_client_conn_type_str(last.conn_type), WEATHER_API_FORMAT_NAME,
+             (unsigned long)last.body_bytes, (unsigned long)last.decode_us);
+    
+    // Trace of the answering request; a fetch that got no answer at all only has a total
+    if (last.trace.measured == 0) {
+        last.trace.endpoint = last.lane;
+        last.trace.phase_us[WEATHER_PHASE_TOTAL] = fetch_stats.last_fetch_ms * 1000;
+        last.trace.measured = (1u << WEATHER_PHASE_TOTAL);
     }
+    last.trace.time = (uint32_t)time(NULL);
+    weather_trace_add(&fetch_trace, &last.trace);
+    snapshot_write(&fetch_trace_snapshot, &fetch_trace);
     
-    esp_http_client_cleanup(client);
+    ESP_LOGI(TAG, "Phases (us): dns %lu, connect %lu, ttfb %lu, transfer %lu, decode %lu",
+             (unsigned long)last.trace.phase_us[WEATHER_PHASE_DNS],
+             (unsigned long)last.trace.phase_us[WEATHER_PHASE_CONNECT],
+             (unsigned long)last.trace.phase_us[WEATHER_PHASE_TTFB],
+             (unsigned long)last.trace.phase_us[WEATHER_PHASE_TRANSFER],
+             (unsigned long)last.trace.phase_us[WEATHER_PHASE_DECODE]);
     
     // Turn off weather fetch LED
     led_set_weather_fetch(false);
@@ -165,27 +841,73 @@ static bool fetch_weather_data(void)
 static void weather_fetch_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "Weather fetch task started");
-    ESP_LOGI(TAG, "Location: Jakarta (Lat: %s, Lon: %s)", WEATHER_LATITUDE, WEATHER_LONGITUDE);
-    ESP_LOGI(TAG, "Fetch interval: %d seconds", WEATHER_FETCH_INTERVAL_MS / 1000);
+    for (size_t i = 0; i < WEATHER_STATION_COUNT; i++) {
+        ESP_LOGI(TAG, "Station %u: %s (Lat: %s, Lon: %s)", (unsigned)i, weather_stations[i].name,
+                 weather_stations[i].latitude, weather_stations[i].longitude);
+    }
+    ESP_LOGI(TAG, "Fetch interval: %d seconds, sample interval: %d seconds",
+             WEATHER_FETCH_INTERVAL_MS / 1000, WEATHER_SAMPLE_INTERVAL_MS / 1000);
     
-    // Initial delay to let WiFi stabilize
-    vTaskDelay(pdMS_TO_TICKS(5000));
+#if WEATHER_TLS_BENCHMARK
+    weather_tls_benchmark(fetch_lanes[0].url);
+#endif
     
-    // Fetch weather immediately on start
-    fetch_weather_data();
+    // First fetch is due immediately; if the network is not ready yet,
+    // backoff retries it within seconds
+    const weather_sched_config_t config = {
+        .fetch_interval_ms = WEATHER_FETCH_INTERVAL_MS,
+        .sample_interval_ms = WEATHER_SAMPLE_INTERVAL_MS,
+        .align_period_s = WEATHER_MODEL_UPDATE_PERIOD_S,
+        .align_delay_s = WEATHER_MODEL_UPDATE_DELAY_S,
+        .backoff_min_ms = WEATHER_BACKOFF_MIN_MS,
+        .backoff_max_ms = WEATHER_BACKOFF_MAX_MS,
+        .max_age_ms = (WEATHER_FORECAST_HOURS - 1) * 3600000u,
+        .trigger_spacing_ms = WEATHER_TRIGGER_SPACING_MS,
+    };
+    weather_sched_init(&fetch_sched, &config, esp_timer_get_time() / 1000, esp_random());
     
     while (is_running) {
-        // Wait for next fetch interval
-        vTaskDelay(pdMS_TO_TICKS(WEATHER_FETCH_INTERVAL_MS));
+        uint32_t wait_ms = 0;
         
-        // Fetch weather data
-        if (!fetch_weather_data()) {
-            ESP_LOGW(TAG, "Weather fetch failed, will retry in %d seconds", 
-                     WEATHER_RETRY_INTERVAL_MS / 1000);
-            
-            // Retry after shorter interval
-            vTaskDelay(pdMS_TO_TICKS(WEATHER_RETRY_INTERVAL_MS));
+        switch (weather_sched_next(&fetch_sched, esp_timer_get_time() / 1000, &wait_ms)) {
+            case WEATHER_SCHED_FETCH: {
+                bool success = fetch_weather_data();
+                weather_sched_fetch_done(&fetch_sched, esp_timer_get_time() / 1000, time(NULL), success);
+                if (!success) {
+                    ESP_LOGW(TAG, "Weather fetch failed (%lu in a row), retry in %lld ms",
+                             (unsigned long)fetch_sched.failures,
+                             (long long)(fetch_sched.next_fetch_ms - fetch_sched.last_fetch_ms));
+                }
+                break;
+            }
+                
+            case WEATHER_SCHED_SAMPLE:
+                // Between fetches the forecast cache supplies hourly samples
+                record_forecast_samples();
+                weather_sched_sample_done(&fetch_sched, esp_timer_get_time() / 1000);
+                break;
+                
+            default: {
+                // Sleep until the next action or a notification
+                uint32_t bits = 0;
+                if (xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(wait_ms)) == pdTRUE &&
+                    (bits & WEATHER_NOTIFY_FETCH)) {
+                    int64_t now_ms = esp_timer_get_time() / 1000;
+                    weather_sched_request(&fetch_sched, now_ms, now_ms);
+                }
+                break;
+            }
         }
+        
+        fetch_stats.consecutive_failures = fetch_sched.failures;
+        fetch_stats.triggers = fetch_sched.triggers;
+        fetch_stats.collapsed_triggers = fetch_sched.collapsed;
+        
+        fetch_status_t status = {
+            .stats = fetch_stats,
+            .next_fetch_ms = fetch_sched.next_fetch_ms,
+        };
+        snapshot_write(&fetch_status_snapshot, &status);
     }
     
     ESP_LOGI(TAG, "Weather fetch task stopped");
@@ -193,12 +915,104 @@ static void weather_fetch_task(void *pvParameters)
     vTaskDelete(NULL);
 }
 
+/**
+ * Feed one logged sample into the history store
+ */
+static bool replay_log_record(const weather_log_record_t *record, void *ctx)
+{
+    int16_t temperature;
+    uint16_t humidity;
+    weather_log_record_values(record, &temperature, &humidity);
+    
+    if (record->station < WEATHER_STATION_COUNT) {
+        weather_metrics_add(&station_metrics[record->station], record->timestamp, temperature, humidity);
+    }
+    if (record->station < WEATHER_HISTORY_STATIONS) {
+        weather_history_add(&station_history[record->station], record->timestamp, temperature, humidity);
+    }
+    return true;
+}
+
 /**
  * Initialize weather client
  */
 void weather_client_init(void)
 {
-    ESP_LOGI(TAG, "Weather client initialized");
+    // Request lanes: URL, latency estimator and task per endpoint
+    if (lane_result_queue == NULL) {
+        lane_result_queue = xQueueCreate(WEATHER_ENDPOINT_COUNT, sizeof(lane_result_t));
+        
+        weather_tls_trust_t trust = WEATHER_TLS_TRUST_MODE;
+        if (trust == WEATHER_TLS_TRUST_PINNED && weather_tls_init() != ESP_OK) {
+            ESP_LOGW(TAG, "No usable pinned trust anchors, using the certificate bundle");
+            trust = WEATHER_TLS_TRUST_BUNDLE;
+        }
+        fetch_stats.tls_trust = trust;
+        
+        metrics_register(&fetch_success_metric);
+        metrics_register(&fetch_failure_metric);
+        metrics_register(&fetch_duration_metric);
+        
+        for (size_t i = 0; i < WEATHER_ENDPOINT_COUNT; i++) {
+            fetch_lane_t *lane = &fetch_lanes[i];
+            lane->endpoint = &weather_endpoints[i];
+            lane->trust = trust;
+            weather_rtt_init(&lane->rtt, WEATHER_TIMEOUT_INITIAL_MS, WEATHER_TIMEOUT_MIN_MS, WEATHER_TIMEOUT_MAX_MS);
+            
+            if (!lane->endpoint->provider->build_url(lane->endpoint->base_url, weather_stations,
+                                                     WEATHER_STATION_COUNT, lane->url, sizeof(lane->url))) {
+                ESP_LOGE(TAG, "Request URL too long for %u stations", (unsigned)WEATHER_STATION_COUNT);
+            }
+            
+            const char *host = strstr(lane->url, "://");
+            host = host ? host + 3 : lane->url;
+            size_t host_len = strcspn(host, ":/?");
+            if (host_len < sizeof(lane->host)) {
+                memcpy(lane->host, host, host_len);
+                lane->host[host_len] = '\0';
+            }
+            
+            xTaskCreate(fetch_lane_task, i ? "weather_hedge" : "weather_req", 4096, lane, 5, &lane->task);
+            ESP_LOGI(TAG, "Endpoint %u (%s): %s, %s", (unsigned)i, lane_name(lane),
+                     lane->endpoint->provider->name, lane->endpoint->base_url);
+        }
+    }
+    
+    if (station_snapshot[0].data == NULL) {
+        for (size_t i = 0; i < WEATHER_STATION_COUNT; i++) {
+            snapshot_init(&station_snapshot[i], &station_state[i], sizeof(station_state[i]));
+        }
+    }
+    
+    if (history_mutex == NULL) {
+        history_mutex = xSemaphoreCreateMutex();
+        for (size_t i = 0; i < WEATHER_HISTORY_STATIONS; i++) {
+            weather_history_init(&station_history[i]);
+        }
+        for (size_t i = 0; i < WEATHER_STATION_COUNT; i++) {
+            weather_metrics_init(&station_metrics[i]);
+        }
+        ESP_LOGI(TAG, "History store: %u stations, %u bytes", (unsigned)WEATHER_HISTORY_STATIONS,
+                 (unsigned)sizeof(station_history));
+        
+        // Rebuild in-RAM history from the flash log
+        if (weather_log_init() == ESP_OK) {
+            xSemaphoreTake(history_mutex, portMAX_DELAY);
+            size_t replayed = weather_log_iterate(0, UINT32_MAX, replay_log_record, NULL);
+            xSemaphoreGive(history_mutex);
+            ESP_LOGI(TAG, "Replayed %u logged samples", (unsigned)replayed);
+            
+            // Windows of the last 24 hours are available before the first fetch
+            for (size_t i = 0; i < WEATHER_STATION_COUNT; i++) {
+                station_state_t state;
+                snapshot_read(&station_snapshot[i], &state);
+                weather_metrics_get(&station_metrics[i], &state.current.window_1h, &state.current.window_24h);
+                snapshot_write(&station_snapshot[i], &state);
+            }
+        }
+    }
+    
+    ESP_LOGI(TAG, "Weather client initialized (%u stations)", (unsigned)WEATHER_STATION_COUNT);
 }
 
 /**
@@ -213,6 +1027,12 @@ void weather_client_start(void)
     
     is_running = true;
     
+    // A stopped task still finishing its fetch simply keeps running
+    if (weather_task_handle) {
+        ESP_LOGI(TAG, "Weather client resumed");
+        return;
+    }
+    
     xTaskCreate(
         weather_fetch_task,
         "weather_fetch",
@@ -236,25 +1056,107 @@ void weather_client_stop(void)
     
     is_running = false;
     
+    // The task leaves its loop after the current fetch
     if (weather_task_handle) {
-        vTaskDelete(weather_task_handle);
-        weather_task_handle = NULL;
+        xTaskNotify(weather_task_handle, WEATHER_NOTIFY_STOP, eSetBits);
     }
     
     ESP_LOGI(TAG, "Weather client stopped");
 }
 
 /**
- * Get latest weather data
+ * Get latest weather data (primary station)
  */
 bool weather_client_get_data(weather_data_t *data)
 {
-    if (!data) {
+    return weather_client_get_station_data(0, data);
+}
+
+/**
+ * Get latest weather data for a station
+ */
+bool weather_client_get_station_data(size_t station, weather_data_t *data)
+{
+    if (!data || station >= WEATHER_STATION_COUNT) {
         return false;
     }
     
-    *data = current_weather;
-    return current_weather.is_valid;
+    if (station_snapshot[station].data == NULL) {
+        memset(data, 0, sizeof(*data));
+        return false;
+    }
+    
+    station_state_t state;
+    snapshot_read(&station_snapshot[station], &state);
+    *data = state.current;
+    data->is_interpolated = false;
+    
+    int16_t temperature;
+    uint16_t humidity;
+    if (data->is_valid && forecast_interpolate(&state.forecast, time(NULL), &temperature, &humidity)) {
+        data->temperature = temperature;
+        data->humidity = humidity;
+        data->is_interpolated = true;
+        
+        // Derived values follow the interpolated reading
+        fill_derived(data);
+    }
+    
+    return data->is_valid;
+}
+
+/**
+ * Query station history
+ */
+size_t weather_client_get_history(size_t station, weather_history_tier_t tier,
+                                  uint32_t from, uint32_t to,
+                                  weather_history_agg_t *out, size_t max_out)
+{
+    if (!out || station >= WEATHER_HISTORY_STATIONS || !history_mutex) {
+        return 0;
+    }
+    
+    xSemaphoreTake(history_mutex, portMAX_DELAY);
+    size_t n = weather_history_query(&station_history[station], tier, from, to, out, max_out);
+    xSemaphoreGive(history_mutex);
+    
+    return n;
+}
+
+/**
+ * Get number of stations
+ */
+size_t weather_client_get_station_count(void)
+{
+    return WEATHER_STATION_COUNT;
+}
+
+/**
+ * Get station name
+ */
+const char* weather_client_get_station_name(size_t station)
+{
+    if (station >= WEATHER_STATION_COUNT) {
+        return NULL;
+    }
+    return weather_stations[station].name;
+}
+
+/**
+ * Find station by name
+ */
+int weather_client_find_station(const char *name)
+{
+    if (!name) {
+        return -1;
+    }
+    
+    for (size_t i = 0; i < WEATHER_STATION_COUNT; i++) {
+        if (strcasecmp(weather_stations[i].name, name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
 }
 
 /**
@@ -263,17 +1165,81 @@ bool weather_client_get_data(weather_data_t *data)
 void weather_client_fetch_now(void)
 {
     if (is_running) {
-        // Trigger immediate fetch by resuming task
+        // Wake the fetch task; pending requests collapse into one notification
         if (weather_task_handle) {
-            vTaskResume(weather_task_handle);
+            xTaskNotify(weather_task_handle, WEATHER_NOTIFY_FETCH, eSetBits);
         }
     }
 }
 
+/**
+ * Get data version
+ */
+uint32_t weather_client_get_version(void)
+{
+    uint32_t version = 0;
+    for (size_t i = 0; i < WEATHER_STATION_COUNT; i++) {
+        version += snapshot_version(&station_snapshot[i]);
+    }
+    return version;
+}
+
 /**
  * Check if running
  */
 bool weather_client_is_running(void)
 {
     return is_running;
-}
\ No newline at end of file
+}
+
+/**
+ * Get fetch statistics
+ */
+bool weather_client_get_fetch_stats(weather_fetch_stats_t *stats)
+{
+    if (!stats) {
+        return false;
+    }
+    
+    fetch_status_t status;
+    snapshot_read(&fetch_status_snapshot, &status);
+    *stats = status.stats;
+    
+    int64_t remaining_ms = status.next_fetch_ms - esp_timer_get_time() / 1000;
+    stats->next_fetch_in_s = (remaining_ms > 0) ? (uint32_t)(remaining_ms / 1000) : 0;
+    return true;
+}
+
+/**
+ * Get fetch phase traces
+ */
+bool weather_client_get_trace(weather_trace_t *trace)
+{
+    if (!trace) {
+        return false;
+    }
+    
+    snapshot_read(&fetch_trace_snapshot, trace);
+    return true;
+}
+
+/**
+ * Connection type name
+ */
+const char* weather_client_conn_type_str(weather_conn_type_t type)
+{
+    switch (type) {
+        case WEATHER_CONN_REUSED:  return "reused";
+        case WEATHER_CONN_RESUMED: return "resumed";
+        case WEATHER_CONN_FULL:    return "full";
+        default:                   return "none";
+    }
+}
+
+/**
+ * Trust mode name
+ */
+const char* weather_client_tls_trust_str(weather_tls_trust_t trust)
+{
+    return (trust == WEATHER_TLS_TRUST_PINNED) ? "pinned" : "bundle";
+}
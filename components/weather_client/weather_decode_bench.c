@@ -0,0 +1,178 @@
+#include "weather_client.h"
+
+#if WEATHER_DECODE_BENCHMARK
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cJSON.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "fixed_point.h"
+#include "heap_stats.h"
+#include "weather_provider.h"
+#include "weather_tls.h"
+
+#define BENCH_CHUNK_LEN     512     // Body arrives in chunks of about this size
+
+static const char *TAG = "decode_bench";
+
+// Batch response for three stations in both formats (host_test/data, the .fb
+// body is tools/weather_fb_encode.py of the .json body)
+extern const char batch_json_start[] asm("_binary_open_meteo_batch_json_start");
+extern const char batch_json_end[] asm("_binary_open_meteo_batch_json_end");
+extern const char batch_fb_start[] asm("_binary_open_meteo_batch_fb_start");
+extern const char batch_fb_end[] asm("_binary_open_meteo_batch_fb_end");
+
+static weather_decoder_t bench_decoder;
+
+/**
+ * Store a cJSON number as fixed point (the double is what cJSON parsed)
+ */
+static int32_t cjson_fixed(const cJSON *item, int decimals)
+{
+    static const double scale[] = {1, 10, 100, 1000};
+    return (int32_t)lround(item->valuedouble * scale[decimals]);
+}
+
+/**
+ * Whole body through a cJSON tree, as the client decoded before the
+ * streaming parser (the body buffered in full, then parsed)
+ */
+static bool decode_cjson(const char *body, size_t len)
+{
+    weather_result_t *result = &bench_decoder.result;
+    memset(result, 0, sizeof(*result));
+
+    cJSON *root = cJSON_ParseWithLength(body, len);
+    if (!cJSON_IsArray(root)) {
+        cJSON_Delete(root);
+        return false;
+    }
+
+    size_t station = 0;
+    const cJSON *location;
+    cJSON_ArrayForEach(location, root) {
+        if (station >= WEATHER_STATION_COUNT) {
+            break;
+        }
+        const cJSON *current = cJSON_GetObjectItem(location, "current");
+        const cJSON *temp = cJSON_GetObjectItem(current, "temperature_2m");
+        const cJSON *humidity = cJSON_GetObjectItem(current, "relative_humidity_2m");
+        if (cJSON_IsNumber(temp) && cJSON_IsNumber(humidity)) {
+            result->current[station].temperature = (int16_t)cjson_fixed(temp, FIXED_TEMP_DECIMALS);
+            result->current[station].humidity = (uint16_t)cjson_fixed(humidity, FIXED_HUM_DECIMALS);
+            result->fields[station] = (1u << WEATHER_FIELD_COUNT) - 1;
+        }
+
+        const cJSON *hourly = cJSON_GetObjectItem(location, "hourly");
+        const cJSON *times = cJSON_GetObjectItem(hourly, "time");
+        const cJSON *temps = cJSON_GetObjectItem(hourly, "temperature_2m");
+        const cJSON *hums = cJSON_GetObjectItem(hourly, "relative_humidity_2m");
+        weather_forecast_t *forecast = &result->forecast[station];
+        for (int i = 0; i < WEATHER_FORECAST_SLOTS; i++) {
+            const cJSON *t = cJSON_GetArrayItem(times, i);
+            const cJSON *tv = cJSON_GetArrayItem(temps, i);
+            const cJSON *hv = cJSON_GetArrayItem(hums, i);
+            if (!cJSON_IsNumber(t) || !cJSON_IsNumber(tv) || !cJSON_IsNumber(hv)) {
+                break;
+            }
+            if (i == 0) {
+                forecast->start = (uint32_t)t->valuedouble;
+            }
+            forecast->temperature[i] = (int16_t)cjson_fixed(tv, FIXED_TEMP_DECIMALS);
+            forecast->humidity[i] = (uint16_t)cjson_fixed(hv, FIXED_HUM_DECIMALS);
+            forecast->count = (uint8_t)(i + 1);
+        }
+        station++;
+    }
+
+    cJSON_Delete(root);
+    return station > 0;
+}
+
+/**
+ * Body fed in chunks through the Open-Meteo decoder
+ */
+static bool decode_stream(const char *body, size_t len, bool flatbuffers)
+{
+    weather_open_meteo_begin(&bench_decoder, flatbuffers);
+    for (size_t pos = 0; pos < len; pos += BENCH_CHUNK_LEN) {
+        size_t n = (len - pos < BENCH_CHUNK_LEN) ? len - pos : BENCH_CHUNK_LEN;
+        if (!weather_provider_open_meteo.feed(&bench_decoder, body + pos, n)) {
+            return false;
+        }
+    }
+    return weather_provider_open_meteo.finish(&bench_decoder);
+}
+
+static bool decode_json(const char *body, size_t len)
+{
+    return decode_stream(body, len, false);
+}
+
+static bool decode_fb(const char *body, size_t len)
+{
+    return decode_stream(body, len, true);
+}
+
+/**
+ * Run one path, log cycles, heap traffic and peak heap per decode
+ */
+static void bench_path(const char *name, bool (*fn)(const char *, size_t), const char *body, size_t len,
+                       size_t state)
+{
+    // Warm up caches before measuring
+    if (!fn(body, len)) {
+        ESP_LOGW(TAG, "%-6s  decode failed", name);
+        return;
+    }
+
+    heap_stats_t before;
+    heap_stats_t after;
+    weather_tls_heap_probe_t probe;
+    uint32_t peak_heap = 0;
+    uint32_t total_cycles = 0;
+    uint32_t max_cycles = 0;
+
+    heap_stats_get(&before);
+    for (int i = 0; i < WEATHER_DECODE_BENCHMARK_RUNS; i++) {
+        weather_tls_heap_probe_start(&probe);
+        uint32_t start = esp_cpu_get_cycle_count();
+        fn(body, len);
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        uint32_t heap = weather_tls_heap_probe_stop(&probe);
+
+        total_cycles += cycles;
+        if (cycles > max_cycles) {
+            max_cycles = cycles;
+        }
+        if (heap > peak_heap) {
+            peak_heap = heap;
+        }
+    }
+    heap_stats_get(&after);
+
+    ESP_LOGI(TAG, "%-6s  %5u body bytes  %8lu cycles (max %8lu)  %4lu allocs  %6lu peak heap  %5u state bytes",
+             name, (unsigned)len, (unsigned long)(total_cycles / WEATHER_DECODE_BENCHMARK_RUNS),
+             (unsigned long)max_cycles,
+             (unsigned long)((after.allocs - before.allocs) / WEATHER_DECODE_BENCHMARK_RUNS),
+             (unsigned long)peak_heap, (unsigned)state);
+}
+
+/**
+ * Run benchmark
+ */
+void weather_decode_benchmark(void)
+{
+    size_t json_len = (size_t)(batch_json_end - batch_json_start);
+    size_t fb_len = (size_t)(batch_fb_end - batch_fb_start);
+
+    ESP_LOGI(TAG, "Batch response of 3 stations, mean of %d decodes", WEATHER_DECODE_BENCHMARK_RUNS);
+    // The cJSON path needs the whole body in RAM before parsing
+    bench_path("cJSON", decode_cjson, batch_json_start, json_len, json_len);
+    bench_path("json", decode_json, batch_json_start, json_len,
+               sizeof(weather_json_parser_t) + sizeof(weather_result_t));
+    bench_path("fb", decode_fb, batch_fb_start, fb_len,
+               sizeof(weather_fb_stream_t) + sizeof(weather_result_t));
+}
+#endif
@@ -0,0 +1,249 @@
+#include "weather_fb.h"
+#include <string.h>
+
+// Field slots from the Open-Meteo SDK schema (openmeteo_sdk/fbs/weather_api.fbs)
+#define RESPONSE_FIELD_CURRENT      9   // WeatherApiResponse.current
+#define RESPONSE_FIELD_HOURLY       11  // WeatherApiResponse.hourly
+#define VARIABLES_FIELD_TIME        0   // VariablesWithTime.time
+#define VARIABLES_FIELD_INTERVAL    2   // VariablesWithTime.interval
+#define VARIABLES_FIELD_VARIABLES   3   // VariablesWithTime.variables
+#define VARIABLE_FIELD_VALUE        2   // VariableWithValues.value
+#define VARIABLE_FIELD_VALUES       3   // VariableWithValues.values
+
+// FlatBuffers data is little endian, like the ESP32-C6, so values are read
+// with memcpy directly from the message. Every offset is bounds checked.
+
+static bool read_bytes(const uint8_t *msg, size_t len, size_t pos, void *out, size_t n)
+{
+    if (pos > len || len - pos < n) {
+        return false;
+    }
+    memcpy(out, msg + pos, n);
+    return true;
+}
+
+/**
+ * Locate a table field
+ * @return false if the field is absent (scalars then take their default)
+ */
+static bool table_field(const uint8_t *msg, size_t len, size_t table, int slot, size_t *pos)
+{
+    int32_t vtable_offset;
+    uint16_t vtable_size;
+    uint16_t field_offset;
+
+    if (!read_bytes(msg, len, table, &vtable_offset, sizeof(vtable_offset))) {
+        return false;
+    }
+
+    int64_t vtable = (int64_t)table - vtable_offset;
+    if (vtable < 0 || !read_bytes(msg, len, (size_t)vtable, &vtable_size, sizeof(vtable_size))) {
+        return false;
+    }
+
+    size_t entry = 4 + 2 * (size_t)slot;
+    if (entry + 2 > vtable_size ||
+        !read_bytes(msg, len, (size_t)vtable + entry, &field_offset, sizeof(field_offset)) ||
+        field_offset == 0) {
+        return false;
+    }
+
+    *pos = table + field_offset;
+    return *pos < len;
+}
+
+/**
+ * Follow an offset (table, vector) stored at pos
+ */
+static bool follow(const uint8_t *msg, size_t len, size_t pos, size_t *target)
+{
+    uint32_t offset;
+    if (!read_bytes(msg, len, pos, &offset, sizeof(offset))) {
+        return false;
+    }
+    *target = pos + offset;
+    return *target < len;
+}
+
+/**
+ * Locate a VariablesWithTime table of the response ("current", "hourly")
+ */
+static bool block_table(const uint8_t *msg, size_t len, int slot, size_t *table)
+{
+    size_t root;
+    size_t pos;
+    return follow(msg, len, 0, &root) &&
+           table_field(msg, len, root, slot, &pos) &&
+           follow(msg, len, pos, table);
+}
+
+/**
+ * Locate the n-th VariableWithValues table of a block (variables are in request order)
+ */
+static bool block_variable(const uint8_t *msg, size_t len, int slot, size_t variable, size_t *element)
+{
+    size_t table;
+    size_t pos;
+    size_t vector;
+    uint32_t count;
+
+    return block_table(msg, len, slot, &table) &&
+           table_field(msg, len, table, VARIABLES_FIELD_VARIABLES, &pos) &&
+           follow(msg, len, pos, &vector) &&
+           read_bytes(msg, len, vector, &count, sizeof(count)) &&
+           variable < count &&
+           follow(msg, len, vector + 4 + 4 * variable, element);
+}
+
+/**
+ * Reset stream
+ */
+void weather_fb_stream_init(weather_fb_stream_t *stream, weather_fb_message_cb_t message_cb, void *ctx)
+{
+    stream->msg_len = 0;
+    stream->received = 0;
+    stream->in_message = false;
+    stream->error = false;
+    stream->index = 0;
+    stream->message_cb = message_cb;
+    stream->ctx = ctx;
+}
+
+/**
+ * Feed a chunk
+ */
+bool weather_fb_stream_feed(weather_fb_stream_t *stream, const uint8_t *data, size_t len)
+{
+    while (len > 0 && !stream->error) {
+        if (!stream->in_message) {
+            // Collect the 4-byte little endian size prefix
+            stream->prefix[stream->received++] = *data++;
+            len--;
+            if (stream->received == sizeof(stream->prefix)) {
+                memcpy(&stream->msg_len, stream->prefix, sizeof(stream->msg_len));
+                if (stream->msg_len == 0 || stream->msg_len > WEATHER_FB_MAX_MESSAGE_LEN) {
+                    stream->error = true;
+                    break;
+                }
+                stream->in_message = true;
+                stream->received = 0;
+            }
+            continue;
+        }
+
+        size_t n = stream->msg_len - stream->received;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(stream->buf + stream->received, data, n);
+        stream->received += n;
+        data += n;
+        len -= n;
+
+        if (stream->received == stream->msg_len) {
+            if (stream->message_cb) {
+                stream->message_cb(stream->buf, stream->msg_len, stream->index, stream->ctx);
+            }
+            stream->index++;
+            stream->in_message = false;
+            stream->received = 0;
+        }
+    }
+    return !stream->error;
+}
+
+/**
+ * Signal end of input
+ */
+bool weather_fb_stream_finish(weather_fb_stream_t *stream)
+{
+    return !stream->error && !stream->in_message && stream->received == 0 && stream->index > 0;
+}
+
+/**
+ * Read current value
+ */
+bool weather_fb_current_value(const uint8_t *msg, size_t len, size_t variable, uint32_t *bits)
+{
+    size_t element;
+    size_t pos;
+
+    if (!block_variable(msg, len, RESPONSE_FIELD_CURRENT, variable, &element)) {
+        return false;
+    }
+
+    *bits = 0;
+    if (table_field(msg, len, element, VARIABLE_FIELD_VALUE, &pos)) {
+        return read_bytes(msg, len, pos, bits, sizeof(*bits));
+    }
+    return true;
+}
+
+/**
+ * Read current time
+ */
+bool weather_fb_current_time(const uint8_t *msg, size_t len, int64_t *time)
+{
+    size_t table;
+    size_t pos;
+
+    if (!block_table(msg, len, RESPONSE_FIELD_CURRENT, &table)) {
+        return false;
+    }
+
+    *time = 0;
+    if (table_field(msg, len, table, VARIABLES_FIELD_TIME, &pos)) {
+        return read_bytes(msg, len, pos, time, sizeof(*time));
+    }
+    return true;
+}
+
+/**
+ * Read hourly time axis
+ */
+bool weather_fb_hourly_time(const uint8_t *msg, size_t len, int64_t *start, int32_t *interval)
+{
+    size_t table;
+    size_t pos;
+
+    if (!block_table(msg, len, RESPONSE_FIELD_HOURLY, &table)) {
+        return false;
+    }
+
+    *start = 0;
+    *interval = 0;
+    if (table_field(msg, len, table, VARIABLES_FIELD_TIME, &pos) &&
+        !read_bytes(msg, len, pos, start, sizeof(*start))) {
+        return false;
+    }
+    if (table_field(msg, len, table, VARIABLES_FIELD_INTERVAL, &pos) &&
+        !read_bytes(msg, len, pos, interval, sizeof(*interval))) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Copy hourly values
+ */
+size_t weather_fb_hourly_values(const uint8_t *msg, size_t len, size_t variable,
+                                uint32_t *out, size_t max_out)
+{
+    size_t element;
+    size_t pos;
+    size_t vector;
+    uint32_t count;
+
+    if (!block_variable(msg, len, RESPONSE_FIELD_HOURLY, variable, &element) ||
+        !table_field(msg, len, element, VARIABLE_FIELD_VALUES, &pos) ||
+        !follow(msg, len, pos, &vector) ||
+        !read_bytes(msg, len, vector, &count, sizeof(count))) {
+        return 0;
+    }
+
+    size_t n = (count < max_out) ? count : max_out;
+    if (!read_bytes(msg, len, vector + 4, out, n * sizeof(*out))) {
+        return 0;
+    }
+    return n;
+}
@@ -0,0 +1,358 @@
+#include "weather_json.h"
+#include <string.h>
+
+// Tokenizer states
+enum {
+    ST_VALUE = 0,       // Expect any value
+    ST_ARRAY_FIRST,     // Expect value or ']'
+    ST_OBJECT_FIRST,    // Expect key or '}'
+    ST_KEY,             // Expect key
+    ST_COLON,           // Expect ':'
+    ST_AFTER_VALUE,     // Expect ',' or closing bracket
+    ST_STRING,          // Inside string (key or value)
+    ST_NUMBER,          // Inside number
+    ST_LITERAL,         // Inside true/false/null
+    ST_DONE,            // Top-level value complete
+    ST_ERROR
+};
+
+// escape_left value while waiting for the character after a backslash
+#define ESCAPE_CODE 5
+
+static inline bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool is_number_char(char c)
+{
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+/**
+ * Start collecting a scalar token
+ */
+static void token_reset(weather_json_parser_t *p)
+{
+    p->token_len = 0;
+    p->token_overflow = false;
+    p->token[0] = '\0';
+}
+
+/**
+ * Append one character to the current token
+ */
+static void token_append(weather_json_parser_t *p, char c)
+{
+    if (p->token_len < WEATHER_JSON_MAX_TOKEN_LEN) {
+        p->token[p->token_len++] = c;
+        p->token[p->token_len] = '\0';
+    } else {
+        p->token_overflow = true;
+    }
+}
+
+/**
+ * A value has been fully consumed
+ */
+static void value_done(weather_json_parser_t *p)
+{
+    p->state = (p->depth == 0) ? ST_DONE : ST_AFTER_VALUE;
+}
+
+/**
+ * Report the current scalar token to the user callback
+ */
+static void emit_value(weather_json_parser_t *p, weather_json_type_t type)
+{
+    if (!p->token_overflow && p->value_cb) {
+        p->value_cb(p, type, p->token, p->token_len, p->ctx);
+    }
+    value_done(p);
+}
+
+/**
+ * Finish a true/false/null literal
+ */
+static bool finish_literal(weather_json_parser_t *p)
+{
+    if (strcmp(p->token, "true") == 0) {
+        emit_value(p, WEATHER_JSON_TRUE);
+    } else if (strcmp(p->token, "false") == 0) {
+        emit_value(p, WEATHER_JSON_FALSE);
+    } else if (strcmp(p->token, "null") == 0) {
+        emit_value(p, WEATHER_JSON_NULL);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Open an object or array
+ */
+static bool push_frame(weather_json_parser_t *p, bool is_array)
+{
+    if (p->depth >= WEATHER_JSON_MAX_DEPTH) {
+        return false;
+    }
+    weather_json_frame_t *frame = &p->stack[p->depth++];
+    frame->key[0] = '\0';
+    frame->index = is_array ? 0 : -1;
+    p->state = is_array ? ST_ARRAY_FIRST : ST_OBJECT_FIRST;
+    return true;
+}
+
+/**
+ * Close the innermost object or array
+ */
+static bool pop_frame(weather_json_parser_t *p, bool is_array)
+{
+    if (p->depth == 0 || (p->stack[p->depth - 1].index >= 0) != is_array) {
+        return false;
+    }
+    p->depth--;
+    value_done(p);
+    return true;
+}
+
+/**
+ * Start parsing a value at character c
+ */
+static bool begin_value(weather_json_parser_t *p, char c)
+{
+    if (c == '{') {
+        return push_frame(p, false);
+    }
+    if (c == '[') {
+        return push_frame(p, true);
+    }
+
+    token_reset(p);
+    if (c == '"') {
+        p->string_is_key = false;
+        p->escape_left = 0;
+        p->state = ST_STRING;
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        token_append(p, c);
+        p->state = ST_NUMBER;
+    } else if (c == 't' || c == 'f' || c == 'n') {
+        token_append(p, c);
+        p->state = ST_LITERAL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Process one character
+ * @return false on syntax error
+ */
+static bool step(weather_json_parser_t *p, char c)
+{
+    switch (p->state) {
+        case ST_STRING:
+            if (p->escape_left > 0) {
+                // Escapes are kept verbatim; "\u" consumes four more hex digits
+                token_append(p, c);
+                if (p->escape_left == ESCAPE_CODE) {
+                    p->escape_left = (c == 'u') ? 4 : 0;
+                } else {
+                    p->escape_left--;
+                }
+            } else if (c == '\\') {
+                token_append(p, c);
+                p->escape_left = ESCAPE_CODE;
+            } else if (c == '"') {
+                if (p->string_is_key) {
+                    weather_json_frame_t *frame = &p->stack[p->depth - 1];
+                    if (p->token_overflow || p->token_len >= WEATHER_JSON_MAX_KEY_LEN) {
+                        frame->key[0] = '\0';
+                    } else {
+                        memcpy(frame->key, p->token, p->token_len + 1);
+                    }
+                    p->state = ST_COLON;
+                } else {
+                    emit_value(p, WEATHER_JSON_STRING);
+                }
+            } else if ((unsigned char)c < 0x20) {
+                return false;
+            } else {
+                token_append(p, c);
+            }
+            return true;
+
+        case ST_NUMBER:
+            if (is_number_char(c)) {
+                token_append(p, c);
+                return true;
+            }
+            emit_value(p, WEATHER_JSON_NUMBER);
+            return step(p, c);
+
+        case ST_LITERAL:
+            if (c >= 'a' && c <= 'z') {
+                token_append(p, c);
+                return p->token_len <= 5;
+            }
+            if (!finish_literal(p)) {
+                return false;
+            }
+            return step(p, c);
+
+        default:
+            break;
+    }
+
+    if (is_space(c)) {
+        return true;
+    }
+
+    switch (p->state) {
+        case ST_VALUE:
+            return begin_value(p, c);
+
+        case ST_ARRAY_FIRST:
+            if (c == ']') {
+                return pop_frame(p, true);
+            }
+            return begin_value(p, c);
+
+        case ST_OBJECT_FIRST:
+            if (c == '}') {
+                return pop_frame(p, false);
+            }
+            // fall through
+        case ST_KEY:
+            if (c != '"') {
+                return false;
+            }
+            token_reset(p);
+            p->string_is_key = true;
+            p->escape_left = 0;
+            p->state = ST_STRING;
+            return true;
+
+        case ST_COLON:
+            if (c != ':') {
+                return false;
+            }
+            p->state = ST_VALUE;
+            return true;
+
+        case ST_AFTER_VALUE: {
+            weather_json_frame_t *frame = &p->stack[p->depth - 1];
+            if (c == ',') {
+                if (frame->index >= 0) {
+                    frame->index++;
+                    p->state = ST_VALUE;
+                } else {
+                    p->state = ST_KEY;
+                }
+                return true;
+            }
+            if (c == ']') {
+                return pop_frame(p, true);
+            }
+            if (c == '}') {
+                return pop_frame(p, false);
+            }
+            return false;
+        }
+
+        default:
+            // Trailing garbage after the top-level value
+            return false;
+    }
+}
+
+/**
+ * Reset parser
+ */
+void weather_json_init(weather_json_parser_t *parser, weather_json_value_cb_t value_cb, void *ctx)
+{
+    memset(parser, 0, sizeof(*parser));
+    parser->state = ST_VALUE;
+    parser->value_cb = value_cb;
+    parser->ctx = ctx;
+}
+
+/**
+ * Feed a chunk
+ */
+bool weather_json_feed(weather_json_parser_t *parser, const char *data, size_t len)
+{
+    for (size_t i = 0; i < len && parser->state != ST_ERROR; i++) {
+        if (!step(parser, data[i])) {
+            parser->state = ST_ERROR;
+        }
+    }
+    return parser->state != ST_ERROR;
+}
+
+/**
+ * Signal end of input
+ */
+bool weather_json_finish(weather_json_parser_t *parser)
+{
+    // A bare top-level number or literal is only terminated by end of input
+    if (parser->depth == 0) {
+        if (parser->state == ST_NUMBER) {
+            emit_value(parser, WEATHER_JSON_NUMBER);
+        } else if (parser->state == ST_LITERAL && !finish_literal(parser)) {
+            parser->state = ST_ERROR;
+        }
+    }
+    return parser->state == ST_DONE;
+}
+
+/**
+ * Match current path against pattern
+ */
+bool weather_json_match(const weather_json_parser_t *parser, const char *pattern)
+{
+    uint8_t level = 0;
+    const char *s = pattern;
+
+    while (*s) {
+        if (*s == '.') {
+            s++;
+            continue;
+        }
+        if (level >= parser->depth) {
+            return false;
+        }
+
+        const weather_json_frame_t *frame = &parser->stack[level++];
+        if (s[0] == '[' && s[1] == ']') {
+            if (frame->index < 0) {
+                return false;
+            }
+            s += 2;
+            continue;
+        }
+        if (frame->index >= 0) {
+            return false;
+        }
+
+        size_t n = strcspn(s, ".[");
+        if (strncmp(frame->key, s, n) != 0 || frame->key[n] != '\0') {
+            return false;
+        }
+        s += n;
+    }
+
+    return level == parser->depth;
+}
+
+/**
+ * Get array index at level
+ */
+int weather_json_index(const weather_json_parser_t *parser, uint8_t level)
+{
+    if (level >= parser->depth) {
+        return -1;
+    }
+    return parser->stack[level].index;
+}
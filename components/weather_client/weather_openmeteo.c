@@ -0,0 +1,283 @@
+#include "weather_provider.h"
+#include "fixed_point.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// JSON paths of the fields, in the order of the current= list in WEATHER_API_QUERY
+// (FlatBuffers responses are read by position). Paths are as understood by
+// weather_json_match: a single location returns an object, several return an array.
+static const struct {
+    const char *path;           // Single-location response
+    const char *batch_path;     // Multi-location response
+} weather_field_paths[WEATHER_FIELD_COUNT] = {
+    [WEATHER_FIELD_TEMPERATURE] = {"current.temperature_2m", "[].current.temperature_2m"},
+    [WEATHER_FIELD_HUMIDITY]    = {"current.relative_humidity_2m", "[].current.relative_humidity_2m"},
+};
+
+static const struct {
+    const char *path;
+    const char *batch_path;
+} weather_hourly_paths[WEATHER_HOURLY_COLUMNS] = {
+    [WEATHER_FIELD_TEMPERATURE] = {"hourly.temperature_2m[]", "[].hourly.temperature_2m[]"},
+    [WEATHER_FIELD_HUMIDITY]    = {"hourly.relative_humidity_2m[]", "[].hourly.relative_humidity_2m[]"},
+    [WEATHER_HOURLY_TIME]       = {"hourly.time[]", "[].hourly.time[]"},
+};
+
+// Fixed-point decimals of the fields (see fixed_point.h)
+static const int weather_field_decimals[WEATHER_FIELD_COUNT] = {
+    [WEATHER_FIELD_TEMPERATURE] = FIXED_TEMP_DECIMALS,
+    [WEATHER_FIELD_HUMIDITY]    = FIXED_HUM_DECIMALS,
+};
+
+/**
+ * Clamp temperature to the int16_t range
+ */
+static int16_t clamp_temperature(int32_t value)
+{
+    return (int16_t)((value < INT16_MIN) ? INT16_MIN : (value > INT16_MAX) ? INT16_MAX : value);
+}
+
+/**
+ * Clamp humidity to 0-100 %
+ */
+static uint16_t clamp_humidity(int32_t value)
+{
+    return (uint16_t)((value < 0) ? 0 : (value > 100 * FIXED_HUM_SCALE) ? 100 * FIXED_HUM_SCALE : value);
+}
+
+/**
+ * Store one extracted field (value in the field's fixed-point scale)
+ */
+static void store_field(weather_result_t *result, size_t station, weather_field_t field, int32_t value)
+{
+    switch (field) {
+        case WEATHER_FIELD_TEMPERATURE:
+            result->current[station].temperature = clamp_temperature(value);
+            break;
+        case WEATHER_FIELD_HUMIDITY:
+            result->current[station].humidity = clamp_humidity(value);
+            break;
+        default:
+            return;
+    }
+    result->fields[station] |= (1u << field);
+}
+
+/**
+ * Store one hourly value (columns must arrive in order, extra slots are dropped)
+ * @param value Fixed-point value, or unix time for the time column
+ */
+static void store_hourly(weather_result_t *result, size_t station, int column, size_t index, int64_t value)
+{
+    weather_forecast_t *forecast = &result->forecast[station];
+    uint8_t *len = &result->hourly_len[station][column];
+
+    if (index != *len || index >= WEATHER_FORECAST_SLOTS) {
+        return;
+    }
+
+    switch (column) {
+        case WEATHER_FIELD_TEMPERATURE:
+            forecast->temperature[index] = clamp_temperature((int32_t)value);
+            break;
+        case WEATHER_FIELD_HUMIDITY:
+            forecast->humidity[index] = clamp_humidity((int32_t)value);
+            break;
+        case WEATHER_HOURLY_TIME:
+            // Slots must be exactly one hour apart
+            if (index == 0) {
+                forecast->start = (uint32_t)value;
+            } else if ((uint32_t)value != forecast->start + index * 3600u) {
+                return;
+            }
+            break;
+        default:
+            return;
+    }
+    (*len)++;
+}
+
+/**
+ * FlatBuffers message callback - one message per station, values read in place
+ */
+static void weather_fb_message(const uint8_t *msg, size_t len, size_t index, void *ctx)
+{
+    weather_result_t *result = &((weather_decoder_t *)ctx)->result;
+
+    if (index >= WEATHER_STATION_COUNT) {
+        return;
+    }
+
+    for (int field = 0; field < WEATHER_FIELD_COUNT; field++) {
+        uint32_t bits;
+        int32_t value;
+        if (weather_fb_current_value(msg, len, field, &bits) &&
+            fixed_from_float_bits(bits, weather_field_decimals[field], &value)) {
+            store_field(result, index, (weather_field_t)field, value);
+        }
+    }
+
+    // Hourly block: regular time axis, one value vector per variable
+    int64_t start;
+    int32_t interval;
+    if (!weather_fb_hourly_time(msg, len, &start, &interval) || interval != 3600) {
+        return;
+    }
+
+    uint32_t values[WEATHER_FORECAST_SLOTS];
+    for (int field = 0; field < WEATHER_FIELD_COUNT; field++) {
+        size_t n = weather_fb_hourly_values(msg, len, field, values, WEATHER_FORECAST_SLOTS);
+        for (size_t i = 0; i < n; i++) {
+            int32_t value;
+            if (!fixed_from_float_bits(values[i], weather_field_decimals[field], &value)) {
+                break;
+            }
+            store_hourly(result, index, field, i, value);
+        }
+        if (field == 0) {
+            for (size_t i = 0; i < n; i++) {
+                store_hourly(result, index, WEATHER_HOURLY_TIME, i, start + (int64_t)i * interval);
+            }
+        }
+    }
+}
+
+/**
+ * JSON value callback - keep only the configured fields
+ */
+static void weather_json_value(const weather_json_parser_t *parser, weather_json_type_t type,
+                               const char *value, size_t len, void *ctx)
+{
+    weather_result_t *result = &((weather_decoder_t *)ctx)->result;
+
+    if (type != WEATHER_JSON_NUMBER) {
+        return;
+    }
+
+    // Station index is the position in the top-level array, if any
+    int station = weather_json_index(parser, 0);
+    bool batch = (station >= 0);
+    if (!batch) {
+        station = 0;
+    }
+    if (station >= (int)WEATHER_STATION_COUNT) {
+        return;
+    }
+
+    for (int field = 0; field < WEATHER_FIELD_COUNT; field++) {
+        const char *path = batch ? weather_field_paths[field].batch_path : weather_field_paths[field].path;
+        if (!weather_json_match(parser, path)) {
+            continue;
+        }
+
+        int32_t fixed;
+        if (fixed_parse(value, len, weather_field_decimals[field], &fixed)) {
+            store_field(result, station, (weather_field_t)field, fixed);
+        }
+        return;
+    }
+
+    // Hourly arrays: slot is the index in the innermost array
+    for (int column = 0; column < WEATHER_HOURLY_COLUMNS; column++) {
+        const char *path = batch ? weather_hourly_paths[column].batch_path : weather_hourly_paths[column].path;
+        if (!weather_json_match(parser, path)) {
+            continue;
+        }
+
+        size_t index = weather_json_index(parser, batch ? 3 : 2);
+        int32_t fixed;
+        if (column == WEATHER_HOURLY_TIME) {
+            store_hourly(result, station, column, index, (int64_t)strtoull(value, NULL, 10));
+        } else if (fixed_parse(value, len, weather_field_decimals[column], &fixed)) {
+            store_hourly(result, station, column, index, fixed);
+        }
+        return;
+    }
+}
+
+/**
+ * Build request URL with comma-separated coordinate lists
+ */
+static bool open_meteo_build_url(const char *base_url, const weather_station_t *stations, size_t count,
+                                 char *url, size_t size)
+{
+    size_t len = snprintf(url, size, "%s?latitude=", base_url);
+
+    for (size_t i = 0; i < count && len < size; i++) {
+        len += snprintf(url + len, size - len, "%s%s", i ? "," : "", stations[i].latitude);
+    }
+
+    if (len < size) {
+        len += snprintf(url + len, size - len, "&longitude=");
+    }
+
+    for (size_t i = 0; i < count && len < size; i++) {
+        len += snprintf(url + len, size - len, "%s%s", i ? "," : "", stations[i].longitude);
+    }
+
+    if (len < size) {
+        len += snprintf(url + len, size - len, "%s&forecast_hours=%d%s",
+                        WEATHER_API_QUERY, WEATHER_FORECAST_HOURS,
+                        WEATHER_API_USE_FLATBUFFERS ? "&format=flatbuffers" : "");
+    }
+
+    if (len >= size) {
+        url[0] = '\0';
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Reset decoder for a format
+ */
+void weather_open_meteo_begin(weather_decoder_t *decoder, bool flatbuffers)
+{
+    decoder->flatbuffers = flatbuffers;
+    if (flatbuffers) {
+        weather_fb_stream_init(&decoder->parser.fb, weather_fb_message, decoder);
+    } else {
+        weather_json_init(&decoder->parser.json, weather_json_value, decoder);
+    }
+    memset(&decoder->result, 0, sizeof(decoder->result));
+}
+
+/**
+ * Reset decoder for the configured format
+ */
+static void open_meteo_begin(weather_decoder_t *decoder)
+{
+    weather_open_meteo_begin(decoder, WEATHER_API_USE_FLATBUFFERS);
+}
+
+/**
+ * Decode body chunk
+ */
+static bool open_meteo_feed(weather_decoder_t *decoder, const char *data, size_t len)
+{
+    if (decoder->flatbuffers) {
+        return weather_fb_stream_feed(&decoder->parser.fb, (const uint8_t *)data, len);
+    }
+    return weather_json_feed(&decoder->parser.json, data, len);
+}
+
+/**
+ * End of body
+ */
+static bool open_meteo_finish(weather_decoder_t *decoder)
+{
+    if (decoder->flatbuffers) {
+        return weather_fb_stream_finish(&decoder->parser.fb);
+    }
+    return weather_json_finish(&decoder->parser.json);
+}
+
+const weather_provider_t weather_provider_open_meteo = {
+    .name = "open-meteo",
+    .build_url = open_meteo_build_url,
+    .begin = open_meteo_begin,
+    .feed = open_meteo_feed,
+    .finish = open_meteo_finish,
+};
@@ -0,0 +1,93 @@
+#include "weather_rtt.h"
+#include <string.h>
+
+/**
+ * Clamp timeout to the configured bounds
+ */
+static uint32_t clamp_timeout(const weather_rtt_t *rtt, uint64_t timeout_ms)
+{
+    if (timeout_ms < rtt->min_ms) {
+        return rtt->min_ms;
+    }
+    if (timeout_ms > rtt->max_ms) {
+        return rtt->max_ms;
+    }
+    return (uint32_t)timeout_ms;
+}
+
+/**
+ * Initialize estimator
+ */
+void weather_rtt_init(weather_rtt_t *rtt, uint32_t initial_ms, uint32_t min_ms, uint32_t max_ms)
+{
+    memset(rtt, 0, sizeof(*rtt));
+    rtt->min_ms = min_ms;
+    rtt->max_ms = max_ms;
+    rtt->timeout_ms = clamp_timeout(rtt, initial_ms);
+}
+
+/**
+ * Add a latency sample
+ */
+void weather_rtt_sample(weather_rtt_t *rtt, uint32_t latency_ms)
+{
+    if (rtt->srtt_ms == 0) {
+        rtt->srtt_ms = latency_ms ? latency_ms : 1;
+        rtt->rttvar_ms = latency_ms / 2;
+    } else {
+        uint32_t delta = (latency_ms > rtt->srtt_ms) ? latency_ms - rtt->srtt_ms : rtt->srtt_ms - latency_ms;
+        rtt->rttvar_ms = (3 * rtt->rttvar_ms + delta) / 4;
+        rtt->srtt_ms = (7 * rtt->srtt_ms + latency_ms) / 8;
+    }
+    rtt->timeout_ms = clamp_timeout(rtt, (uint64_t)rtt->srtt_ms + 4 * (uint64_t)rtt->rttvar_ms);
+
+    rtt->window[rtt->next] = (latency_ms > UINT16_MAX) ? UINT16_MAX : (uint16_t)latency_ms;
+    rtt->next = (rtt->next + 1) % WEATHER_RTT_WINDOW;
+    if (rtt->count < WEATHER_RTT_WINDOW) {
+        rtt->count++;
+    }
+}
+
+/**
+ * Report a timeout
+ */
+void weather_rtt_timeout(weather_rtt_t *rtt)
+{
+    rtt->timeout_ms = clamp_timeout(rtt, 2 * (uint64_t)rtt->timeout_ms);
+}
+
+/**
+ * Get timeout
+ */
+uint32_t weather_rtt_timeout_ms(const weather_rtt_t *rtt)
+{
+    return rtt->timeout_ms;
+}
+
+/**
+ * Get latency percentile (nearest rank)
+ */
+uint32_t weather_rtt_percentile(const weather_rtt_t *rtt, uint32_t percent)
+{
+    if (rtt->count < WEATHER_RTT_MIN_SAMPLES || percent == 0) {
+        return 0;
+    }
+
+    // Insertion sort of a copy, the window is small
+    uint16_t sorted[WEATHER_RTT_WINDOW];
+    for (uint8_t i = 0; i < rtt->count; i++) {
+        uint16_t value = rtt->window[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+
+    uint32_t rank = (percent * rtt->count + 99) / 100;
+    if (rank > rtt->count) {
+        rank = rtt->count;
+    }
+    return sorted[rank - 1];
+}
@@ -0,0 +1,170 @@
+#include "weather_sched.h"
+#include <string.h>
+
+// Wall clock is considered set after 2020-01-01
+#define WALL_CLOCK_VALID_S  1577836800LL
+
+/**
+ * Next jitter value (xorshift32)
+ */
+static uint32_t next_random(weather_sched_t *sched)
+{
+    uint32_t x = sched->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sched->rng = x;
+    return x;
+}
+
+/**
+ * Retry delay: exponential in the failure count, half fixed and half random
+ * so that devices failing together do not retry together
+ */
+static uint32_t backoff_delay(weather_sched_t *sched)
+{
+    uint64_t delay = sched->config.backoff_min_ms;
+    for (uint32_t i = 1; i < sched->failures && delay < sched->config.backoff_max_ms; i++) {
+        delay *= 2;
+    }
+    if (delay > sched->config.backoff_max_ms) {
+        delay = sched->config.backoff_max_ms;
+    }
+
+    uint32_t half = (uint32_t)(delay / 2);
+    return half + next_random(sched) % ((uint32_t)delay - half + 1);
+}
+
+/**
+ * Regular fetch time after a success
+ * With a valid wall clock the fetch lands a fixed delay after the last model
+ * update that falls within the interval, so each fetch picks up a new run.
+ */
+static int64_t regular_fetch_time(const weather_sched_t *sched, int64_t now_ms, int64_t wall_s)
+{
+    const weather_sched_config_t *config = &sched->config;
+    int64_t next_ms = now_ms + config->fetch_interval_ms;
+
+    if (config->align_period_s == 0 || wall_s < WALL_CLOCK_VALID_S) {
+        return next_ms;
+    }
+
+    int64_t target_s = wall_s + config->fetch_interval_ms / 1000;
+    int64_t aligned_s = (target_s - config->align_delay_s) / config->align_period_s * config->align_period_s +
+                        config->align_delay_s;
+    if (aligned_s <= wall_s) {
+        return next_ms;
+    }
+    return now_ms + (aligned_s - wall_s) * 1000;
+}
+
+/**
+ * Initialize scheduler
+ */
+void weather_sched_init(weather_sched_t *sched, const weather_sched_config_t *config,
+                        int64_t now_ms, uint32_t seed)
+{
+    memset(sched, 0, sizeof(*sched));
+    sched->config = *config;
+    sched->next_fetch_ms = now_ms;
+    sched->next_sample_ms = now_ms + config->sample_interval_ms;
+    sched->last_fetch_ms = -1;
+    sched->last_success_ms = -1;
+    sched->rng = seed ? seed : 1;
+}
+
+/**
+ * Request fetch
+ */
+void weather_sched_request(weather_sched_t *sched, int64_t now_ms, int64_t deadline_ms)
+{
+    sched->triggers++;
+
+    // Triggers right after a successful fetch are served by its data
+    if (sched->last_success_ms >= 0 && sched->last_success_ms == sched->last_fetch_ms &&
+        now_ms - sched->last_success_ms < sched->config.trigger_spacing_ms) {
+        sched->collapsed++;
+        return;
+    }
+
+    // After a failed fetch, wait at least the spacing before trying again
+    int64_t earliest_ms = now_ms;
+    if (sched->last_fetch_ms >= 0 && sched->last_fetch_ms + sched->config.trigger_spacing_ms > earliest_ms) {
+        earliest_ms = sched->last_fetch_ms + sched->config.trigger_spacing_ms;
+    }
+    if (deadline_ms < earliest_ms) {
+        deadline_ms = earliest_ms;
+    }
+
+    if (sched->next_fetch_ms <= deadline_ms) {
+        sched->collapsed++;
+        return;
+    }
+    sched->next_fetch_ms = deadline_ms;
+}
+
+/**
+ * Next action
+ */
+weather_sched_action_t weather_sched_next(const weather_sched_t *sched, int64_t now_ms, uint32_t *wait_ms)
+{
+    if (sched->next_fetch_ms <= now_ms) {
+        return WEATHER_SCHED_FETCH;
+    }
+
+    int64_t due_ms = sched->next_fetch_ms;
+    if (sched->config.sample_interval_ms > 0) {
+        if (sched->next_sample_ms <= now_ms) {
+            return WEATHER_SCHED_SAMPLE;
+        }
+        if (sched->next_sample_ms < due_ms) {
+            due_ms = sched->next_sample_ms;
+        }
+    }
+
+    int64_t wait = due_ms - now_ms;
+    *wait_ms = (wait > UINT32_MAX) ? UINT32_MAX : (uint32_t)wait;
+    return WEATHER_SCHED_WAIT;
+}
+
+/**
+ * Fetch finished
+ */
+void weather_sched_fetch_done(weather_sched_t *sched, int64_t now_ms, int64_t wall_s, bool success)
+{
+    sched->last_fetch_ms = now_ms;
+
+    if (success) {
+        sched->failures = 0;
+        sched->last_success_ms = now_ms;
+        sched->next_fetch_ms = regular_fetch_time(sched, now_ms, wall_s);
+        // The fetch itself recorded a sample
+        sched->next_sample_ms = now_ms + sched->config.sample_interval_ms;
+        return;
+    }
+
+    sched->failures++;
+    int64_t next_ms = now_ms + backoff_delay(sched);
+
+    // Keep retrying often enough to refresh data before it gets too old. Once
+    // the data is too old anyway, plain backoff applies again.
+    if (sched->config.max_age_ms > 0 && sched->last_success_ms >= 0) {
+        int64_t deadline_ms = sched->last_success_ms + sched->config.max_age_ms;
+        int64_t floor_ms = now_ms + sched->config.backoff_min_ms;
+        if (deadline_ms > now_ms && next_ms > deadline_ms) {
+            next_ms = (deadline_ms > floor_ms) ? deadline_ms : floor_ms;
+        }
+    }
+    sched->next_fetch_ms = next_ms;
+}
+
+/**
+ * Sample finished
+ */
+void weather_sched_sample_done(weather_sched_t *sched, int64_t now_ms)
+{
+    sched->next_sample_ms += sched->config.sample_interval_ms;
+    if (sched->next_sample_ms <= now_ms) {
+        sched->next_sample_ms = now_ms + sched->config.sample_interval_ms;
+    }
+}
@@ -0,0 +1,291 @@
+// Chaining the bundle's verify callback reads it back from the mbedTLS config
+#define MBEDTLS_ALLOW_PRIVATE_ACCESS
+
+#include "weather_tls.h"
+#include "esp_crt_bundle.h"
+#include "esp_heap_caps.h"
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mbedtls/base64.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/x509_crt.h"
+#include <string.h>
+
+static const char *TAG = "WEATHER_TLS";
+
+#define SPKI_HASH_LEN       32
+
+// Roots from certs/weather_roots.pem (EMBED_TXTFILES adds the terminator)
+extern const char weather_roots_pem_start[] asm("_binary_weather_roots_pem_start");
+extern const char weather_roots_pem_end[] asm("_binary_weather_roots_pem_end");
+
+#define WEATHER_TLS_PIN_ONE(pin) pin,
+static const char *const spki_pins_b64[] = { WEATHER_TLS_SPKI_PINS(WEATHER_TLS_PIN_ONE) };
+#define SPKI_PIN_COUNT      (sizeof(spki_pins_b64) / sizeof(spki_pins_b64[0]))
+
+static mbedtls_x509_crt pinned_roots;
+static size_t pinned_root_count = 0;
+static uint8_t spki_pins[SPKI_PIN_COUNT][SPKI_HASH_LEN];
+static size_t spki_pin_count = 0;
+static bool tls_initialized = false;
+
+// Verify callback installed by esp_crt_bundle_attach, chained by bundle_verify
+static int (*bundle_verify_next)(void *, mbedtls_x509_crt *, int, uint32_t *) = NULL;
+
+// Server leaf certificates verified by the calling task (a resumed handshake verifies none)
+static __thread uint32_t chains_verified = 0;
+
+/**
+ * Check if the public key of a certificate is pinned
+ */
+static bool spki_pinned(const mbedtls_x509_crt *crt)
+{
+    uint8_t hash[SPKI_HASH_LEN];
+
+    if (spki_pin_count == 0 || mbedtls_sha256(crt->pk_raw.p, crt->pk_raw.len, hash, 0) != 0) {
+        return false;
+    }
+
+    for (size_t i = 0; i < spki_pin_count; i++) {
+        if (memcmp(hash, spki_pins[i], SPKI_HASH_LEN) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Certificate verification callback, called for each certificate from the top of the chain down
+ */
+static int pinned_verify(void *ctx, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
+{
+    if (depth == 0) {
+        chains_verified++;
+    }
+
+    // Top of the chain did not lead to a pinned root: accept it if its key is pinned
+    if ((*flags & MBEDTLS_X509_BADCERT_NOT_TRUSTED) && spki_pinned(crt)) {
+        ESP_LOGD(TAG, "Certificate at depth %d matches an SPKI pin", depth);
+        *flags &= ~MBEDTLS_X509_BADCERT_NOT_TRUSTED;
+    }
+    return 0;
+}
+
+/**
+ * Parse roots and pins
+ */
+esp_err_t weather_tls_init(void)
+{
+    if (tls_initialized) {
+        return weather_tls_pinned_ready() ? ESP_OK : ESP_ERR_NOT_FOUND;
+    }
+    tls_initialized = true;
+
+    mbedtls_x509_crt_init(&pinned_roots);
+    size_t pem_len = weather_roots_pem_end - weather_roots_pem_start;
+    int ret = mbedtls_x509_crt_parse(&pinned_roots, (const unsigned char *)weather_roots_pem_start, pem_len);
+    if (ret < 0) {
+        ESP_LOGE(TAG, "Failed to parse pinned roots: -0x%04x", (unsigned)-ret);
+    } else {
+        for (const mbedtls_x509_crt *crt = &pinned_roots; crt != NULL && crt->raw.len > 0; crt = crt->next) {
+            pinned_root_count++;
+        }
+        if (ret > 0) {
+            ESP_LOGW(TAG, "%d pinned root(s) could not be parsed", ret);
+        }
+    }
+
+    for (size_t i = 0; i < SPKI_PIN_COUNT; i++) {
+        size_t len = 0;
+        const char *pin = spki_pins_b64[i];
+        if (mbedtls_base64_decode(spki_pins[spki_pin_count], SPKI_HASH_LEN, &len,
+                                  (const unsigned char *)pin, strlen(pin)) != 0 || len != SPKI_HASH_LEN) {
+            ESP_LOGW(TAG, "Ignoring malformed SPKI pin %s", pin);
+            continue;
+        }
+        spki_pin_count++;
+    }
+
+    ESP_LOGI(TAG, "Pinned trust anchors: %u root(s), %u SPKI pin(s)",
+             (unsigned)pinned_root_count, (unsigned)spki_pin_count);
+    return weather_tls_pinned_ready() ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+/**
+ * Check if pinned verification is available
+ */
+bool weather_tls_pinned_ready(void)
+{
+    return pinned_root_count > 0 || spki_pin_count > 0;
+}
+
+/**
+ * Attach pinned anchors
+ */
+esp_err_t weather_tls_attach_pinned(void *conf)
+{
+    mbedtls_ssl_config *ssl_conf = (mbedtls_ssl_config *)conf;
+
+    if (!weather_tls_pinned_ready()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // esp-tls has already set MBEDTLS_SSL_VERIFY_REQUIRED for crt_bundle_attach
+    if (pinned_root_count > 0) {
+        mbedtls_ssl_conf_ca_chain(ssl_conf, &pinned_roots, NULL);
+    }
+    mbedtls_ssl_conf_verify(ssl_conf, pinned_verify, NULL);
+    return ESP_OK;
+}
+
+/**
+ * Bundle verification callback: count the chain, then let the bundle decide
+ */
+static int bundle_verify(void *ctx, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
+{
+    if (depth == 0) {
+        chains_verified++;
+    }
+    return bundle_verify_next(ctx, crt, depth, flags);
+}
+
+/**
+ * Attach the certificate bundle
+ */
+esp_err_t weather_tls_attach_bundle(void *conf)
+{
+    mbedtls_ssl_config *ssl_conf = (mbedtls_ssl_config *)conf;
+
+    esp_err_t err = esp_crt_bundle_attach(conf);
+    if (err != ESP_OK || ssl_conf->MBEDTLS_PRIVATE(f_vrfy) == NULL) {
+        return err;
+    }
+
+    // Always the same bundle callback, context passed through
+    bundle_verify_next = ssl_conf->MBEDTLS_PRIVATE(f_vrfy);
+    mbedtls_ssl_conf_verify(ssl_conf, bundle_verify, ssl_conf->MBEDTLS_PRIVATE(p_vrfy));
+    return ESP_OK;
+}
+
+/**
+ * Get the number of certificate chains verified by the calling task
+ */
+uint32_t weather_tls_chains_verified(void)
+{
+    return chains_verified;
+}
+
+/**
+ * Start heap probe
+ */
+void weather_tls_heap_probe_start(weather_tls_heap_probe_t *probe)
+{
+    probe->free_before = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    probe->active = (heap_caps_monitor_local_minimum_free_size_start() == ESP_OK);
+}
+
+/**
+ * Stop heap probe
+ */
+uint32_t weather_tls_heap_probe_stop(weather_tls_heap_probe_t *probe)
+{
+    if (!probe->active) {
+        return 0;
+    }
+
+    size_t min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+    heap_caps_monitor_local_minimum_free_size_stop();
+    probe->active = false;
+    return (probe->free_before > min_free) ? (uint32_t)(probe->free_before - min_free) : 0;
+}
+
+#if WEATHER_TLS_BENCHMARK
+// Timestamps of one benchmark request
+typedef struct {
+    int64_t connected_us;
+} bench_request_t;
+
+/**
+ * Benchmark HTTP event handler
+ */
+static esp_err_t bench_event_handler(esp_http_client_event_t *evt)
+{
+    bench_request_t *request = evt->user_data;
+
+    if (evt->event_id == HTTP_EVENT_ON_CONNECTED) {
+        request->connected_us = esp_timer_get_time();
+    }
+    return ESP_OK;
+}
+
+/**
+ * Run benchmark
+ */
+void weather_tls_benchmark(const char *url)
+{
+    static const struct {
+        weather_tls_trust_t trust;
+        esp_err_t (*attach)(void *conf);
+    } modes[] = {
+        {WEATHER_TLS_TRUST_PINNED, weather_tls_attach_pinned},
+        {WEATHER_TLS_TRUST_BUNDLE, esp_crt_bundle_attach},
+    };
+
+    ESP_LOGI(TAG, "Handshake benchmark: %d fresh connections per mode to %s", WEATHER_TLS_BENCHMARK_RUNS, url);
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        uint32_t ok = 0;
+        uint64_t total_us = 0;
+        uint32_t max_us = 0;
+        uint32_t peak_heap = 0;
+
+        for (int i = 0; i < WEATHER_TLS_BENCHMARK_RUNS; i++) {
+            bench_request_t request = {0};
+            esp_http_client_config_t config = {
+                .url = url,
+                .event_handler = bench_event_handler,
+                .user_data = &request,
+                .timeout_ms = WEATHER_TIMEOUT_MAX_MS,
+                .buffer_size = 512,
+                .crt_bundle_attach = modes[m].attach,
+            };
+
+            // New client each time: no keep-alive, no session ticket, always a full handshake
+            esp_http_client_handle_t client = esp_http_client_init(&config);
+            if (client == NULL) {
+                continue;
+            }
+
+            weather_tls_heap_probe_t probe;
+            weather_tls_heap_probe_start(&probe);
+            int64_t start_us = esp_timer_get_time();
+            esp_err_t err = esp_http_client_perform(client);
+            uint32_t heap = weather_tls_heap_probe_stop(&probe);
+            esp_http_client_cleanup(client);
+
+            if (err != ESP_OK || request.connected_us == 0) {
+                ESP_LOGW(TAG, "[%s] Run %d failed: %s", weather_client_tls_trust_str(modes[m].trust),
+                         i, esp_err_to_name(err));
+                continue;
+            }
+
+            uint32_t handshake_us = (uint32_t)(request.connected_us - start_us);
+            ok++;
+            total_us += handshake_us;
+            if (handshake_us > max_us) {
+                max_us = handshake_us;
+            }
+            if (heap > peak_heap) {
+                peak_heap = heap;
+            }
+        }
+
+        ESP_LOGI(TAG, "%-6s  %lu/%d ok  handshake avg %lu ms, max %lu ms  peak heap %lu bytes",
+                 weather_client_tls_trust_str(modes[m].trust), (unsigned long)ok, WEATHER_TLS_BENCHMARK_RUNS,
+                 (unsigned long)(ok ? total_us / ok / 1000 : 0), (unsigned long)(max_us / 1000),
+                 (unsigned long)peak_heap);
+    }
+}
+#endif
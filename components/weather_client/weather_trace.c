@@ -0,0 +1,89 @@
+#include "weather_trace.h"
+#include <string.h>
+
+static const char *phase_names[WEATHER_PHASE_COUNT] = {
+    [WEATHER_PHASE_DNS]      = "dns",
+    [WEATHER_PHASE_CONNECT]  = "connect",
+    [WEATHER_PHASE_TTFB]     = "ttfb",
+    [WEATHER_PHASE_TRANSFER] = "transfer",
+    [WEATHER_PHASE_DECODE]   = "decode",
+    [WEATHER_PHASE_TOTAL]    = "total",
+};
+
+/**
+ * Clear ring
+ */
+void weather_trace_init(weather_trace_t *trace)
+{
+    memset(trace, 0, sizeof(*trace));
+}
+
+/**
+ * Add a trace
+ */
+void weather_trace_add(weather_trace_t *trace, const weather_trace_entry_t *entry)
+{
+    trace->entries[trace->next] = *entry;
+    trace->next = (trace->next + 1) % WEATHER_TRACE_LEN;
+    if (trace->count < WEATHER_TRACE_LEN) {
+        trace->count++;
+    }
+    trace->total++;
+}
+
+/**
+ * Get the n-th most recent trace
+ */
+const weather_trace_entry_t* weather_trace_get(const weather_trace_t *trace, uint32_t n)
+{
+    if (n >= trace->count) {
+        return NULL;
+    }
+    return &trace->entries[(trace->next + WEATHER_TRACE_LEN - 1 - n) % WEATHER_TRACE_LEN];
+}
+
+/**
+ * Get phase percentile (nearest rank)
+ */
+uint32_t weather_trace_percentile(const weather_trace_t *trace, weather_phase_t phase,
+                                  uint32_t percent, uint32_t *samples)
+{
+    uint32_t sorted[WEATHER_TRACE_LEN];
+    uint32_t n = 0;
+
+    // Insertion sort of the traces that reached the phase, the ring is small
+    for (uint32_t i = 0; i < trace->count && phase < WEATHER_PHASE_COUNT; i++) {
+        const weather_trace_entry_t *entry = &trace->entries[i];
+        if (!(entry->measured & (1u << phase))) {
+            continue;
+        }
+        uint32_t value = entry->phase_us[phase];
+        uint32_t j = n++;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+
+    if (samples) {
+        *samples = n;
+    }
+    if (n == 0 || percent == 0) {
+        return 0;
+    }
+
+    uint32_t rank = (percent * n + 99) / 100;
+    if (rank > n) {
+        rank = n;
+    }
+    return sorted[rank - 1];
+}
+
+/**
+ * Get phase name
+ */
+const char* weather_trace_phase_name(weather_phase_t phase)
+{
+    return (phase < WEATHER_PHASE_COUNT) ? phase_names[phase] : "unknown";
+}
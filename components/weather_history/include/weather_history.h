@@ -0,0 +1,106 @@
+#ifndef WEATHER_HISTORY_H
+#define WEATHER_HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Tier capacities (memory per store is fixed at compile time)
+#define WEATHER_HISTORY_RAW_SAMPLES     48      // Raw samples (2 days at 1 fetch/hour)
+#define WEATHER_HISTORY_HOURLY_SLOTS    72      // Hourly aggregates (3 days)
+#define WEATHER_HISTORY_DAILY_SLOTS     31      // Daily aggregates (1 month)
+
+// Largest possible query result (ring plus the open bucket)
+#define WEATHER_HISTORY_MAX2(a, b)      ((a) > (b) ? (a) : (b))
+#define WEATHER_HISTORY_MAX_POINTS \
+    (WEATHER_HISTORY_MAX2(WEATHER_HISTORY_RAW_SAMPLES, \
+                          WEATHER_HISTORY_MAX2(WEATHER_HISTORY_HOURLY_SLOTS, WEATHER_HISTORY_DAILY_SLOTS)) + 1)
+
+// Daily buckets start at local midnight (WIB, GMT+7)
+#define WEATHER_HISTORY_UTC_OFFSET_S    (7 * 3600)
+
+// History tiers
+typedef enum {
+    WEATHER_HISTORY_RAW = 0,
+    WEATHER_HISTORY_HOURLY,
+    WEATHER_HISTORY_DAILY,
+    WEATHER_HISTORY_TIER_COUNT
+} weather_history_tier_t;
+
+// Raw sample
+typedef struct {
+    uint32_t timestamp;     // Unix time
+    int16_t temperature;    // 0.01 °C
+    uint16_t humidity;      // 0.1 %
+} weather_history_sample_t;
+
+// Aggregate over one bucket (raw samples are reported with count = 1)
+// Temperatures are in 0.01 °C, humidity in 0.1 %.
+typedef struct {
+    uint32_t start;         // Bucket start (raw: sample time)
+    uint16_t count;         // Samples in bucket
+    int16_t temp_min;
+    int16_t temp_max;
+    int16_t temp_mean;
+    uint16_t hum_min;
+    uint16_t hum_max;
+    uint16_t hum_mean;
+    int32_t temp_sum;       // Sums behind the means
+    uint32_t hum_sum;
+} weather_history_agg_t;
+
+// Fixed-size ring of aggregates
+typedef struct {
+    uint16_t head;          // Next slot to write
+    uint16_t count;         // Valid slots
+} weather_history_ring_t;
+
+// History store for one station
+typedef struct {
+    weather_history_sample_t raw[WEATHER_HISTORY_RAW_SAMPLES];
+    weather_history_agg_t hourly[WEATHER_HISTORY_HOURLY_SLOTS];
+    weather_history_agg_t daily[WEATHER_HISTORY_DAILY_SLOTS];
+    weather_history_ring_t raw_ring;
+    weather_history_ring_t hourly_ring;
+    weather_history_ring_t daily_ring;
+    weather_history_agg_t open_hour;    // Bucket being accumulated
+    weather_history_agg_t open_day;     // Bucket being accumulated
+    uint32_t last_timestamp;
+} weather_history_t;
+
+/**
+ * Reset store
+ */
+void weather_history_init(weather_history_t *history);
+
+/**
+ * Add a sample, updating all tiers incrementally
+ * @return false if the sample is older than the last one (dropped)
+ */
+bool weather_history_add(weather_history_t *history, uint32_t timestamp,
+                         int16_t temperature, uint16_t humidity);
+
+/**
+ * Query a tier, oldest first
+ * Buckets starting in [from, to] are returned, including the one still
+ * being accumulated.
+ * @param out Output array
+ * @param max_out Capacity of out
+ * @return number of entries written
+ */
+size_t weather_history_query(const weather_history_t *history, weather_history_tier_t tier,
+                             uint32_t from, uint32_t to,
+                             weather_history_agg_t *out, size_t max_out);
+
+/**
+ * Get tier name ("raw", "hourly", "daily")
+ */
+const char* weather_history_tier_str(weather_history_tier_t tier);
+
+/**
+ * Parse tier name
+ * @return true if name is a valid tier
+ */
+bool weather_history_tier_from_str(const char *name, weather_history_tier_t *tier);
+
+#endif // WEATHER_HISTORY_H
@@ -0,0 +1,223 @@
+#include "weather_history.h"
+#include "fixed_point.h"
+#include <string.h>
+#include <strings.h>
+
+#define SECONDS_PER_HOUR    3600u
+#define SECONDS_PER_DAY     86400u
+
+static const char *const tier_names[WEATHER_HISTORY_TIER_COUNT] = {
+    [WEATHER_HISTORY_RAW]    = "raw",
+    [WEATHER_HISTORY_HOURLY] = "hourly",
+    [WEATHER_HISTORY_DAILY]  = "daily",
+};
+
+/**
+ * Start of the hour containing timestamp
+ */
+static uint32_t hour_start(uint32_t timestamp)
+{
+    return timestamp - (timestamp % SECONDS_PER_HOUR);
+}
+
+/**
+ * Start of the local day containing timestamp
+ */
+static uint32_t day_start(uint32_t timestamp)
+{
+    uint32_t local = timestamp + WEATHER_HISTORY_UTC_OFFSET_S;
+    return timestamp - (local % SECONDS_PER_DAY);
+}
+
+/**
+ * Fold one sample into an aggregate (means are rounded from the sums)
+ */
+static void agg_update(weather_history_agg_t *agg, uint32_t start, int16_t temperature, uint16_t humidity)
+{
+    if (agg->count == 0) {
+        agg->start = start;
+        agg->count = 1;
+        agg->temp_min = agg->temp_max = agg->temp_mean = temperature;
+        agg->hum_min = agg->hum_max = agg->hum_mean = humidity;
+        agg->temp_sum = temperature;
+        agg->hum_sum = humidity;
+        return;
+    }
+
+    // A full bucket keeps its min/max but stops moving the mean
+    if (agg->count == UINT16_MAX) {
+        agg->count--;
+        agg->temp_sum -= agg->temp_mean;
+        agg->hum_sum -= agg->hum_mean;
+    }
+    agg->count++;
+    if (temperature < agg->temp_min) agg->temp_min = temperature;
+    if (temperature > agg->temp_max) agg->temp_max = temperature;
+    if (humidity < agg->hum_min) agg->hum_min = humidity;
+    if (humidity > agg->hum_max) agg->hum_max = humidity;
+    agg->temp_sum += temperature;
+    agg->hum_sum += humidity;
+    agg->temp_mean = (int16_t)fixed_div_round(agg->temp_sum, agg->count);
+    agg->hum_mean = (uint16_t)fixed_div_round(agg->hum_sum, agg->count);
+}
+
+/**
+ * Reserve the next ring slot (overwrites the oldest when full)
+ * @return slot index
+ */
+static uint16_t ring_push(weather_history_ring_t *ring, uint16_t capacity)
+{
+    uint16_t slot = ring->head;
+    ring->head = (ring->head + 1) % capacity;
+    if (ring->count < capacity) {
+        ring->count++;
+    }
+    return slot;
+}
+
+/**
+ * Index of the i-th oldest entry
+ */
+static uint16_t ring_at(const weather_history_ring_t *ring, uint16_t capacity, uint16_t i)
+{
+    return (ring->head + capacity - ring->count + i) % capacity;
+}
+
+/**
+ * Close the open bucket if the sample belongs to a new one, then fold it in
+ */
+static void tier_add(weather_history_agg_t *slots, uint16_t capacity, weather_history_ring_t *ring,
+                     weather_history_agg_t *open, uint32_t bucket,
+                     int16_t temperature, uint16_t humidity)
+{
+    if (open->count > 0 && open->start != bucket) {
+        slots[ring_push(ring, capacity)] = *open;
+        open->count = 0;
+    }
+    agg_update(open, bucket, temperature, humidity);
+}
+
+/**
+ * Copy ring entries in range, then the open bucket
+ */
+static size_t tier_query(const weather_history_agg_t *slots, uint16_t capacity,
+                         const weather_history_ring_t *ring, const weather_history_agg_t *open,
+                         uint32_t from, uint32_t to, weather_history_agg_t *out, size_t max_out)
+{
+    size_t n = 0;
+
+    for (uint16_t i = 0; i < ring->count && n < max_out; i++) {
+        const weather_history_agg_t *agg = &slots[ring_at(ring, capacity, i)];
+        if (agg->start >= from && agg->start <= to) {
+            out[n++] = *agg;
+        }
+    }
+
+    if (open->count > 0 && open->start >= from && open->start <= to && n < max_out) {
+        out[n++] = *open;
+    }
+
+    return n;
+}
+
+/**
+ * Reset store
+ */
+void weather_history_init(weather_history_t *history)
+{
+    memset(history, 0, sizeof(*history));
+}
+
+/**
+ * Add sample
+ */
+bool weather_history_add(weather_history_t *history, uint32_t timestamp,
+                         int16_t temperature, uint16_t humidity)
+{
+    if (timestamp < history->last_timestamp) {
+        return false;
+    }
+    history->last_timestamp = timestamp;
+
+    weather_history_sample_t *sample =
+        &history->raw[ring_push(&history->raw_ring, WEATHER_HISTORY_RAW_SAMPLES)];
+    sample->timestamp = timestamp;
+    sample->temperature = temperature;
+    sample->humidity = humidity;
+
+    tier_add(history->hourly, WEATHER_HISTORY_HOURLY_SLOTS, &history->hourly_ring,
+             &history->open_hour, hour_start(timestamp), temperature, humidity);
+    tier_add(history->daily, WEATHER_HISTORY_DAILY_SLOTS, &history->daily_ring,
+             &history->open_day, day_start(timestamp), temperature, humidity);
+
+    return true;
+}
+
+/**
+ * Query tier
+ */
+size_t weather_history_query(const weather_history_t *history, weather_history_tier_t tier,
+                             uint32_t from, uint32_t to,
+                             weather_history_agg_t *out, size_t max_out)
+{
+    size_t n = 0;
+
+    switch (tier) {
+        case WEATHER_HISTORY_RAW:
+            for (uint16_t i = 0; i < history->raw_ring.count && n < max_out; i++) {
+                const weather_history_sample_t *sample =
+                    &history->raw[ring_at(&history->raw_ring, WEATHER_HISTORY_RAW_SAMPLES, i)];
+                if (sample->timestamp < from || sample->timestamp > to) {
+                    continue;
+                }
+                weather_history_agg_t *agg = &out[n++];
+                agg->start = sample->timestamp;
+                agg->count = 1;
+                agg->temp_min = agg->temp_max = agg->temp_mean = sample->temperature;
+                agg->hum_min = agg->hum_max = agg->hum_mean = sample->humidity;
+                agg->temp_sum = sample->temperature;
+                agg->hum_sum = sample->humidity;
+            }
+            break;
+
+        case WEATHER_HISTORY_HOURLY:
+            n = tier_query(history->hourly, WEATHER_HISTORY_HOURLY_SLOTS, &history->hourly_ring,
+                           &history->open_hour, from, to, out, max_out);
+            break;
+
+        case WEATHER_HISTORY_DAILY:
+            n = tier_query(history->daily, WEATHER_HISTORY_DAILY_SLOTS, &history->daily_ring,
+                           &history->open_day, from, to, out, max_out);
+            break;
+
+        default:
+            break;
+    }
+
+    return n;
+}
+
+/**
+ * Tier name
+ */
+const char* weather_history_tier_str(weather_history_tier_t tier)
+{
+    if (tier >= WEATHER_HISTORY_TIER_COUNT) {
+        return "unknown";
+    }
+    return tier_names[tier];
+}
+
+/**
+ * Parse tier name
+ */
+bool weather_history_tier_from_str(const char *name, weather_history_tier_t *tier)
+{
+    for (int i = 0; i < WEATHER_HISTORY_TIER_COUNT; i++) {
+        if (strcasecmp(name, tier_names[i]) == 0) {
+            *tier = (weather_history_tier_t)i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,316 @@
+/*
+ * Weather log on the Linux partition emulation: append, page flush, sector
+ * recycle, head recovery at boot and CRC rejection, then a benchmark of
+ * append throughput, query latency and flash wear per day.
+ *
+ * weather_log_deinit() stands in for a power cut: buffered records are lost,
+ * as on the device. Times are host times; flash operation counts come from
+ * the emulation (CONFIG_ESP_PARTITION_ENABLE_STATS) and match the device.
+ */
+#include "unity.h"
+#include "weather_log.h"
+#include "esp_partition.h"
+#include "esp_private/partition_linux.h"
+#include "esp_timer.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BASE_TIME           1771200000u
+#define STATIONS            3           // WEATHER_STATIONS
+#define SAMPLES_PER_DAY     24          // WEATHER_SAMPLE_INTERVAL_MS: hourly per station
+#define RECORDS_PER_DAY     (STATIONS * SAMPLES_PER_DAY)
+#define BENCH_DAYS          730
+
+static const esp_partition_t *log_partition(void)
+{
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                                WEATHER_LOG_PARTITION_LABEL);
+    TEST_ASSERT_NOT_NULL(partition);
+    return partition;
+}
+
+/**
+ * Erase the partition and mount an empty log
+ */
+static void mount_empty(void)
+{
+    weather_log_deinit();
+    const esp_partition_t *partition = log_partition();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_erase_range(partition, 0, partition->size));
+    TEST_ASSERT_EQUAL(ESP_OK, weather_log_init());
+}
+
+/**
+ * Power cut and boot
+ */
+static void remount(void)
+{
+    weather_log_deinit();
+    TEST_ASSERT_EQUAL(ESP_OK, weather_log_init());
+}
+
+static void append_range(uint32_t first, uint32_t count)
+{
+    for (uint32_t i = first; i < first + count; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, weather_log_append(BASE_TIME + i, i % STATIONS, 2000 + i % 1000, 600 + i % 400));
+    }
+}
+
+// Timestamps visited by a query
+typedef struct {
+    uint32_t *times;
+    size_t count;
+    size_t max;
+} collect_t;
+
+static bool collect(const weather_log_record_t *record, void *ctx)
+{
+    collect_t *c = (collect_t *)ctx;
+    if (c->count < c->max) {
+        c->times[c->count] = record->timestamp;
+    }
+    c->count++;
+    return true;
+}
+
+/**
+ * Check that the log holds exactly the records first .. first + count - 1,
+ * oldest first, with the values they were appended with
+ */
+static void check_contents(uint32_t first, uint32_t count)
+{
+    collect_t c = {.times = malloc(sizeof(uint32_t) * (count + 1)), .max = count + 1};
+    TEST_ASSERT_NOT_NULL(c.times);
+    TEST_ASSERT_EQUAL(count, weather_log_iterate(0, UINT32_MAX, collect, &c));
+    TEST_ASSERT_EQUAL(count, c.count);
+    for (uint32_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_UINT32(BASE_TIME + first + i, c.times[i]);
+    }
+    free(c.times);
+
+    weather_log_stats_t stats;
+    weather_log_get_stats(&stats);
+    TEST_ASSERT_EQUAL(count, stats.record_count);
+}
+
+static bool check_values(const weather_log_record_t *record, void *ctx)
+{
+    uint32_t i = record->timestamp - BASE_TIME;
+    int16_t temperature;
+    uint16_t humidity;
+    weather_log_record_values(record, &temperature, &humidity);
+    TEST_ASSERT_EQUAL(i % STATIONS, record->station);
+    TEST_ASSERT_EQUAL(2000 + i % 1000, temperature);
+    TEST_ASSERT_EQUAL(600 + i % 400, humidity);
+    return true;
+}
+
+static void test_append_and_page_flush(void)
+{
+    weather_log_stats_t stats;
+    mount_empty();
+
+    // The first page holds the sector header and 15 records
+    append_range(0, WEATHER_LOG_RECORDS_PER_PAGE - 2);
+    weather_log_get_stats(&stats);
+    TEST_ASSERT_EQUAL(0, stats.pages_written);
+    TEST_ASSERT_EQUAL(1, stats.sectors_erased);
+    TEST_ASSERT_EQUAL(WEATHER_LOG_RECORDS_PER_PAGE - 2, stats.pending);
+
+    append_range(WEATHER_LOG_RECORDS_PER_PAGE - 2, 1);
+    weather_log_get_stats(&stats);
+    TEST_ASSERT_EQUAL(1, stats.pages_written);
+    TEST_ASSERT_EQUAL(0, stats.pending);
+
+    // Buffered records are visible to queries before they are programmed
+    append_range(WEATHER_LOG_RECORDS_PER_PAGE - 1, 3);
+    check_contents(0, WEATHER_LOG_RECORDS_PER_PAGE + 2);
+
+    // A flush programs the partial page, a later flush only the new slots
+    TEST_ASSERT_EQUAL(ESP_OK, weather_log_flush());
+    append_range(WEATHER_LOG_RECORDS_PER_PAGE + 2, 1);
+    TEST_ASSERT_EQUAL(ESP_OK, weather_log_flush());
+    weather_log_get_stats(&stats);
+    TEST_ASSERT_EQUAL(3, stats.pages_written);
+    TEST_ASSERT_EQUAL(0, stats.pending);
+    check_contents(0, WEATHER_LOG_RECORDS_PER_PAGE + 3);
+    weather_log_iterate(0, UINT32_MAX, check_values, NULL);
+
+    // Time range
+    collect_t c = {.times = NULL, .max = 0};
+    TEST_ASSERT_EQUAL(5, weather_log_iterate(BASE_TIME + 3, BASE_TIME + 7, collect, &c));
+}
+
+static void test_head_recovery(void)
+{
+    mount_empty();
+
+    // Flushed records survive, buffered ones are lost with the power
+    append_range(0, 40);
+    TEST_ASSERT_EQUAL(ESP_OK, weather_log_flush());
+    append_range(40, 5);
+    remount();
+    check_contents(0, 40);
+
+    // Appending resumes in the partially programmed page
+    append_range(40, 30);
+    TEST_ASSERT_EQUAL(ESP_OK, weather_log_flush());
+    remount();
+    check_contents(0, 70);
+    weather_log_iterate(0, UINT32_MAX, check_values, NULL);
+
+    // Head sector exactly full: the next append opens a new sector
+    mount_empty();
+    append_range(0, WEATHER_LOG_RECORDS_PER_SECTOR);
+    remount();
+    check_contents(0, WEATHER_LOG_RECORDS_PER_SECTOR);
+    append_range(WEATHER_LOG_RECORDS_PER_SECTOR, 1);
+    TEST_ASSERT_EQUAL(ESP_OK, weather_log_flush());
+    weather_log_stats_t stats;
+    weather_log_get_stats(&stats);
+    TEST_ASSERT_EQUAL(2, stats.sector_seq);
+    remount();
+    check_contents(0, WEATHER_LOG_RECORDS_PER_SECTOR + 1);
+}
+
+static void test_sector_recycle(void)
+{
+    mount_empty();
+    weather_log_stats_t stats;
+    weather_log_get_stats(&stats);
+    uint32_t capacity = stats.capacity;
+    uint32_t sectors = stats.sector_count;
+
+    // Fill the partition, then two sectors more: the oldest sectors are reused
+    uint32_t total = capacity + 2 * WEATHER_LOG_RECORDS_PER_SECTOR;
+    append_range(0, total);
+    weather_log_get_stats(&stats);
+    TEST_ASSERT_EQUAL(sectors + 2, stats.sector_seq);
+    TEST_ASSERT_EQUAL(sectors + 2, stats.sectors_erased);
+
+    // The head sector is full, so every sector holds live records
+    check_contents(total - capacity, capacity);
+    remount();
+    check_contents(total - capacity, capacity);
+
+    // The next append recycles the oldest sector
+    append_range(total, 10);
+    TEST_ASSERT_EQUAL(ESP_OK, weather_log_flush());
+    remount();
+    uint32_t kept = capacity - WEATHER_LOG_RECORDS_PER_SECTOR + 10;
+    check_contents(total + 10 - kept, kept);
+}
+
+static void test_crc_rejection(void)
+{
+    const esp_partition_t *partition = log_partition();
+    const uint8_t zero = 0;
+    mount_empty();
+
+    // The first sector opened is sector 0; record i is in slot i + 1
+    append_range(0, 2 * WEATHER_LOG_RECORDS_PER_PAGE);
+    TEST_ASSERT_EQUAL(ESP_OK, weather_log_flush());
+
+    // Clear bits of record 3's temperature, as a bad flash cell would
+    size_t offset = (3 + 1) * WEATHER_LOG_RECORD_SIZE + offsetof(weather_log_record_t, temperature);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_write(partition, offset, &zero, 1));
+
+    collect_t c = {.times = malloc(sizeof(uint32_t) * 64), .max = 64};
+    size_t visited = weather_log_iterate(0, UINT32_MAX, collect, &c);
+    TEST_ASSERT_EQUAL(2 * WEATHER_LOG_RECORDS_PER_PAGE - 1, visited);
+    for (size_t i = 0; i < visited; i++) {
+        TEST_ASSERT_NOT_EQUAL(BASE_TIME + 3, c.times[i]);
+    }
+
+    // A sector with a corrupt header is not part of the log after boot
+    append_range(2 * WEATHER_LOG_RECORDS_PER_PAGE, WEATHER_LOG_RECORDS_PER_SECTOR);
+    TEST_ASSERT_EQUAL(ESP_OK, weather_log_flush());
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_write(partition, 8, &zero, 1));     // seq
+    remount();
+    c.count = 0;
+    visited = weather_log_iterate(0, UINT32_MAX, collect, &c);
+    TEST_ASSERT_EQUAL(2 * WEATHER_LOG_RECORDS_PER_PAGE, visited);
+    TEST_ASSERT_EQUAL_UINT32(BASE_TIME + WEATHER_LOG_RECORDS_PER_SECTOR, c.times[0]);
+    free(c.times);
+}
+
+static bool count_only(const weather_log_record_t *record, void *ctx)
+{
+    return true;
+}
+
+/**
+ * Mean time of a query over the last n records, in microseconds
+ */
+static uint32_t query_us(uint32_t newest, uint32_t n, size_t *visited)
+{
+    const int runs = 20;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < runs; i++) {
+        *visited = weather_log_iterate(BASE_TIME + newest + 1 - n, BASE_TIME + newest, count_only, NULL);
+    }
+    return (uint32_t)((esp_timer_get_time() - start) / runs);
+}
+
+static void test_benchmark(void)
+{
+    const esp_partition_t *partition = log_partition();
+    mount_empty();
+    esp_partition_clear_stats();
+
+    // Two years at the firmware's sampling rate
+    uint32_t total = BENCH_DAYS * RECORDS_PER_DAY;
+    int64_t start = esp_timer_get_time();
+    append_range(0, total);
+    int64_t append_us = esp_timer_get_time() - start;
+
+    weather_log_stats_t stats;
+    weather_log_get_stats(&stats);
+    size_t writes = esp_partition_get_write_ops();
+    size_t erases = esp_partition_get_erase_ops();
+    size_t written = esp_partition_get_write_bytes();
+
+    size_t max_erases = 0;
+    uint32_t first_sector = partition->address / WEATHER_LOG_SECTOR_SIZE;
+    for (uint32_t i = 0; i < stats.sector_count; i++) {
+        size_t n = esp_partition_get_sector_erase_count(first_sector + i);
+        if (n > max_erases) {
+            max_erases = n;
+        }
+    }
+
+    size_t day_records, all_records;
+    uint32_t day_us = query_us(total - 1, RECORDS_PER_DAY, &day_records);
+    uint32_t all_us = query_us(total - 1, stats.record_count, &all_records);
+
+    printf("\nweather_log benchmark: %d days, %d records/day (%d stations x %d samples)\n",
+           BENCH_DAYS, RECORDS_PER_DAY, STATIONS, SAMPLES_PER_DAY);
+    printf("  append:      %lu records/s on the host, %lu us/record in the log's own counter\n",
+           (unsigned long)(total * 1000000LL / (append_us ? append_us : 1)), (unsigned long)stats.avg_append_us);
+    printf("  query:       last 24 h %lu us (%u records), whole log %lu us (%u records)\n",
+           (unsigned long)day_us, (unsigned)day_records, (unsigned long)all_us, (unsigned)all_records);
+    printf("  flash/day:   %.2f page programs, %.0f bytes, %.3f sector erases\n",
+           (double)writes / BENCH_DAYS, (double)written / BENCH_DAYS, (double)erases / BENCH_DAYS);
+    printf("  wear:        %u erases of the most used sector in %d days, %.1f per year "
+           "(rated 100000 cycles)\n", (unsigned)max_erases, BENCH_DAYS, (double)max_erases * 365 / BENCH_DAYS);
+    printf("  retention:   %lu records, %.0f days\n",
+           (unsigned long)stats.record_count, (double)stats.record_count / RECORDS_PER_DAY);
+
+    TEST_ASSERT_EQUAL(RECORDS_PER_DAY, day_records);
+    TEST_ASSERT_EQUAL(stats.record_count, all_records);
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_append_and_page_flush);
+    RUN_TEST(test_head_recovery);
+    RUN_TEST(test_sector_recycle);
+    RUN_TEST(test_crc_rejection);
+    RUN_TEST(test_benchmark);
+    int failures = UNITY_END();
+    weather_log_deinit();
+    exit(failures);
+}
@@ -0,0 +1,99 @@
+#ifndef WEATHER_LOG_H
+#define WEATHER_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// Log partition (see partitions.csv)
+#define WEATHER_LOG_PARTITION_LABEL "wlog"
+
+// Flash geometry
+#define WEATHER_LOG_RECORD_SIZE     16      // Fixed record size
+#define WEATHER_LOG_PAGE_SIZE       256     // Records are programmed one flash page at a time
+#define WEATHER_LOG_SECTOR_SIZE     4096    // Erase unit, slot 0 of every sector is its header
+
+#define WEATHER_LOG_RECORDS_PER_PAGE    (WEATHER_LOG_PAGE_SIZE / WEATHER_LOG_RECORD_SIZE)
+#define WEATHER_LOG_RECORDS_PER_SECTOR  (WEATHER_LOG_SECTOR_SIZE / WEATHER_LOG_RECORD_SIZE - 1)
+
+// Record flags
+#define WEATHER_LOG_FLAG_FIXED      0x01    // Fixed-point values (older records hold a float and whole %)
+
+// Sample record as stored in flash (read values with weather_log_record_values)
+typedef struct {
+    uint32_t timestamp;     // Unix time
+    int32_t temperature;    // 0.01 °C
+    uint16_t humidity;      // 0.1 %
+    uint8_t station;        // Station index
+    uint8_t flags;          // WEATHER_LOG_FLAG_*
+    uint32_t crc;           // CRC32 of the preceding 12 bytes
+} weather_log_record_t;
+
+// Log statistics
+typedef struct {
+    uint32_t record_count;      // Records currently in the log
+    uint32_t capacity;          // Records the partition can hold
+    uint32_t sector_count;      // Sectors in the partition
+    uint32_t sector_seq;        // Sectors opened over the partition lifetime
+    uint32_t erase_cycles;      // Estimated erase cycles per sector (sector_seq / sector_count)
+    uint32_t appended;          // Records appended since boot
+    uint32_t pending;           // Records buffered in RAM, not yet programmed
+    uint32_t pages_written;     // Page programs since boot
+    uint32_t sectors_erased;    // Sector erases since boot
+    uint32_t avg_append_us;     // Mean append time (including flash writes)
+    uint32_t last_query_us;     // Duration of the last query
+    uint32_t last_query_records;// Records visited by the last query
+} weather_log_stats_t;
+
+/**
+ * Record visitor
+ * @param record Record (points into mapped flash, valid during the call only)
+ * @param ctx User context
+ * @return false to stop iterating
+ */
+typedef bool (*weather_log_visit_cb_t)(const weather_log_record_t *record, void *ctx);
+
+/**
+ * Mount the log partition and locate the write position
+ */
+esp_err_t weather_log_init(void);
+
+/**
+ * Unmount the log without flushing, as a power cut would (host tests)
+ */
+void weather_log_deinit(void);
+
+/**
+ * Append a sample (buffered until a flash page is full)
+ */
+esp_err_t weather_log_append(uint32_t timestamp, uint8_t station, int16_t temperature, uint16_t humidity);
+
+/**
+ * Program buffered records to flash (also runs on esp_restart)
+ */
+esp_err_t weather_log_flush(void);
+
+/**
+ * Visit records with timestamp in [from, to], oldest first
+ * Flash records are read in place through the partition mapping.
+ * @return number of records visited
+ */
+size_t weather_log_iterate(uint32_t from, uint32_t to, weather_log_visit_cb_t cb, void *ctx);
+
+/**
+ * Get the values of a record in 0.01 °C and 0.1 % (older records are converted)
+ */
+void weather_log_record_values(const weather_log_record_t *record, int16_t *temperature, uint16_t *humidity);
+
+/**
+ * Get log statistics
+ */
+void weather_log_get_stats(weather_log_stats_t *stats);
+
+/**
+ * Check if the log partition is mounted
+ */
+bool weather_log_is_ready(void);
+
+#endif // WEATHER_LOG_H
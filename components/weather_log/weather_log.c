@@ -0,0 +1,453 @@
+#include "weather_log.h"
+#include "fixed_point.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "WEATHER_LOG";
+
+#define SECTOR_MAGIC        0x474F4C57  // "WLOG"
+#define LOG_VERSION         1
+#define SLOTS_PER_SECTOR    (WEATHER_LOG_SECTOR_SIZE / WEATHER_LOG_RECORD_SIZE)
+#define CRC_LEN             12          // Bytes covered by the trailing CRC
+
+// Sector header, stored in slot 0 of every sector
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t seq;           // Increases by one for every sector opened
+    uint32_t crc;
+} sector_header_t;
+
+_Static_assert(sizeof(weather_log_record_t) == WEATHER_LOG_RECORD_SIZE, "Record size mismatch");
+_Static_assert(sizeof(sector_header_t) == WEATHER_LOG_RECORD_SIZE, "Header size mismatch");
+
+// Partition and read-only mapping
+static const esp_partition_t *log_partition = NULL;
+static const uint8_t *log_map = NULL;
+static esp_partition_mmap_handle_t log_map_handle;
+static uint32_t sector_count = 0;
+static SemaphoreHandle_t log_mutex = NULL;
+
+// Write position
+static uint32_t head_sector = 0;    // Sector being filled
+static uint32_t head_seq = 0;       // Sequence number of head sector (0 = empty log)
+
+// Buffer for the flash page being filled in the head sector
+static uint8_t page_buf[WEATHER_LOG_PAGE_SIZE];
+static uint32_t page_start = 0;     // First slot of the buffered page
+static uint32_t page_fill = 0;      // Slots filled in the buffer
+static uint32_t page_flushed = 0;   // Slots already programmed
+
+// Statistics
+static weather_log_stats_t stats = {0};
+static uint64_t append_time_total_us = 0;
+
+/**
+ * CRC of a record or header
+ */
+static uint32_t slot_crc(const void *slot)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)slot, CRC_LEN);
+}
+
+/**
+ * Check if a slot was never programmed
+ */
+static bool slot_erased(const uint8_t *slot)
+{
+    for (int i = 0; i < WEATHER_LOG_RECORD_SIZE; i++) {
+        if (slot[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Mapped address of a slot
+ */
+static const uint8_t *slot_ptr(uint32_t sector, uint32_t slot)
+{
+    return log_map + sector * WEATHER_LOG_SECTOR_SIZE + slot * WEATHER_LOG_RECORD_SIZE;
+}
+
+/**
+ * Check if a sector holds a valid header
+ */
+static bool sector_valid(uint32_t sector, uint32_t *seq)
+{
+    const sector_header_t *header = (const sector_header_t *)slot_ptr(sector, 0);
+
+    if (header->magic != SECTOR_MAGIC || header->version != LOG_VERSION ||
+        header->record_size != WEATHER_LOG_RECORD_SIZE || header->crc != slot_crc(header)) {
+        return false;
+    }
+
+    *seq = header->seq;
+    return true;
+}
+
+/**
+ * Check if a sector belongs to the current lap of the log
+ */
+static bool sector_live(uint32_t sector, uint32_t newest_seq)
+{
+    uint32_t seq;
+    return sector_valid(sector, &seq) && seq <= newest_seq && seq + sector_count > newest_seq;
+}
+
+/**
+ * Count programmed record slots in a sector
+ */
+static uint32_t sector_records(uint32_t sector)
+{
+    uint32_t slot = 1;
+    while (slot < SLOTS_PER_SECTOR && !slot_erased(slot_ptr(sector, slot))) {
+        slot++;
+    }
+    return slot - 1;
+}
+
+/**
+ * Program buffered slots (caller holds log_mutex)
+ */
+static esp_err_t flush_locked(void)
+{
+    if (page_flushed >= page_fill) {
+        return ESP_OK;
+    }
+
+    size_t offset = head_sector * WEATHER_LOG_SECTOR_SIZE + (page_start + page_flushed) * WEATHER_LOG_RECORD_SIZE;
+    esp_err_t err = esp_partition_write(log_partition, offset,
+                                        page_buf + page_flushed * WEATHER_LOG_RECORD_SIZE,
+                                        (page_fill - page_flushed) * WEATHER_LOG_RECORD_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Page write failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    page_flushed = page_fill;
+    stats.pages_written++;
+    return ESP_OK;
+}
+
+/**
+ * Erase the next sector and start filling it (caller holds log_mutex)
+ * The oldest sector is recycled, so every sector is erased once per lap.
+ */
+static esp_err_t open_sector_locked(void)
+{
+    uint32_t next = (head_sector + 1) % sector_count;
+
+    if (sector_live(next, head_seq)) {
+        stats.record_count -= sector_records(next);
+    }
+
+    esp_err_t err = esp_partition_erase_range(log_partition, next * WEATHER_LOG_SECTOR_SIZE,
+                                              WEATHER_LOG_SECTOR_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Sector erase failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    stats.sectors_erased++;
+
+    head_sector = next;
+    head_seq++;
+
+    // Header goes out with the first page of records
+    sector_header_t header = {
+        .magic = SECTOR_MAGIC,
+        .version = LOG_VERSION,
+        .record_size = WEATHER_LOG_RECORD_SIZE,
+        .seq = head_seq,
+    };
+    header.crc = slot_crc(&header);
+
+    memset(page_buf, 0xFF, sizeof(page_buf));
+    memcpy(page_buf, &header, sizeof(header));
+    page_start = 0;
+    page_fill = 1;
+    page_flushed = 0;
+
+    return ESP_OK;
+}
+
+/**
+ * Flush on esp_restart (OTA, WiFi reconfiguration)
+ */
+static void weather_log_shutdown_handler(void)
+{
+    weather_log_flush();
+}
+
+/**
+ * Mount log partition
+ */
+esp_err_t weather_log_init(void)
+{
+    if (log_map) {
+        return ESP_OK;
+    }
+
+    log_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                             WEATHER_LOG_PARTITION_LABEL);
+    if (!log_partition) {
+        ESP_LOGW(TAG, "No '%s' partition, weather log disabled", WEATHER_LOG_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const void *map = NULL;
+    esp_err_t err = esp_partition_mmap(log_partition, 0, log_partition->size,
+                                       ESP_PARTITION_MMAP_DATA, &map, &log_map_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Partition mmap failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    log_mutex = xSemaphoreCreateMutex();
+    sector_count = log_partition->size / WEATHER_LOG_SECTOR_SIZE;
+    log_map = map;
+
+    // Newest sector holds the write position
+    head_seq = 0;
+    head_sector = sector_count - 1;
+    for (uint32_t sector = 0; sector < sector_count; sector++) {
+        uint32_t seq;
+        if (sector_valid(sector, &seq) && seq > head_seq) {
+            head_seq = seq;
+            head_sector = sector;
+        }
+    }
+
+    stats.record_count = 0;
+    for (uint32_t sector = 0; sector < sector_count && head_seq > 0; sector++) {
+        if (sector_live(sector, head_seq)) {
+            stats.record_count += sector_records(sector);
+        }
+    }
+
+    // Resume inside the head page (a full or missing head sector opens a new one on append)
+    uint32_t head_slot = (head_seq > 0) ? sector_records(head_sector) + 1 : SLOTS_PER_SECTOR;
+    page_start = head_slot - (head_slot % WEATHER_LOG_RECORDS_PER_PAGE);
+    page_fill = page_flushed = head_slot - page_start;
+    memset(page_buf, 0xFF, sizeof(page_buf));
+    if (page_start < SLOTS_PER_SECTOR) {
+        memcpy(page_buf, slot_ptr(head_sector, page_start), page_fill * WEATHER_LOG_RECORD_SIZE);
+    }
+
+    stats.sector_count = sector_count;
+    stats.capacity = sector_count * WEATHER_LOG_RECORDS_PER_SECTOR;
+
+    esp_register_shutdown_handler(weather_log_shutdown_handler);
+
+    ESP_LOGI(TAG, "Weather log mounted: %lu sectors, %lu/%lu records, sector seq %lu",
+             (unsigned long)sector_count, (unsigned long)stats.record_count,
+             (unsigned long)stats.capacity, (unsigned long)head_seq);
+    return ESP_OK;
+}
+
+/**
+ * Unmount log partition
+ */
+void weather_log_deinit(void)
+{
+    if (!log_map) {
+        return;
+    }
+
+    esp_unregister_shutdown_handler(weather_log_shutdown_handler);
+    esp_partition_munmap(log_map_handle);
+    vSemaphoreDelete(log_mutex);
+    log_mutex = NULL;
+    log_map = NULL;
+    log_partition = NULL;
+    memset(&stats, 0, sizeof(stats));
+    append_time_total_us = 0;
+}
+
+/**
+ * Append sample
+ */
+esp_err_t weather_log_append(uint32_t timestamp, uint8_t station, int16_t temperature, uint16_t humidity)
+{
+    if (!log_map) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+
+    weather_log_record_t record = {
+        .timestamp = timestamp,
+        .temperature = temperature,
+        .humidity = humidity,
+        .station = station,
+        .flags = WEATHER_LOG_FLAG_FIXED,
+    };
+    record.crc = slot_crc(&record);
+
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+
+    esp_err_t err = ESP_OK;
+    if (page_start >= SLOTS_PER_SECTOR) {
+        err = open_sector_locked();
+    }
+
+    if (err == ESP_OK) {
+        memcpy(page_buf + page_fill * WEATHER_LOG_RECORD_SIZE, &record, sizeof(record));
+        page_fill++;
+        stats.record_count++;
+        stats.appended++;
+
+        // Program whole pages; the next page starts empty
+        if (page_fill == WEATHER_LOG_RECORDS_PER_PAGE) {
+            err = flush_locked();
+            page_start += WEATHER_LOG_RECORDS_PER_PAGE;
+            page_fill = page_flushed = 0;
+            memset(page_buf, 0xFF, sizeof(page_buf));
+        }
+    }
+
+    append_time_total_us += esp_timer_get_time() - start_us;
+    stats.avg_append_us = (uint32_t)(append_time_total_us / (stats.appended ? stats.appended : 1));
+
+    xSemaphoreGive(log_mutex);
+    return err;
+}
+
+/**
+ * Flush buffered records
+ */
+esp_err_t weather_log_flush(void)
+{
+    if (!log_map) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+    esp_err_t err = flush_locked();
+    xSemaphoreGive(log_mutex);
+    return err;
+}
+
+/**
+ * Visit records in time range
+ */
+size_t weather_log_iterate(uint32_t from, uint32_t to, weather_log_visit_cb_t cb, void *ctx)
+{
+    if (!log_map || !cb) {
+        return 0;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+
+    // Snapshot the write position and the records not yet in flash
+    weather_log_record_t pending[WEATHER_LOG_RECORDS_PER_PAGE];
+    size_t pending_count = 0;
+
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+    uint32_t newest_sector = head_sector;
+    uint32_t newest_seq = head_seq;
+    uint32_t flushed_end = page_start + page_flushed;
+    for (uint32_t i = page_flushed; i < page_fill; i++) {
+        if (page_start + i > 0) {
+            memcpy(&pending[pending_count++], page_buf + i * WEATHER_LOG_RECORD_SIZE, WEATHER_LOG_RECORD_SIZE);
+        }
+    }
+    xSemaphoreGive(log_mutex);
+
+    size_t visited = 0;
+    bool keep_going = true;
+
+    // Oldest sector first; records are read in place. A sector recycled while
+    // we read it shows up as erased or CRC-failing slots and is skipped.
+    for (uint32_t i = 1; i <= sector_count && keep_going && newest_seq > 0; i++) {
+        uint32_t sector = (newest_sector + i) % sector_count;
+        if (!sector_live(sector, newest_seq)) {
+            continue;
+        }
+
+        uint32_t end = (sector == newest_sector) ? flushed_end : SLOTS_PER_SECTOR;
+        for (uint32_t slot = 1; slot < end && keep_going; slot++) {
+            const weather_log_record_t *record = (const weather_log_record_t *)slot_ptr(sector, slot);
+            if (slot_erased((const uint8_t *)record)) {
+                break;
+            }
+            if (record->crc != slot_crc(record) || record->timestamp < from || record->timestamp > to) {
+                continue;
+            }
+            visited++;
+            keep_going = cb(record, ctx);
+        }
+    }
+
+    for (size_t i = 0; i < pending_count && keep_going; i++) {
+        if (pending[i].timestamp >= from && pending[i].timestamp <= to) {
+            visited++;
+            keep_going = cb(&pending[i], ctx);
+        }
+    }
+
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+    stats.last_query_us = elapsed_us;
+    stats.last_query_records = visited;
+    xSemaphoreGive(log_mutex);
+    return visited;
+}
+
+/**
+ * Get record values
+ */
+void weather_log_record_values(const weather_log_record_t *record, int16_t *temperature, uint16_t *humidity)
+{
+    if (record->flags & WEATHER_LOG_FLAG_FIXED) {
+        *temperature = (int16_t)record->temperature;
+        *humidity = record->humidity;
+        return;
+    }
+
+    // Records written before the fixed-point format: binary32 Celsius, whole %
+    int32_t value = 0;
+    fixed_from_float_bits((uint32_t)record->temperature, FIXED_TEMP_DECIMALS, &value);
+    *temperature = (int16_t)((value < INT16_MIN) ? INT16_MIN : (value > INT16_MAX) ? INT16_MAX : value);
+    *humidity = (uint16_t)(record->humidity * FIXED_HUM_SCALE);
+}
+
+/**
+ * Get statistics
+ */
+void weather_log_get_stats(weather_log_stats_t *out)
+{
+    if (!out) {
+        return;
+    }
+
+    if (log_mutex) {
+        xSemaphoreTake(log_mutex, portMAX_DELAY);
+    }
+    *out = stats;
+    out->sector_seq = head_seq;
+    out->erase_cycles = sector_count ? head_seq / sector_count : 0;
+    out->pending = page_fill - page_flushed;
+    if (page_start == 0 && page_flushed == 0 && page_fill > 0) {
+        out->pending--;     // Unwritten sector header
+    }
+    if (log_mutex) {
+        xSemaphoreGive(log_mutex);
+    }
+}
+
+/**
+ * Check if mounted
+ */
+bool weather_log_is_ready(void)
+{
+    return log_map != NULL;
+}
@@ -0,0 +1,105 @@
+#ifndef WEATHER_METRICS_H
+#define WEATHER_METRICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Rolling windows (both end at the latest sample)
+#define WEATHER_METRICS_SHORT_WINDOW_S  3600        // 1 hour
+#define WEATHER_METRICS_LONG_WINDOW_S   86400       // 24 hours
+
+// Samples closer than this to the previous windowed sample update the derived
+// values but are left out of the windows, which bounds window memory
+#define WEATHER_METRICS_MIN_SPACING_S   900
+
+// Samples held for the long window
+#define WEATHER_METRICS_SAMPLES         (WEATHER_METRICS_LONG_WINDOW_S / WEATHER_METRICS_MIN_SPACING_S + 1)
+
+_Static_assert(WEATHER_METRICS_SAMPLES <= 255, "Window slots are indexed with uint8_t");
+
+// Cycle-count comparison of the fixed-point path with the soft-float one,
+// logged once at startup (see weather_metrics_benchmark)
+#define WEATHER_METRICS_BENCHMARK       0
+
+// Statistics over one rolling window (temperature in 0.01 °C, humidity in 0.1 %)
+typedef struct {
+    int16_t temp_min;
+    int16_t temp_max;
+    int16_t temp_mean;
+    uint16_t hum_min;
+    uint16_t hum_max;
+    uint16_t hum_mean;
+    uint16_t count;         // Samples in window (0 = no data)
+} weather_window_stats_t;
+
+// Values derived from one temperature/humidity reading (0.01 °C)
+typedef struct {
+    int16_t dew_point;              // Magnus formula
+    int16_t heat_index;             // NOAA, Rothfusz regression above 26.7 °C
+    int16_t apparent_temperature;   // Steadman/BoM, calm air, shade
+} weather_derived_t;
+
+// Monotonic deque of sample slots
+typedef struct {
+    uint8_t slot[WEATHER_METRICS_SAMPLES];
+    uint8_t head;
+    uint8_t len;
+} weather_deque_t;
+
+// Rolling window over the shared sample ring
+typedef struct {
+    uint32_t duration_s;
+    uint32_t first;                 // Sequence number of the oldest sample in the window
+    int32_t temp_sum;               // 0.01 °C
+    int32_t hum_sum;                // 0.1 %
+    weather_deque_t temp_max;       // Decreasing values, front is the maximum
+    weather_deque_t temp_min;       // Increasing values, front is the minimum
+    weather_deque_t hum_max;
+    weather_deque_t hum_min;
+} weather_window_t;
+
+// Metrics engine for one station (every update is O(1) amortized)
+typedef struct {
+    uint32_t time[WEATHER_METRICS_SAMPLES];
+    int16_t temperature[WEATHER_METRICS_SAMPLES];   // 0.01 °C
+    uint16_t humidity[WEATHER_METRICS_SAMPLES];     // 0.1 %
+    uint32_t next;                                  // Sequence number of the next sample
+    uint32_t last_time;                             // Time of the last windowed sample
+    weather_window_t short_window;
+    weather_window_t long_window;
+} weather_metrics_t;
+
+/**
+ * Reset engine
+ */
+void weather_metrics_init(weather_metrics_t *metrics);
+
+/**
+ * Add a sample to the rolling windows
+ * @return false if the sample is older than the last one or too close to it
+ */
+bool weather_metrics_add(weather_metrics_t *metrics, uint32_t timestamp, int16_t temperature, uint16_t humidity);
+
+/**
+ * Get statistics of the 1 h and 24 h windows
+ */
+void weather_metrics_get(const weather_metrics_t *metrics,
+                         weather_window_stats_t *short_window, weather_window_stats_t *long_window);
+
+/**
+ * Compute dew point, heat index and apparent temperature of a reading
+ * Integer arithmetic only, valid from -40 °C to 60 °C (inputs are clamped).
+ * @param temperature 0.01 °C
+ * @param humidity 0.1 %
+ */
+void weather_metrics_derive(int16_t temperature, uint16_t humidity, weather_derived_t *derived);
+
+#if WEATHER_METRICS_BENCHMARK
+/**
+ * Log CPU cycles per operation of the fixed-point path (parse, derive,
+ * format) against the equivalent soft-float code
+ */
+void weather_metrics_benchmark(void);
+#endif
+
+#endif // WEATHER_METRICS_H
@@ -0,0 +1,348 @@
+#include "weather_metrics.h"
+#include "fixed_point.h"
+#include <string.h>
+
+// Saturation vapour pressure table range (0.01 °C)
+#define ES_TABLE_MIN        (-4000)
+#define ES_TABLE_MAX        6000
+#define ES_TABLE_STEP       100
+
+// Saturation vapour pressure over water in mPa, every 1 °C from -40 °C to 60 °C
+// (Magnus: es = 611.2 * exp(17.62 * T / (243.12 + T)) Pa). Linear interpolation
+// between entries stays within 0.05 % of the formula.
+static const uint32_t es_table[] = {
+    19021, 21092, 23364, 25855, 28584, 31571, 34836, 38403,
+    42297, 46543, 51169, 56205, 61683, 67636, 74102, 81117,
+    88723, 96964, 105885, 115534, 125965, 137232, 149392, 162508,
+    176645, 191871, 208259, 225886, 244833, 265184, 287031, 310468,
+    335593, 362514, 391339, 422185, 455173, 490431, 528093, 568301,
+    611200, 656946, 705700, 757632, 812918, 871743, 934300, 1000793,
+    1071430, 1146433, 1226030, 1310462, 1399976, 1494834, 1595306, 1701672,
+    1814226, 1933273, 2059129, 2192122, 2332596, 2480904, 2637415, 2802511,
+    2976588, 3160057, 3353343, 3556889, 3771149, 3996598, 4233724, 4483033,
+    4745050, 5020314, 5309386, 5612842, 5931279, 6265314, 6615581, 6982737,
+    7367458, 7770442, 8192406, 8634094, 9096266, 9579710, 10085234, 10613672,
+    11165880, 11742740, 12345158, 12974067, 13630424, 14315214, 15029448, 15774163,
+    16550428, 17359335, 18202007, 19079598, 19993287,
+};
+
+#define ES_TABLE_LEN        (sizeof(es_table) / sizeof(es_table[0]))
+
+_Static_assert(ES_TABLE_LEN == (ES_TABLE_MAX - ES_TABLE_MIN) / ES_TABLE_STEP + 1, "Vapour pressure table size");
+
+// Sample columns tracked by the windows
+typedef enum {
+    COLUMN_TEMPERATURE = 0,
+    COLUMN_HUMIDITY
+} column_t;
+
+/**
+ * Ring slot of a sequence number
+ */
+static uint8_t slot_of(uint32_t seq)
+{
+    return (uint8_t)(seq % WEATHER_METRICS_SAMPLES);
+}
+
+/**
+ * Value of a sample column
+ */
+static int32_t sample_value(const weather_metrics_t *metrics, column_t column, uint8_t slot)
+{
+    return (column == COLUMN_TEMPERATURE) ? metrics->temperature[slot] : metrics->humidity[slot];
+}
+
+/**
+ * Push a slot at the back, dropping entries it dominates
+ * @param is_max true to keep the maximum at the front, false for the minimum
+ */
+static void deque_push(weather_deque_t *deque, const weather_metrics_t *metrics, column_t column,
+                       uint8_t slot, bool is_max)
+{
+    int32_t value = sample_value(metrics, column, slot);
+
+    while (deque->len > 0) {
+        uint8_t back = deque->slot[(deque->head + deque->len - 1) % WEATHER_METRICS_SAMPLES];
+        int32_t back_value = sample_value(metrics, column, back);
+        if (is_max ? (back_value > value) : (back_value < value)) {
+            break;
+        }
+        deque->len--;
+    }
+
+    deque->slot[(deque->head + deque->len) % WEATHER_METRICS_SAMPLES] = slot;
+    deque->len++;
+}
+
+/**
+ * Drop the front entry if it is the expiring slot
+ */
+static void deque_expire(weather_deque_t *deque, uint8_t slot)
+{
+    if (deque->len > 0 && deque->slot[deque->head] == slot) {
+        deque->head = (deque->head + 1) % WEATHER_METRICS_SAMPLES;
+        deque->len--;
+    }
+}
+
+/**
+ * Value at the front of a deque
+ */
+static int32_t deque_front(const weather_deque_t *deque, const weather_metrics_t *metrics, column_t column)
+{
+    return sample_value(metrics, column, deque->slot[deque->head]);
+}
+
+/**
+ * Remove samples that left the window (each sample leaves once)
+ */
+static void window_expire(weather_window_t *window, const weather_metrics_t *metrics, uint32_t now)
+{
+    while (window->first < metrics->next) {
+        uint8_t slot = slot_of(window->first);
+        // The ring is about to wrap onto this slot: drop it regardless of age
+        bool evict = (metrics->next - window->first >= WEATHER_METRICS_SAMPLES);
+        if (!evict && metrics->time[slot] + window->duration_s > now) {
+            break;
+        }
+
+        window->temp_sum -= metrics->temperature[slot];
+        window->hum_sum -= metrics->humidity[slot];
+        deque_expire(&window->temp_max, slot);
+        deque_expire(&window->temp_min, slot);
+        deque_expire(&window->hum_max, slot);
+        deque_expire(&window->hum_min, slot);
+        window->first++;
+    }
+}
+
+/**
+ * Add the newest sample to a window
+ */
+static void window_push(weather_window_t *window, const weather_metrics_t *metrics, uint8_t slot)
+{
+    window->temp_sum += metrics->temperature[slot];
+    window->hum_sum += metrics->humidity[slot];
+    deque_push(&window->temp_max, metrics, COLUMN_TEMPERATURE, slot, true);
+    deque_push(&window->temp_min, metrics, COLUMN_TEMPERATURE, slot, false);
+    deque_push(&window->hum_max, metrics, COLUMN_HUMIDITY, slot, true);
+    deque_push(&window->hum_min, metrics, COLUMN_HUMIDITY, slot, false);
+}
+
+/**
+ * Statistics of a window
+ */
+static void window_stats(const weather_window_t *window, const weather_metrics_t *metrics,
+                         weather_window_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    uint32_t count = metrics->next - window->first;
+    if (count == 0) {
+        return;
+    }
+
+    stats->count = (uint16_t)count;
+    stats->temp_min = (int16_t)deque_front(&window->temp_min, metrics, COLUMN_TEMPERATURE);
+    stats->temp_max = (int16_t)deque_front(&window->temp_max, metrics, COLUMN_TEMPERATURE);
+    stats->temp_mean = (int16_t)fixed_div_round(window->temp_sum, count);
+    stats->hum_min = (uint16_t)deque_front(&window->hum_min, metrics, COLUMN_HUMIDITY);
+    stats->hum_max = (uint16_t)deque_front(&window->hum_max, metrics, COLUMN_HUMIDITY);
+    stats->hum_mean = (uint16_t)fixed_div_round(window->hum_sum, count);
+}
+
+/**
+ * Reset engine
+ */
+void weather_metrics_init(weather_metrics_t *metrics)
+{
+    memset(metrics, 0, sizeof(*metrics));
+    metrics->short_window.duration_s = WEATHER_METRICS_SHORT_WINDOW_S;
+    metrics->long_window.duration_s = WEATHER_METRICS_LONG_WINDOW_S;
+}
+
+/**
+ * Add a sample
+ */
+bool weather_metrics_add(weather_metrics_t *metrics, uint32_t timestamp, int16_t temperature, uint16_t humidity)
+{
+    if (metrics->next > 0 && timestamp < metrics->last_time + WEATHER_METRICS_MIN_SPACING_S) {
+        return false;
+    }
+
+    if (humidity > 100 * FIXED_HUM_SCALE) {
+        humidity = 100 * FIXED_HUM_SCALE;
+    }
+
+    // Expire against the new time first, which frees the slot about to be written
+    window_expire(&metrics->short_window, metrics, timestamp);
+    window_expire(&metrics->long_window, metrics, timestamp);
+
+    uint8_t slot = slot_of(metrics->next);
+    metrics->time[slot] = timestamp;
+    metrics->temperature[slot] = temperature;
+    metrics->humidity[slot] = humidity;
+    metrics->next++;
+    metrics->last_time = timestamp;
+
+    window_push(&metrics->short_window, metrics, slot);
+    window_push(&metrics->long_window, metrics, slot);
+    return true;
+}
+
+/**
+ * Get window statistics
+ */
+void weather_metrics_get(const weather_metrics_t *metrics,
+                         weather_window_stats_t *short_window, weather_window_stats_t *long_window)
+{
+    if (short_window) {
+        window_stats(&metrics->short_window, metrics, short_window);
+    }
+    if (long_window) {
+        window_stats(&metrics->long_window, metrics, long_window);
+    }
+}
+
+/**
+ * Saturation vapour pressure (mPa) at a temperature within the table range
+ */
+static uint32_t saturation_pressure(int32_t temperature)
+{
+    uint32_t offset = (uint32_t)(temperature - ES_TABLE_MIN);
+    uint32_t i = offset / ES_TABLE_STEP;
+    uint32_t frac = offset % ES_TABLE_STEP;
+
+    if (i >= ES_TABLE_LEN - 1) {
+        return es_table[ES_TABLE_LEN - 1];
+    }
+    return es_table[i] + (uint32_t)(((uint64_t)(es_table[i + 1] - es_table[i]) * frac + ES_TABLE_STEP / 2) / ES_TABLE_STEP);
+}
+
+/**
+ * Temperature (0.01 °C) at which the saturation vapour pressure is e (mPa)
+ */
+static int32_t saturation_temperature(uint32_t e)
+{
+    if (e <= es_table[0]) {
+        return ES_TABLE_MIN;
+    }
+
+    // Last entry not above e
+    uint32_t lo = 0;
+    uint32_t hi = ES_TABLE_LEN - 1;
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) / 2;
+        if (es_table[mid] <= e) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    if (e >= es_table[hi]) {
+        return ES_TABLE_MAX;
+    }
+
+    return ES_TABLE_MIN + (int32_t)lo * ES_TABLE_STEP +
+           fixed_div_round((int64_t)(e - es_table[lo]) * ES_TABLE_STEP, es_table[hi] - es_table[lo]);
+}
+
+/**
+ * Integer square root
+ */
+static uint32_t isqrt(uint32_t value)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/**
+ * Clamp to the int16_t range
+ */
+static int16_t clamp_int16(int32_t value)
+{
+    return (int16_t)((value < INT16_MIN) ? INT16_MIN : (value > INT16_MAX) ? INT16_MAX : value);
+}
+
+/**
+ * Heat index (0.01 °F) of a temperature in 0.01 °F and humidity in 0.1 %
+ */
+static int32_t heat_index_f(int64_t t, int64_t rh)
+{
+    // Simple formula: 0.5 * (T + 61 + (T - 68) * 1.2 + RH * 0.094)
+    int32_t hi = fixed_div_round(50 * t + 305000 + 60 * (t - 6800) + 47 * rh, 100);
+    if ((hi + t) / 2 < 8000) {
+        return hi;
+    }
+
+    // Rothfusz regression, coefficients scaled by 10^8 over a common denominator
+    // of 10^12 (T = t / 100, RH = rh / 10, result in 0.01 °F)
+    int64_t sum = -4237900000LL * 1000000 +
+                  204901523LL * t * 10000 +
+                  1014333127LL * rh * 100000 -
+                  22475541LL * t * rh * 1000 -
+                  683783LL * t * t * 100 -
+                  5481717LL * rh * rh * 10000 +
+                  122874LL * t * t * rh * 10 +
+                  85282LL * t * rh * rh * 100 -
+                  199LL * t * t * rh * rh;
+    hi = fixed_div_round(sum, 1000000000000LL);
+
+    if (rh < 130 && t >= 8000 && t <= 11200) {
+        // - (13 - RH) / 4 * sqrt((17 - |T - 95|) / 17)
+        int64_t distance = (t > 9500) ? t - 9500 : 9500 - t;
+        uint32_t root = isqrt((uint32_t)((1700 - distance) * 1000000 / 1700));     // x1000
+        hi -= fixed_div_round((130 - rh) * root, 400);
+    } else if (rh > 850 && t >= 8000 && t <= 8700) {
+        // + (RH - 85) / 10 * (87 - T) / 5
+        hi += fixed_div_round((rh - 850) * (8700 - t), 500);
+    }
+    return hi;
+}
+
+/**
+ * Compute derived values
+ */
+void weather_metrics_derive(int16_t temperature, uint16_t humidity, weather_derived_t *derived)
+{
+    int32_t t = temperature;
+    int32_t rh = humidity;
+
+    if (t < ES_TABLE_MIN) {
+        t = ES_TABLE_MIN;
+    } else if (t > ES_TABLE_MAX) {
+        t = ES_TABLE_MAX;
+    }
+    if (rh < FIXED_HUM_SCALE) {
+        rh = FIXED_HUM_SCALE;
+    } else if (rh > 100 * FIXED_HUM_SCALE) {
+        rh = 100 * FIXED_HUM_SCALE;
+    }
+
+    // Vapour pressure, mPa
+    uint32_t e = (uint32_t)fixed_div_round((int64_t)saturation_pressure(t) * rh, 100 * FIXED_HUM_SCALE);
+
+    // Dew point: temperature at which e is the saturation pressure (inverse Magnus)
+    derived->dew_point = (int16_t)saturation_temperature(e);
+
+    // Heat index, NOAA (computed in °F)
+    int32_t hi = heat_index_f(fixed_div_round((int64_t)t * 9, 5) + 3200, rh);
+    derived->heat_index = clamp_int16(fixed_div_round((int64_t)(hi - 3200) * 5, 9));
+
+    // Apparent temperature, Steadman/BoM without wind: AT = T + 0.33 e(hPa) - 4.0
+    derived->apparent_temperature = (int16_t)(t + fixed_div_round((int64_t)e * 33, 100000) - 400);
+}
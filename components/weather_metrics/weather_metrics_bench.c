@@ -0,0 +1,170 @@
+#include "weather_metrics.h"
+
+#if WEATHER_METRICS_BENCHMARK
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "fixed_point.h"
+
+#define BENCH_ITERATIONS    1000
+#define BENCH_INPUTS        8
+
+static const char *TAG = "metrics_bench";
+
+// Response tokens as the JSON decoder sees them
+static const char *const bench_temperature[BENCH_INPUTS] = {
+    "26.4", "-3.85", "31.07", "12", "0.5", "27.9", "35.25", "18.6"
+};
+static const char *const bench_humidity[BENCH_INPUTS] = {
+    "91", "45", "62", "100", "8", "77", "55", "83"
+};
+
+// Decoded inputs of both paths
+static int16_t fixed_temperature[BENCH_INPUTS];
+static uint16_t fixed_humidity[BENCH_INPUTS];
+static float float_temperature[BENCH_INPUTS];
+static float float_humidity[BENCH_INPUTS];
+
+// Results are stored here so the work is not optimized away
+static volatile int32_t fixed_sink;
+static volatile float float_sink;
+static char text_sink[32];
+
+/**
+ * Soft-float derive, as computed before the fixed-point path
+ */
+static void derive_float(float temperature, float rh, float *dew_point, float *heat_index, float *apparent)
+{
+    float gamma = logf(rh / 100.0f) + 17.62f * temperature / (243.12f + temperature);
+    *dew_point = 243.12f * gamma / (17.62f - gamma);
+
+    float t = temperature * 9.0f / 5.0f + 32.0f;
+    float hi = 0.5f * (t + 61.0f + (t - 68.0f) * 1.2f + rh * 0.094f);
+    if ((hi + t) / 2.0f >= 80.0f) {
+        hi = -42.379f + 2.04901523f * t + 10.14333127f * rh - 0.22475541f * t * rh -
+             0.00683783f * t * t - 0.05481717f * rh * rh + 0.00122874f * t * t * rh +
+             0.00085282f * t * rh * rh - 0.00000199f * t * t * rh * rh;
+        if (rh < 13.0f && t >= 80.0f && t <= 112.0f) {
+            hi -= ((13.0f - rh) / 4.0f) * sqrtf((17.0f - fabsf(t - 95.0f)) / 17.0f);
+        } else if (rh > 85.0f && t >= 80.0f && t <= 87.0f) {
+            hi += ((rh - 85.0f) / 10.0f) * ((87.0f - t) / 5.0f);
+        }
+    }
+    *heat_index = (hi - 32.0f) * 5.0f / 9.0f;
+
+    float e = rh / 100.0f * 6.112f * expf(17.62f * temperature / (243.12f + temperature));
+    *apparent = temperature + 0.33f * e - 4.0f;
+}
+
+/**
+ * Parse a temperature token, fixed-point
+ */
+static void parse_fixed(int i)
+{
+    const char *text = bench_temperature[i % BENCH_INPUTS];
+    int32_t value;
+    fixed_parse(text, strlen(text), FIXED_TEMP_DECIMALS, &value);
+    fixed_sink = value;
+}
+
+/**
+ * Parse a temperature token, soft-float
+ */
+static void parse_float(int i)
+{
+    float_sink = strtof(bench_temperature[i % BENCH_INPUTS], NULL);
+}
+
+/**
+ * Derive values, fixed-point
+ */
+static void derive_fixed_path(int i)
+{
+    weather_derived_t derived;
+    weather_metrics_derive(fixed_temperature[i % BENCH_INPUTS], fixed_humidity[i % BENCH_INPUTS], &derived);
+    fixed_sink = derived.dew_point + derived.heat_index + derived.apparent_temperature;
+}
+
+/**
+ * Derive values, soft-float
+ */
+static void derive_float_path(int i)
+{
+    float dew_point, heat_index, apparent;
+    derive_float(float_temperature[i % BENCH_INPUTS], float_humidity[i % BENCH_INPUTS],
+                 &dew_point, &heat_index, &apparent);
+    float_sink = dew_point + heat_index + apparent;
+}
+
+/**
+ * Format a temperature, fixed-point
+ */
+static void format_fixed(int i)
+{
+    fixed_format(text_sink, sizeof(text_sink), fixed_temperature[i % BENCH_INPUTS], FIXED_TEMP_DECIMALS);
+}
+
+/**
+ * Format a temperature, soft-float
+ */
+static void format_float(int i)
+{
+    // cJSON prints numbers with "%1.15g"
+    snprintf(text_sink, sizeof(text_sink), "%1.15g", (double)float_temperature[i % BENCH_INPUTS]);
+}
+
+/**
+ * Mean cycles of one call
+ */
+static uint32_t bench_cycles(void (*fn)(int))
+{
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        fn(i);
+    }
+    return (esp_cpu_get_cycle_count() - start) / BENCH_ITERATIONS;
+}
+
+/**
+ * Run benchmark
+ */
+void weather_metrics_benchmark(void)
+{
+    for (int i = 0; i < BENCH_INPUTS; i++) {
+        int32_t temperature = 0;
+        int32_t humidity = 0;
+        fixed_parse(bench_temperature[i], strlen(bench_temperature[i]), FIXED_TEMP_DECIMALS, &temperature);
+        fixed_parse(bench_humidity[i], strlen(bench_humidity[i]), FIXED_HUM_DECIMALS, &humidity);
+        fixed_temperature[i] = (int16_t)temperature;
+        fixed_humidity[i] = (uint16_t)humidity;
+        float_temperature[i] = strtof(bench_temperature[i], NULL);
+        float_humidity[i] = strtof(bench_humidity[i], NULL);
+    }
+
+    static const struct {
+        const char *name;
+        void (*fixed)(int);
+        void (*soft_float)(int);
+    } cases[] = {
+        {"parse",  parse_fixed,       parse_float},
+        {"derive", derive_fixed_path, derive_float_path},
+        {"format", format_fixed,      format_float},
+    };
+
+    ESP_LOGI(TAG, "Cycles per call (mean of %d)", BENCH_ITERATIONS);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        // Warm up caches before measuring
+        bench_cycles(cases[i].fixed);
+        bench_cycles(cases[i].soft_float);
+        uint32_t fixed = bench_cycles(cases[i].fixed);
+        uint32_t soft_float = bench_cycles(cases[i].soft_float);
+        ESP_LOGI(TAG, "%-6s  fixed %6lu  soft-float %6lu  (%lu.%02lux)", cases[i].name,
+                 (unsigned long)fixed, (unsigned long)soft_float,
+                 (unsigned long)(soft_float / (fixed ? fixed : 1)),
+                 (unsigned long)(soft_float * 100 / (fixed ? fixed : 1) % 100));
+    }
+}
+#endif
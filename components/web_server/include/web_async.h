@@ -0,0 +1,50 @@
+#ifndef WEB_ASYNC_H
+#define WEB_ASYNC_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/*
+ * Worker pool for slow handlers.
+ *
+ * esp_http_server runs every handler on its one task, so a handler that
+ * blocks (an upload, a flash write) stalls every other request. A URI
+ * handler can pass the request to web_async_dispatch() to run a handler on
+ * a worker instead: the request is detached with httpd_req_async_handler_begin() and queued, and
+ * the server task returns to its other sockets at once. When the queue is
+ * full the request is answered with 503 and its connection closed.
+ */
+
+#define WEB_ASYNC_WORKERS       2
+#define WEB_ASYNC_QUEUE_LEN     2       // Requests waiting for a free worker
+#define WEB_ASYNC_STACK_SIZE    4096
+#define WEB_ASYNC_PRIORITY      5       // Same as the httpd task
+
+// Handler run on a worker, with the detached copy of the request
+typedef esp_err_t (*web_async_handler_t)(httpd_req_t *req);
+
+typedef struct {
+    uint32_t queued;        // Requests handed to the workers
+    uint32_t rejected;      // Requests answered with 503
+    uint32_t busy;          // Workers running a handler now
+} web_async_stats_t;
+
+/**
+ * Start the workers (once)
+ */
+esp_err_t web_async_init(void);
+
+/**
+ * Queue the request for a worker (call from a URI handler and return the result)
+ * The copy passed to handler keeps req->user_ctx.
+ * @return ESP_FAIL when the request was rejected and its connection is closing
+ */
+esp_err_t web_async_dispatch(httpd_req_t *req, web_async_handler_t handler);
+
+/**
+ * Get worker pool statistics
+ */
+void web_async_get_stats(web_async_stats_t *stats);
+
+#endif // WEB_ASYNC_H
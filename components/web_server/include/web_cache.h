@@ -0,0 +1,48 @@
+#ifndef WEB_CACHE_H
+#define WEB_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "json_writer.h"
+
+/*
+ * Serialized JSON responses, rebuilt only when their state changes.
+ *
+ * An entry keeps the body its writer produced and the version of the state
+ * it was built from. While the version getter returns the same value, a
+ * request is answered from the stored body without building any JSON; an
+ * entry without a version getter is built once. Entries are only used from
+ * the server task, so they need no locking.
+ */
+
+typedef struct {
+    uint32_t (*version)(void);          // State version, NULL if immutable
+    void (*write)(json_writer_t *json); // Writes the whole document
+    char *body;                         // Static storage
+    size_t capacity;
+    size_t len;
+    uint32_t built_version;
+    bool valid;
+    uint32_t hits;
+    uint32_t rebuilds;
+} web_cache_t;
+
+// Static initializer over existing storage
+#define WEB_CACHE_INIT(version_fn, write_fn, storage) \
+    { .version = (version_fn), .write = (write_fn), .body = (storage), .capacity = sizeof(storage) }
+
+/**
+ * Get the body, rebuilt first if the state changed
+ * @return body (not terminated), NULL if it does not fit in the storage
+ */
+const char* web_cache_get(web_cache_t *cache, size_t *len);
+
+/**
+ * Send the body as a JSON response
+ */
+esp_err_t web_cache_send(httpd_req_t *req, web_cache_t *cache);
+
+#endif // WEB_CACHE_H
@@ -0,0 +1,113 @@
+#ifndef WEB_LIMIT_H
+#define WEB_LIMIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/*
+ * Admission control for the HTTP server.
+ *
+ * - Each source address gets a token bucket per endpoint class. A request
+ *   takes one token; without one it is answered 429 with Retry-After, a
+ *   fixed response with no body.
+ * - A source address may hold WEB_LIMIT_CLIENT_CONNECTIONS connections.
+ *   Further connections are closed at once, so one client cannot fill the
+ *   socket table and have LRU purge close everybody else's connections.
+ * - At most WEB_LIMIT_MAX_INFLIGHT requests are handled or queued for a
+ *   worker at a time; more are answered 503.
+ *
+ * Bench builds (WEB_LIMIT_EXEMPT_ENABLE) can exempt one source address for
+ * a while (POST /api/debug/limit, unauthenticated, so never in a release),
+ * e.g. the PC running tools/http_bench.py. Connections it opens before the
+ * exemption expires get no buckets and no connection limit; the in-flight
+ * cap still applies. The exemption is kept in RAM only.
+ *
+ * Everything but web_limit_release(), the exemption and the statistics runs
+ * on the server task (URI handlers, session open/close), so the client table
+ * needs no lock. Rejections are counted in http_rejected_total (/metrics).
+ */
+
+#define WEB_LIMIT_ENABLE                1       // 0 = admit everything, for every source
+#define WEB_LIMIT_EXEMPT_ENABLE         0       // 1 = POST /api/debug/limit (bench builds only)
+#define WEB_LIMIT_EXEMPT_TTL_S          600     // Exemption time when the request sets none
+#define WEB_LIMIT_EXEMPT_MAX_TTL_S      3600
+#define WEB_LIMIT_ADDR_STR_LEN          46      // Longest IPv6 text form + 1
+#define WEB_LIMIT_CLIENTS               24      // Tracked source addresses, one per socket at most
+#define WEB_LIMIT_CLIENT_CONNECTIONS    8       // Open connections per source address
+#define WEB_LIMIT_MAX_INFLIGHT          4       // Server task, workers and worker queue
+
+// Bucket size (burst) and refill rate per class and source address
+#define WEB_LIMIT_STATIC_BURST          10
+#define WEB_LIMIT_STATIC_PER_MIN        60      // Pages (gzipped, mostly 304)
+#define WEB_LIMIT_API_BURST             45
+#define WEB_LIMIT_API_PER_MIN           900     // JSON APIs, metrics, push channel
+#define WEB_LIMIT_OTA_BURST             2
+#define WEB_LIMIT_OTA_PER_MIN           2       // Firmware upload, WiFi save
+
+typedef enum {
+    WEB_LIMIT_STATIC,
+    WEB_LIMIT_API,
+    WEB_LIMIT_OTA,
+    WEB_LIMIT_CLASS_COUNT,
+} web_limit_class_t;
+
+typedef struct {
+    uint32_t rate[WEB_LIMIT_CLASS_COUNT];   // 429 by class
+    uint32_t connections;                   // Connections closed at open
+    uint32_t inflight;                      // 503 over the in-flight cap
+    uint32_t clients;                       // Source addresses tracked now
+} web_limit_stats_t;
+
+/**
+ * Register metrics (once)
+ */
+void web_limit_init(void);
+
+#if WEB_LIMIT_EXEMPT_ENABLE
+/**
+ * Exempt a source address from the rate and connection limits (any task)
+ * Applies to connections opened afterwards, until the exemption expires.
+ * @param addr IPv4 or IPv6 address, "" to remove the exemption
+ * @param ttl_s Seconds until it expires, capped at WEB_LIMIT_EXEMPT_MAX_TTL_S
+ * @return ESP_ERR_INVALID_ARG if addr is not an address
+ */
+esp_err_t web_limit_set_exempt(const char *addr, uint32_t ttl_s);
+
+/**
+ * Get the exempt address as text ("" if none or expired)
+ * @param ttl_s Set to the seconds left
+ */
+void web_limit_get_exempt(char *buf, size_t size, uint32_t *ttl_s);
+#endif
+
+/**
+ * New connection (session open callback)
+ * @return false to close it
+ */
+bool web_limit_session_open(int sockfd);
+
+/**
+ * Connection closed (session close callback)
+ */
+void web_limit_session_close(int sockfd);
+
+/**
+ * Admit a request of a class, or answer it (429 or 503)
+ * An admitted request must be released with web_limit_release().
+ * @param ret Set to the URI handler's return value when not admitted
+ */
+bool web_limit_admit(httpd_req_t *req, web_limit_class_t cls, esp_err_t *ret);
+
+/**
+ * End of an admitted request (any task)
+ */
+void web_limit_release(void);
+
+/**
+ * Get rejection statistics
+ */
+void web_limit_get_stats(web_limit_stats_t *stats);
+
+#endif // WEB_LIMIT_H
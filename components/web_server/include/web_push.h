@@ -0,0 +1,54 @@
+#ifndef WEB_PUSH_H
+#define WEB_PUSH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "json_writer.h"
+
+/*
+ * State push to dashboards over WebSocket.
+ *
+ * A topic is a piece of state with a version counter. One task polls the
+ * counters; when some changed, a single JSON message holding only the changed
+ * topics is built on the server task and sent to every WebSocket client, so
+ * the work per change does not depend on the number of viewers. A client gets
+ * every topic once right after connecting.
+ *
+ * Message: {"<topic>": {...}, ...}
+ */
+
+#define WEB_PUSH_URI            "/ws"
+#define WEB_PUSH_POLL_MS        500     // Version check interval (push latency)
+#define WEB_PUSH_MAX_TOPICS     8
+#define WEB_PUSH_MESSAGE_SIZE   1536    // Largest message (all topics)
+
+// One piece of pushed state
+typedef struct {
+    const char *name;                   // Key in the message
+    uint32_t (*version)(void);          // Changes when the state changes
+    void (*write)(json_writer_t *json); // Writes the members of the topic object
+} web_push_topic_t;
+
+/**
+ * Start watching topics (the array must stay valid while running)
+ */
+esp_err_t web_push_start(httpd_handle_t server, const web_push_topic_t *topics, size_t count);
+
+/**
+ * Stop watching topics (call before httpd_stop)
+ */
+void web_push_stop(void);
+
+/**
+ * WebSocket handler, register for WEB_PUSH_URI with is_websocket set
+ */
+esp_err_t web_push_ws_handler(httpd_req_t *req);
+
+/**
+ * Get number of WebSocket clients (recounted on every broadcast)
+ */
+uint32_t web_push_client_count(void);
+
+#endif // WEB_PUSH_H
@@ -0,0 +1,117 @@
+#include "web_async.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "WEB_ASYNC";
+
+// Detached request waiting for a worker
+typedef struct {
+    httpd_req_t *req;
+    web_async_handler_t handler;
+} web_async_job_t;
+
+static QueueHandle_t job_queue = NULL;
+static atomic_uint jobs_queued;
+static atomic_uint jobs_rejected;
+static atomic_uint workers_busy;
+
+/**
+ * Worker task - runs queued handlers
+ */
+static void worker_task(void *pvParameters)
+{
+    web_async_job_t job;
+
+    for (;;) {
+        xQueueReceive(job_queue, &job, portMAX_DELAY);
+
+        atomic_fetch_add(&workers_busy, 1);
+        job.handler(job.req);
+        atomic_fetch_sub(&workers_busy, 1);
+
+        // Sends nothing further; releases the request and the session
+        httpd_req_async_handler_complete(job.req);
+    }
+}
+
+/**
+ * Start workers
+ */
+esp_err_t web_async_init(void)
+{
+    if (job_queue != NULL) {
+        return ESP_OK;
+    }
+
+    job_queue = xQueueCreate(WEB_ASYNC_QUEUE_LEN, sizeof(web_async_job_t));
+    if (job_queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int i = 0; i < WEB_ASYNC_WORKERS; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "web_async_%d", i);
+        if (xTaskCreate(worker_task, name, WEB_ASYNC_STACK_SIZE, NULL, WEB_ASYNC_PRIORITY, NULL) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create worker %d", i);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    ESP_LOGI(TAG, "%d workers, queue of %d", WEB_ASYNC_WORKERS, WEB_ASYNC_QUEUE_LEN);
+    return ESP_OK;
+}
+
+/**
+ * Answer 503 (runs on the server task)
+ * The connection is closed by returning ESP_FAIL, so an unread request body
+ * (an upload) is not drained on the server task.
+ */
+static esp_err_t reject(httpd_req_t *req)
+{
+    atomic_fetch_add(&jobs_rejected, 1);
+    ESP_LOGW(TAG, "Workers busy, rejecting %s", req->uri);
+
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Retry-After", "1");
+    httpd_resp_set_hdr(req, "Connection", "close");
+    httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"Busy, retry later\"}");
+    return ESP_FAIL;
+}
+
+/**
+ * Queue request for a worker
+ */
+esp_err_t web_async_dispatch(httpd_req_t *req, web_async_handler_t handler)
+{
+    // Cheap check first: a detached request cannot be answered from here
+    if (job_queue == NULL || uxQueueSpacesAvailable(job_queue) == 0) {
+        return reject(req);
+    }
+
+    web_async_job_t job = {.handler = handler};
+    if (httpd_req_async_handler_begin(req, &job.req) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+
+    // Only the server task queues jobs, so the space checked above is still there
+    xQueueSend(job_queue, &job, 0);
+    atomic_fetch_add(&jobs_queued, 1);
+    return ESP_OK;
+}
+
+/**
+ * Get statistics
+ */
+void web_async_get_stats(web_async_stats_t *stats)
+{
+    stats->queued = atomic_load(&jobs_queued);
+    stats->rejected = atomic_load(&jobs_rejected);
+    stats->busy = atomic_load(&workers_busy);
+}
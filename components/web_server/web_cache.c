@@ -0,0 +1,50 @@
+#include "web_cache.h"
+#include "esp_log.h"
+
+static const char *TAG = "WEB_CACHE";
+
+/**
+ * Get body
+ */
+const char* web_cache_get(web_cache_t *cache, size_t *len)
+{
+    // Read the version before building: a change during the build leaves
+    // the entry stale, so the next request builds again
+    uint32_t version = cache->version ? cache->version() : 0;
+
+    if (!cache->valid || version != cache->built_version) {
+        json_writer_t json;
+        json_writer_init(&json, cache->body, cache->capacity, NULL, NULL);
+        cache->write(&json);
+
+        cache->valid = json_writer_end(&json);
+        if (!cache->valid) {
+            ESP_LOGW(TAG, "Body larger than %u bytes", (unsigned)cache->capacity);
+            return NULL;
+        }
+        cache->len = json.len;
+        cache->built_version = version;
+        cache->rebuilds++;
+    } else {
+        cache->hits++;
+    }
+
+    *len = cache->len;
+    return cache->body;
+}
+
+/**
+ * Send body
+ */
+esp_err_t web_cache_send(httpd_req_t *req, web_cache_t *cache)
+{
+    size_t len;
+    const char *body = web_cache_get(cache, &len);
+    if (body == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Response failed");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, body, len);
+}
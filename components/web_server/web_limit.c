@@ -0,0 +1,402 @@
+#include "web_limit.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "metrics.h"
+#include "freertos/FreeRTOS.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "WEB_LIMIT";
+
+// Milli-tokens, so slow rates refill smoothly
+#define TOKEN                   1000
+
+typedef struct {
+    uint32_t burst;
+    uint32_t per_min;
+} limit_rate_t;
+
+static const limit_rate_t class_rates[WEB_LIMIT_CLASS_COUNT] = {
+    [WEB_LIMIT_STATIC] = {WEB_LIMIT_STATIC_BURST, WEB_LIMIT_STATIC_PER_MIN},
+    [WEB_LIMIT_API] = {WEB_LIMIT_API_BURST, WEB_LIMIT_API_PER_MIN},
+    [WEB_LIMIT_OTA] = {WEB_LIMIT_OTA_BURST, WEB_LIMIT_OTA_PER_MIN},
+};
+
+typedef struct {
+    uint32_t tokens;            // Milli-tokens
+    uint32_t refill_ms;         // Time of the last refill
+} limit_bucket_t;
+
+// Source address (IPv4 as IPv4-mapped IPv6) with its buckets
+typedef struct {
+    uint8_t addr[16];
+    bool used;
+    uint8_t connections;
+    uint32_t last_seen_ms;
+    limit_bucket_t buckets[WEB_LIMIT_CLASS_COUNT];
+} limit_client_t;
+
+// Server task only
+static limit_client_t clients[WEB_LIMIT_CLIENTS];
+static int8_t socket_clients[CONFIG_LWIP_MAX_SOCKETS];     // Client index + 1, 0 = untracked
+
+static atomic_int inflight;
+
+#if WEB_LIMIT_EXEMPT_ENABLE
+// Source address exempt from limits until exempt_until_us (0 = none), set
+// from a worker and read on the server task
+static portMUX_TYPE exempt_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t exempt_addr[16];
+static int64_t exempt_until_us;
+#endif
+
+// Exported metrics (/metrics)
+#define REJECTED_METRIC(labels) \
+    METRIC_COUNTER_INIT("http_rejected_total", "Requests and connections refused by admission control", labels)
+
+static metric_t rate_metrics[WEB_LIMIT_CLASS_COUNT] = {
+    [WEB_LIMIT_STATIC] = REJECTED_METRIC("reason=\"rate\",class=\"static\""),
+    [WEB_LIMIT_API] = REJECTED_METRIC("reason=\"rate\",class=\"api\""),
+    [WEB_LIMIT_OTA] = REJECTED_METRIC("reason=\"rate\",class=\"ota\""),
+};
+static metric_t connections_metric = REJECTED_METRIC("reason=\"connections\"");
+static metric_t inflight_metric = REJECTED_METRIC("reason=\"inflight\"");
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/**
+ * IPv4 address as IPv4-mapped IPv6
+ */
+static void map_ipv4(const void *addr4, uint8_t addr[16])
+{
+    memset(addr, 0, 10);
+    addr[10] = 0xff;
+    addr[11] = 0xff;
+    memcpy(addr + 12, addr4, 4);
+}
+
+#if WEB_LIMIT_EXEMPT_ENABLE
+/**
+ * Parse an IPv4 or IPv6 address (IPv4 mapped)
+ */
+static bool parse_address(const char *text, uint8_t addr[16])
+{
+    struct in_addr addr4;
+    if (inet_pton(AF_INET, text, &addr4) == 1) {
+        map_ipv4(&addr4.s_addr, addr);
+        return true;
+    }
+    return inet_pton(AF_INET6, text, addr) == 1;
+}
+
+/**
+ * Check if an address is exempt now
+ */
+static bool address_exempt(const uint8_t addr[16])
+{
+    int64_t now_us = esp_timer_get_time();
+    taskENTER_CRITICAL(&exempt_lock);
+    bool exempt = now_us < exempt_until_us && memcmp(addr, exempt_addr, 16) == 0;
+    taskEXIT_CRITICAL(&exempt_lock);
+    return exempt;
+}
+#endif
+
+/**
+ * Register metrics
+ */
+void web_limit_init(void)
+{
+    static bool registered = false;
+    if (registered) {
+        return;
+    }
+    for (int i = 0; i < WEB_LIMIT_CLASS_COUNT; i++) {
+        metrics_register(&rate_metrics[i]);
+    }
+    metrics_register(&connections_metric);
+    metrics_register(&inflight_metric);
+#if WEB_LIMIT_EXEMPT_ENABLE
+    ESP_LOGW(TAG, "Bench build: POST /api/debug/limit can exempt any address");
+#endif
+    registered = true;
+}
+
+#if WEB_LIMIT_EXEMPT_ENABLE
+/**
+ * Set exempt address
+ */
+esp_err_t web_limit_set_exempt(const char *addr, uint32_t ttl_s)
+{
+    uint8_t parsed[16];
+    bool set = (addr[0] != '\0');
+    if (set && !parse_address(addr, parsed)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (ttl_s > WEB_LIMIT_EXEMPT_MAX_TTL_S) {
+        ttl_s = WEB_LIMIT_EXEMPT_MAX_TTL_S;
+    }
+
+    int64_t until_us = set ? esp_timer_get_time() + (int64_t)ttl_s * 1000000 : 0;
+    taskENTER_CRITICAL(&exempt_lock);
+    if (set) {
+        memcpy(exempt_addr, parsed, sizeof(exempt_addr));
+    }
+    exempt_until_us = until_us;
+    taskEXIT_CRITICAL(&exempt_lock);
+
+    if (set) {
+        ESP_LOGW(TAG, "Limits disabled for %s for %lu s", addr, (unsigned long)ttl_s);
+    } else {
+        ESP_LOGI(TAG, "Limits enabled for all sources");
+    }
+    return ESP_OK;
+}
+
+/**
+ * Get exempt address
+ */
+void web_limit_get_exempt(char *buf, size_t size, uint32_t *ttl_s)
+{
+    static const uint8_t v4_mapped[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+    uint8_t addr[16];
+
+    taskENTER_CRITICAL(&exempt_lock);
+    memcpy(addr, exempt_addr, sizeof(addr));
+    int64_t left_us = exempt_until_us - esp_timer_get_time();
+    taskEXIT_CRITICAL(&exempt_lock);
+
+    buf[0] = '\0';
+    *ttl_s = 0;
+    if (left_us <= 0) {
+        return;
+    }
+    *ttl_s = (uint32_t)((left_us + 999999) / 1000000);
+    if (memcmp(addr, v4_mapped, sizeof(v4_mapped)) == 0) {
+        inet_ntop(AF_INET, addr + 12, buf, size);
+    } else {
+        inet_ntop(AF_INET6, addr, buf, size);
+    }
+}
+#endif
+
+static int8_t *socket_client(int sockfd)
+{
+    int index = sockfd - LWIP_SOCKET_OFFSET;
+    return (index >= 0 && index < CONFIG_LWIP_MAX_SOCKETS) ? &socket_clients[index] : NULL;
+}
+
+/**
+ * Peer address of a socket as IPv6 (IPv4 mapped)
+ */
+static bool peer_address(int sockfd, uint8_t addr[16])
+{
+    struct sockaddr_storage peer;
+    socklen_t len = sizeof(peer);
+    if (getpeername(sockfd, (struct sockaddr *)&peer, &len) != 0) {
+        return false;
+    }
+
+    if (peer.ss_family == AF_INET6) {
+        memcpy(addr, ((struct sockaddr_in6 *)&peer)->sin6_addr.s6_addr, 16);
+        return true;
+    }
+    if (peer.ss_family == AF_INET) {
+        map_ipv4(&((struct sockaddr_in *)&peer)->sin_addr.s_addr, addr);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Find the entry of an address, or take a free one or the least recently
+ * seen one without connections
+ */
+static limit_client_t *client_for(const uint8_t addr[16], uint32_t now)
+{
+    limit_client_t *victim = NULL;
+    for (int i = 0; i < WEB_LIMIT_CLIENTS; i++) {
+        limit_client_t *client = &clients[i];
+        if (client->used && memcmp(client->addr, addr, 16) == 0) {
+            return client;
+        }
+        if (client->connections == 0 &&
+            (victim == NULL || !client->used || (victim->used && client->last_seen_ms - victim->last_seen_ms > INT32_MAX))) {
+            victim = client;
+        }
+    }
+    if (victim == NULL) {
+        return NULL;
+    }
+
+    // A new client starts with full buckets
+    memcpy(victim->addr, addr, 16);
+    victim->used = true;
+    victim->connections = 0;
+    for (int c = 0; c < WEB_LIMIT_CLASS_COUNT; c++) {
+        victim->buckets[c].tokens = class_rates[c].burst * TOKEN;
+        victim->buckets[c].refill_ms = now;
+    }
+    return victim;
+}
+
+/**
+ * Session open
+ */
+bool web_limit_session_open(int sockfd)
+{
+    int8_t *slot = socket_client(sockfd);
+    if (slot == NULL) {
+        return true;
+    }
+    *slot = 0;
+    uint8_t addr[16];
+    if (!WEB_LIMIT_ENABLE || !peer_address(sockfd, addr)) {
+        return true;
+    }
+#if WEB_LIMIT_EXEMPT_ENABLE
+    if (address_exempt(addr)) {
+        // Untracked: no buckets, no connection limit
+        return true;
+    }
+#endif
+
+    uint32_t now = now_ms();
+    limit_client_t *client = client_for(addr, now);
+    if (client == NULL) {
+        // Every entry has connections: admit without limits rather than refuse
+        return true;
+    }
+    client->last_seen_ms = now;
+
+    if (client->connections >= WEB_LIMIT_CLIENT_CONNECTIONS) {
+        metrics_counter_inc(&connections_metric);
+        ESP_LOGW(TAG, "Connection limit reached, closing socket %d", sockfd);
+        return false;
+    }
+    client->connections++;
+    *slot = (int8_t)(client - clients) + 1;
+    return true;
+}
+
+/**
+ * Session close
+ */
+void web_limit_session_close(int sockfd)
+{
+    int8_t *slot = socket_client(sockfd);
+    if (slot && *slot > 0) {
+        clients[*slot - 1].connections--;
+        *slot = 0;
+    }
+}
+
+/**
+ * Answer without building anything: status, Retry-After, empty body
+ */
+static void send_rejection(httpd_req_t *req, const char *status, uint32_t retry_s, bool close)
+{
+    char retry[12];
+    snprintf(retry, sizeof(retry), "%lu", (unsigned long)retry_s);
+    httpd_resp_set_status(req, status);
+    httpd_resp_set_hdr(req, "Retry-After", retry);
+    if (close) {
+        httpd_resp_set_hdr(req, "Connection", "close");
+    }
+    httpd_resp_send(req, NULL, 0);
+}
+
+/**
+ * Take a token from the bucket of the request's client
+ * @return 0 if taken, otherwise seconds until one is available
+ */
+static uint32_t take_token(httpd_req_t *req, web_limit_class_t cls)
+{
+    int8_t *slot = socket_client(httpd_req_to_sockfd(req));
+    if (slot == NULL || *slot == 0) {
+        return 0;
+    }
+
+    limit_client_t *client = &clients[*slot - 1];
+    limit_bucket_t *bucket = &client->buckets[cls];
+    const limit_rate_t *rate = &class_rates[cls];
+    uint32_t now = now_ms();
+    client->last_seen_ms = now;
+
+    // per_min tokens per 60000 ms = per_min / 60 milli-tokens per ms
+    uint64_t tokens = bucket->tokens + (uint64_t)(now - bucket->refill_ms) * rate->per_min / 60;
+    bucket->tokens = tokens < rate->burst * TOKEN ? (uint32_t)tokens : rate->burst * TOKEN;
+    bucket->refill_ms = now;
+
+    if (bucket->tokens >= TOKEN) {
+        bucket->tokens -= TOKEN;
+        return 0;
+    }
+    uint32_t wait_ms = ((TOKEN - bucket->tokens) * 60 + rate->per_min - 1) / rate->per_min;
+    return (wait_ms + 999) / 1000;
+}
+
+/**
+ * Admit request
+ */
+bool web_limit_admit(httpd_req_t *req, web_limit_class_t cls, esp_err_t *ret)
+{
+    // An upload body left unread would be drained on the server task, so
+    // rejected uploads close their connection instead
+    bool close = (cls == WEB_LIMIT_OTA);
+    *ret = close ? ESP_FAIL : ESP_OK;
+
+    if (!WEB_LIMIT_ENABLE) {
+        atomic_fetch_add(&inflight, 1);
+        return true;
+    }
+
+    uint32_t retry_s = take_token(req, cls);
+    if (retry_s > 0) {
+        metrics_counter_inc(&rate_metrics[cls]);
+        send_rejection(req, "429 Too Many Requests", retry_s, close);
+        return false;
+    }
+
+    if (atomic_fetch_add(&inflight, 1) >= WEB_LIMIT_MAX_INFLIGHT) {
+        atomic_fetch_sub(&inflight, 1);
+        metrics_counter_inc(&inflight_metric);
+        send_rejection(req, "503 Service Unavailable", 1, close);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Release request
+ */
+void web_limit_release(void)
+{
+    atomic_fetch_sub(&inflight, 1);
+}
+
+/**
+ * Get statistics
+ */
+void web_limit_get_stats(web_limit_stats_t *stats)
+{
+    for (int i = 0; i < WEB_LIMIT_CLASS_COUNT; i++) {
+        stats->rate[i] = atomic_load(&rate_metrics[i].value);
+    }
+    stats->connections = atomic_load(&connections_metric.value);
+    stats->inflight = atomic_load(&inflight_metric.value);
+
+    // Read from another task: a count that is off by one is fine here
+    stats->clients = 0;
+    for (int i = 0; i < WEB_LIMIT_CLIENTS; i++) {
+        if (clients[i].used && clients[i].connections > 0) {
+            stats->clients++;
+        }
+    }
+}
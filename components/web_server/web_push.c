@@ -0,0 +1,210 @@
+#include "web_push.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdbool.h>
+#include <string.h>
+
+static const char *TAG = "WEB_PUSH";
+
+static httpd_handle_t push_server = NULL;
+static const web_push_topic_t *push_topics = NULL;
+static size_t push_topic_count = 0;
+static uint32_t push_versions[WEB_PUSH_MAX_TOPICS];
+static TaskHandle_t push_task_handle = NULL;
+static volatile bool push_running = false;
+static volatile uint32_t push_clients = 0;
+
+// Message buffer is static: messages are only built on the server task
+static char push_message[WEB_PUSH_MESSAGE_SIZE + 1];
+
+/**
+ * Build a message holding the topics in mask
+ * @return terminated JSON in push_message, NULL if it does not fit
+ */
+static const char* build_message(uint32_t mask)
+{
+    json_writer_t json;
+    json_writer_init(&json, push_message, WEB_PUSH_MESSAGE_SIZE, NULL, NULL);
+
+    json_writer_object_begin(&json, NULL);
+    for (size_t i = 0; i < push_topic_count; i++) {
+        if (mask & (1u << i)) {
+            json_writer_object_begin(&json, push_topics[i].name);
+            push_topics[i].write(&json);
+            json_writer_object_end(&json);
+        }
+    }
+    json_writer_object_end(&json);
+
+    if (!json_writer_end(&json)) {
+        ESP_LOGW(TAG, "Push message larger than %d bytes", WEB_PUSH_MESSAGE_SIZE);
+        return NULL;
+    }
+    push_message[json.len] = '\0';
+    return push_message;
+}
+
+/**
+ * Send a message to one client
+ */
+static esp_err_t send_message(int fd, const char *json)
+{
+    httpd_ws_frame_t frame = {
+        .final = true,
+        .type = HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t *)json,
+        .len = strlen(json),
+    };
+    return httpd_ws_send_frame_async(push_server, fd, &frame);
+}
+
+/**
+ * Broadcast changed topics (runs on the server task)
+ */
+static void broadcast_work(void *arg)
+{
+    uint32_t mask = (uint32_t)(uintptr_t)arg;
+    int fds[CONFIG_LWIP_MAX_SOCKETS];
+    size_t count = CONFIG_LWIP_MAX_SOCKETS;
+
+    if (push_server == NULL || httpd_get_client_list(push_server, &count, fds) != ESP_OK) {
+        return;
+    }
+
+    // Nothing is built while nobody is watching
+    uint32_t clients = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (httpd_ws_get_fd_info(push_server, fds[i]) == HTTPD_WS_CLIENT_WEBSOCKET) {
+            fds[clients++] = fds[i];
+        }
+    }
+    push_clients = clients;
+    if (clients == 0) {
+        return;
+    }
+
+    const char *json = build_message(mask);
+    if (json == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < clients; i++) {
+        if (send_message(fds[i], json) != ESP_OK) {
+            ESP_LOGW(TAG, "Push to client %d failed, closing", fds[i]);
+            httpd_sess_trigger_close(push_server, fds[i]);
+        }
+    }
+}
+
+/**
+ * Push task - polls topic versions
+ */
+static void push_task(void *pvParameters)
+{
+    while (push_running) {
+        vTaskDelay(pdMS_TO_TICKS(WEB_PUSH_POLL_MS));
+
+        uint32_t changed = 0;
+        for (size_t i = 0; i < push_topic_count; i++) {
+            uint32_t version = push_topics[i].version();
+            if (version != push_versions[i]) {
+                push_versions[i] = version;
+                changed |= (1u << i);
+            }
+        }
+
+        if (changed && push_running &&
+            httpd_queue_work(push_server, broadcast_work, (void *)(uintptr_t)changed) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to queue push");
+        }
+    }
+
+    push_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+/**
+ * Start watching topics
+ */
+esp_err_t web_push_start(httpd_handle_t server, const web_push_topic_t *topics, size_t count)
+{
+    if (push_task_handle != NULL) {
+        return ESP_OK;
+    }
+    if (count > WEB_PUSH_MAX_TOPICS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    push_server = server;
+    push_topics = topics;
+    push_topic_count = count;
+    for (size_t i = 0; i < count; i++) {
+        push_versions[i] = topics[i].version();
+    }
+
+    push_running = true;
+    if (xTaskCreate(push_task, "web_push", 3072, NULL, 4, &push_task_handle) != pdPASS) {
+        push_running = false;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Pushing %u topics on %s", (unsigned)count, WEB_PUSH_URI);
+    return ESP_OK;
+}
+
+/**
+ * Stop watching topics
+ */
+void web_push_stop(void)
+{
+    push_running = false;
+
+    // The task exits within one poll interval
+    while (push_task_handle != NULL) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    push_server = NULL;
+    push_clients = 0;
+}
+
+/**
+ * WebSocket handler
+ */
+esp_err_t web_push_ws_handler(httpd_req_t *req)
+{
+    // Called once with HTTP_GET after the handshake: send the whole state
+    if (req->method == HTTP_GET) {
+        int fd = httpd_req_to_sockfd(req);
+        const char *json = build_message((1u << push_topic_count) - 1);
+        if (json == NULL) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        esp_err_t err = send_message(fd, json);
+        push_clients++;
+        ESP_LOGI(TAG, "Client %d connected", fd);
+        return err;
+    }
+
+    // The page sends nothing; drain whatever arrives (control frames are handled by the server)
+    uint8_t buf[64];
+    httpd_ws_frame_t frame = {0};
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK || frame.len == 0) {
+        return err;
+    }
+    if (frame.len > sizeof(buf)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    frame.payload = buf;
+    return httpd_ws_recv_frame(req, &frame, sizeof(buf));
+}
+
+/**
+ * Get number of WebSocket clients
+ */
+uint32_t web_push_client_count(void)
+{
+    return push_clients;
+}
@@ -1,12 +1,30 @@
 #include "web_server.h"
+#include "sdkconfig.h"
 #include "esp_log.h"
 #include "esp_http_server.h"
 #include "cJSON.h"
 #include "wifi_manager.h"
 #include "ota_manager.h"
+#include "ota_pipeline.h"
 #include "sntp_sync.h"
 #include "led_indicator.h"
 #include "weather_client.h"
+#include "weather_log.h"
+#include "fixed_point.h"
+#include "json_writer.h"
+#include "web_assets.h"
+#include "web_push.h"
+#include "web_cache.h"
+#include "web_async.h"
+#include "web_limit.h"
+#include "heap_stats.h"
+#include "metrics.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "lwip/sockets.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "WEB_SERVER";
@@ -14,440 +32,133 @@ static const char *TAG = "WEB_SERVER";
 // HTTP server handle
 static httpd_handle_t server = NULL;
 
+// Records returned by /api/weather/history?tier=log when no limit is given
+#define WEATHER_LOG_DEFAULT_LIMIT 500
+
+// Connections, including open dashboards (must stay below CONFIG_LWIP_MAX_SOCKETS - 3,
+// with room for the weather client and SNTP)
+#define WEB_SERVER_MAX_SOCKETS    24
+
+// Delay between a response that triggers a restart and the restart itself
+#define RESTART_DELAY_MS          3000
+
+// JSON responses are written through a stack buffer of this size; longer
+// ones are sent in chunks
+#define JSON_RESPONSE_BUF_SIZE    768
+
+// Server task stack (default 4096), with room for the response buffer
+#define WEB_SERVER_STACK_SIZE     6144
+
 // ============================================================================
-// HTML PAGES
+// WEB PAGES
 // ============================================================================
 
+// Pages are served gzipped from flash (see www/ and tools/build_assets.py).
+// Their URLs are fixed, so browsers revalidate on every load and get a 304
+// without body while the ETag still matches.
+#define WEB_PAGE_CACHE_CONTROL "no-cache"
+
+// Gzipped page embedded by the component CMakeLists.txt
+typedef struct {
+    const uint8_t *start;
+    const uint8_t *end;
+    const char *type;
+    const char *etag;           // Quoted content hash
+} web_asset_t;
+
+extern const uint8_t index_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t index_html_gz_end[] asm("_binary_index_html_gz_end");
+extern const uint8_t ota_html_gz_start[] asm("_binary_ota_html_gz_start");
+extern const uint8_t ota_html_gz_end[] asm("_binary_ota_html_gz_end");
+
+static const web_asset_t provisioning_page = {
+    index_html_gz_start, index_html_gz_end, "text/html", WEB_ASSET_INDEX_HTML_ETAG
+};
+static const web_asset_t ota_page = {
+    ota_html_gz_start, ota_html_gz_end, "text/html", WEB_ASSET_OTA_HTML_ETAG
+};
+
 /**
- * HTML page for WiFi provisioning
- */
-static const char *provisioning_html = 
-"<!DOCTYPE html>"
-"<html>"
-"<head>"
-"<meta charset='UTF-8'>"
-"<meta name='viewport' content='width=device-width,initial-scale=1'>"
-"<title>ESP32-C6 Setup</title>"
-"<style>"
-"*{box-sizing:border-box;margin:0;padding:0}"
-"body{font-family:-apple-system,BlinkMacSystemFont,'Segoe UI',Roboto,Arial,sans-serif;background:linear-gradient(135deg,#667eea 0%,#764ba2 100%);min-height:100vh;display:flex;align-items:center;justify-content:center;padding:20px}"
-".container{background:#fff;border-radius:16px;box-shadow:0 10px 40px rgba(0,0,0,0.2);max-width:420px;width:100%;padding:32px;animation:slideUp 0.4s ease}"
-"@keyframes slideUp{from{opacity:0;transform:translateY(20px)}to{opacity:1;transform:translateY(0)}}"
-"h1{color:#2d3748;font-size:28px;font-weight:700;text-align:center;margin-bottom:8px}"
-".subtitle{color:#718096;text-align:center;font-size:14px;margin-bottom:24px}"
-
-// Button styles
-".btn{display:block;width:100%;padding:14px;border:none;border-radius:10px;font-size:15px;font-weight:600;cursor:pointer;transition:all 0.3s;text-decoration:none;text-align:center;margin-bottom:16px}"
-".btn-primary{background:#667eea;color:#fff}"
-".btn-primary:hover{background:#5568d3;transform:translateY(-2px);box-shadow:0 6px 20px rgba(102,126,234,0.4)}"
-".btn-success{background:#48bb78;color:#fff}"
-".btn-success:hover{background:#38a169;transform:translateY(-2px);box-shadow:0 6px 20px rgba(72,187,120,0.4)}"
-".btn-secondary{background:#4299e1;color:#fff;font-size:14px;padding:10px}"
-".btn-secondary:hover{background:#3182ce}"
-".btn:disabled{background:#cbd5e0;cursor:not-allowed;transform:none}"
-
-// Card styles
-".card{background:#f7fafc;border-left:4px solid #4299e1;border-radius:8px;padding:16px;margin-bottom:20px}"
-".card.success{background:#f0fff4;border-left-color:#48bb78}"
-".card.warning{background:#fffaf0;border-left-color:#ed8936}"
-".card-title{font-size:14px;font-weight:600;color:#2d3748;margin-bottom:12px}"
-
-// Time display
-".time-display{text-align:center;padding:4px 0}"
-".time-value{font-size:32px;font-weight:700;color:#4299e1;font-family:'Courier New',monospace;letter-spacing:2px}"
-".date-value{font-size:14px;color:#718096;margin-top:4px}"
-".sync-badge{display:inline-block;margin-top:8px;padding:4px 12px;border-radius:12px;font-size:11px;font-weight:600}"
-".sync-badge.synced{background:#c6f6d5;color:#22543d}"
-".sync-badge.waiting{background:#feebc8;color:#7c2d12}"
-
-// Info rows
-".info-row{display:flex;justify-content:space-between;align-items:center;padding:8px 0;border-bottom:1px solid #e2e8f0;font-size:13px}"
-".info-row:last-child{border-bottom:none}"
-".info-label{color:#718096;font-weight:500}"
-".info-value{color:#2d3748;font-family:'Courier New',monospace;font-weight:600;font-size:12px}"
-
-// Form styles
-".form-group{margin-bottom:20px}"
-".form-label{display:block;color:#4a5568;font-size:13px;font-weight:600;margin-bottom:8px}"
-".form-input{width:100%;padding:12px;border:2px solid #e2e8f0;border-radius:8px;font-size:14px;transition:all 0.3s}"
-".form-input:focus{outline:none;border-color:#667eea;box-shadow:0 0 0 3px rgba(102,126,234,0.1)}"
-
-// Status message
-".status-msg{margin-top:16px;padding:12px;border-radius:8px;text-align:center;font-size:14px;font-weight:500;display:none}"
-".status-msg.show{display:block;animation:slideDown 0.3s ease}"
-".status-msg.success{background:#c6f6d5;color:#22543d}"
-".status-msg.error{background:#fed7d7;color:#742a2a}"
-"@keyframes slideDown{from{opacity:0;transform:translateY(-10px)}to{opacity:1;transform:translateY(0)}}"
-
-// Divider
-".divider{height:1px;background:linear-gradient(to right,transparent,#e2e8f0,transparent);margin:24px 0}"
-
-// Weather display
-".weather-display{display:flex;justify-content:space-around;align-items:center;padding:16px 0}"
-".weather-item{text-align:center;flex:1}"
-".weather-icon{font-size:48px;margin-bottom:8px}"
-".weather-value{font-size:28px;font-weight:700;color:#2d3748}"
-".weather-unit{font-size:16px;color:#718096}"
-".weather-label{font-size:12px;color:#a0aec0;margin-top:4px;text-transform:uppercase;letter-spacing:1px}"
-".weather-update{text-align:center;font-size:11px;color:#a0aec0;margin-top:12px;padding-top:12px;border-top:1px solid #e2e8f0}"
-
-"</style>"
-"</head>"
-"<body>"
-"<div class='container'>"
-"<h1>ESP32-C6 Setup</h1>"
-"<p class='subtitle'>WiFi Configuration & Status</p>"
-
-// OTA Update Button
-"<a href='/ota' class='btn btn-primary'>🔄 OTA Firmware Update</a>"
-
-// Time Card
-"<div class='card'>"
-"<div class='card-title'>Current Time (WIB)</div>"
-"<div class='time-display'>"
-"<div class='time-value' id='timeDisplay'>--:--:--</div>"
-"<div class='date-value' id='dateDisplay'>--.--.----</div>"
-"<span class='sync-badge waiting' id='syncBadge'>⏳ Syncing...</span>"
-"</div>"
-"</div>"
-
-// Weather Card - TAMBAHKAN INI
-"<div class='card'>"
-"<div class='card-title'>Weather in Jakarta</div>"
-"<div id='weatherContent'>"
-"<div style='text-align:center;color:#a0aec0;padding:20px 0'>Loading...</div>"
-"</div>"
-"</div>"
-
-// Connection Status Card
-"<div class='card' id='statusCard'>"
-"<div class='card-title'>Connection Status</div>"
-"<div id='statusContent'>Loading...</div>"
-"</div>"
-
-"<div class='divider'></div>"
-
-// WiFi Form
-"<form id='wifiForm'>"
-"<div class='form-group'>"
-"<label class='form-label'>WiFi SSID</label>"
-"<input type='text' class='form-input' id='ssid' placeholder='Enter network name' required>"
-"</div>"
-"<div class='form-group'>"
-"<label class='form-label'>WiFi Password</label>"
-"<input type='password' class='form-input' id='password' placeholder='Enter password (optional)'>"
-"</div>"
-"<button type='submit' class='btn btn-success'>Connect to WiFi</button>"
-"</form>"
-
-"<button class='btn btn-secondary' onclick='refreshAll()'>🔄 Refresh Status</button>"
-
-"<div class='status-msg' id='statusMsg'></div>"
-
-"</div>"
-
-"<script>"
-// Update time
-"function updateTime(){"
-"fetch('/api/time').then(r=>r.json()).then(d=>{"
-"const td=document.getElementById('timeDisplay');"
-"const dd=document.getElementById('dateDisplay');"
-"const sb=document.getElementById('syncBadge');"
-"if(d.synced){"
-"const p=d.time.split(' ');"
-"if(p.length===2){td.textContent=p[1];dd.textContent=p[0];}"
-"sb.textContent='✓ Synchronized';"
-"sb.className='sync-badge synced';"
-"}else{"
-"td.textContent='--:--:--';"
-"dd.textContent='Not synced';"
-"sb.textContent='⏳ Syncing...';"
-"sb.className='sync-badge waiting';"
-"}}).catch(e=>console.error(e));}"
-
-// Update weather
-"function updateWeather(){"
-"fetch('/api/weather').then(r=>r.json()).then(d=>{"
-"const content=document.getElementById('weatherContent');"
-"if(d.valid){"
-"content.innerHTML="
-"'<div class=\"weather-display\">'"
-"+'<div class=\"weather-item\">'"
-"+'<div class=\"weather-icon\">🌡️</div>'"
-"+'<div><span class=\"weather-value\">'+d.temperature.toFixed(1)+'</span><span class=\"weather-unit\">°C</span></div>'"
-"+'<div class=\"weather-label\">Temperature</div>'"
-"+'</div>'"
-"+'<div class=\"weather-item\">'"
-"+'<div class=\"weather-icon\">💧</div>'"
-"+'<div><span class=\"weather-value\">'+d.humidity+'</span><span class=\"weather-unit\">%</span></div>'"
-"+'<div class=\"weather-label\">Humidity</div>'"
-"+'</div>'"
-"+'</div>'"
-"+'<div class=\"weather-update\">Last update: '+d.last_update_str+'</div>';"
-"}else{"
-"content.innerHTML='<div style=\"text-align:center;color:#e53e3e;padding:20px 0\">⚠️ Weather data unavailable</div>';"
-"}}).catch(e=>console.error(e));}"
-
-// Update status
-"function updateStatus(){"
-"fetch('/api/status').then(r=>r.json()).then(d=>{"
-"const card=document.getElementById('statusCard');"
-"const content=document.getElementById('statusContent');"
-"if(d.connected){"
-"card.className='card success';"
-"content.innerHTML="
-"'<div class=\"info-row\"><span class=\"info-label\">SSID</span><span class=\"info-value\">'+d.ssid+'</span></div>'"
-"+'<div class=\"info-row\"><span class=\"info-label\">IP Address</span><span class=\"info-value\">'+d.ip+'</span></div>'"
-"+'<div class=\"info-row\"><span class=\"info-label\">Gateway</span><span class=\"info-value\">'+d.gateway+'</span></div>'"
-"+'<div class=\"info-row\"><span class=\"info-label\">AP IP</span><span class=\"info-value\">'+d.ap_ip+'</span></div>';"
-"}else{"
-"card.className='card warning';"
-"content.innerHTML="
-"'<div class=\"info-row\"><span class=\"info-label\">Mode</span><span class=\"info-value\">AP Only</span></div>'"
-"+'<div class=\"info-row\"><span class=\"info-label\">AP IP</span><span class=\"info-value\">'+d.ap_ip+'</span></div>'"
-"+'<div style=\"margin-top:12px;color:#744210;font-size:12px;text-align:center\">Configure WiFi below to connect</div>';"
-"}}).catch(e=>console.error(e));}"
-
-// Refresh all
-"function refreshAll(){updateTime();updateStatus();updateWeather();}"
-
-// Auto update
-"setInterval(updateTime,1000);"
-"setInterval(updateWeather,60000);" // Update every 60 seconds
-"refreshAll();"
-
-// Form submit
-"document.getElementById('wifiForm').addEventListener('submit',function(e){"
-"e.preventDefault();"
-"const msg=document.getElementById('statusMsg');"
-"const btn=e.target.querySelector('button');"
-"const ssid=document.getElementById('ssid').value;"
-"const pwd=document.getElementById('password').value;"
-"msg.className='status-msg';"
-"msg.textContent='Connecting to '+ssid+'...';"
-"msg.classList.add('show');"
-"btn.disabled=true;"
-"fetch('/api/wifi/save',{"
-"method:'POST',"
-"headers:{'Content-Type':'application/json'},"
-"body:JSON.stringify({ssid:ssid,password:pwd})"
-"})"
-".then(r=>r.json())"
-".then(d=>{"
-"if(d.success){"
-"msg.className='status-msg success show';"
-"msg.textContent='✓ WiFi saved! Device restarting in 3 seconds...';"
-"setTimeout(()=>location.reload(),3000);"
-"}else{"
-"msg.className='status-msg error show';"
-"msg.textContent='✗ Failed: '+(d.message||'Unknown error');"
-"btn.disabled=false;"
-"}"
-"})"
-".catch(e=>{"
-"msg.className='status-msg error show';"
-"msg.textContent='✗ Connection error: '+e;"
-"btn.disabled=false;"
-"});"
-"});"
-"</script>"
-"</body>"
-"</html>";
-
-/**
- * HTML page for OTA update
- */
-static const char *ota_html = 
-"<!DOCTYPE html>"
-"<html>"
-"<head>"
-"<meta charset='UTF-8'>"
-"<meta name='viewport' content='width=device-width,initial-scale=1'>"
-"<title>ESP32-C6 OTA Update</title>"
-"<style>"
-"*{box-sizing:border-box;margin:0;padding:0}"
-"body{font-family:-apple-system,BlinkMacSystemFont,'Segoe UI',Roboto,Arial,sans-serif;background:linear-gradient(135deg,#667eea 0%,#764ba2 100%);min-height:100vh;display:flex;align-items:center;justify-content:center;padding:20px}"
-".container{background:#fff;border-radius:16px;box-shadow:0 10px 40px rgba(0,0,0,0.2);max-width:520px;width:100%;padding:32px;animation:slideUp 0.4s ease}"
-"@keyframes slideUp{from{opacity:0;transform:translateY(20px)}to{opacity:1;transform:translateY(0)}}"
-"h1{color:#2d3748;font-size:28px;font-weight:700;text-align:center;margin-bottom:8px}"
-".subtitle{color:#718096;text-align:center;font-size:14px;margin-bottom:24px}"
-
-// Button
-".btn{display:block;width:100%;padding:14px;border:none;border-radius:10px;font-size:15px;font-weight:600;cursor:pointer;transition:all 0.3s;text-decoration:none;text-align:center;margin-bottom:20px}"
-".btn-back{background:#4299e1;color:#fff}"
-".btn-back:hover{background:#3182ce;transform:translateY(-2px)}"
-".btn-upload{background:#48bb78;color:#fff}"
-".btn-upload:hover{background:#38a169;transform:translateY(-2px)}"
-".btn:disabled{background:#cbd5e0;cursor:not-allowed;transform:none}"
-
-// Info box
-".info-box{background:#edf2f7;border-radius:10px;padding:20px;margin-bottom:24px}"
-".info-row{display:flex;justify-content:space-between;padding:10px 0;border-bottom:1px solid #cbd5e0;font-size:14px}"
-".info-row:last-child{border-bottom:none}"
-".info-label{color:#4a5568;font-weight:500}"
-".info-value{color:#2d3748;font-family:'Courier New',monospace;font-weight:700}"
-
-// Upload area
-".upload-area{border:3px dashed #cbd5e0;border-radius:12px;padding:48px 24px;text-align:center;cursor:pointer;transition:all 0.3s;margin:24px 0;background:#f7fafc}"
-".upload-area:hover{border-color:#667eea;background:#edf2f7}"
-".upload-area.drag-over{border-color:#48bb78;background:#f0fff4}"
-".upload-icon{font-size:56px;margin-bottom:16px}"
-".upload-text{color:#718096;font-size:15px;margin-bottom:8px}"
-".upload-hint{color:#a0aec0;font-size:13px}"
-".file-name{margin-top:16px;padding:12px;background:#fff;border-radius:8px;color:#2d3748;font-weight:600;font-size:14px}"
-".file-input{display:none}"
-
-// Progress
-".progress-container{margin-top:24px;display:none}"
-".progress-bar{width:100%;height:36px;background:#edf2f7;border-radius:18px;overflow:hidden;position:relative;margin-bottom:16px}"
-".progress-fill{height:100%;background:linear-gradient(90deg,#48bb78,#38a169);transition:width 0.3s;position:relative}"
-".progress-text{position:absolute;top:0;left:0;width:100%;height:100%;display:flex;align-items:center;justify-content:center;font-weight:700;color:#2d3748;font-size:15px}"
-".progress-msg{padding:14px;border-radius:8px;text-align:center;font-weight:600;font-size:14px}"
-".progress-msg.success{background:#c6f6d5;color:#22543d}"
-".progress-msg.error{background:#fed7d7;color:#742a2a}"
-".progress-msg.info{background:#bee3f8;color:#2c5282}"
-
-// Warning
-".warning-box{background:#fffaf0;border-left:4px solid #ed8936;border-radius:8px;padding:16px;margin-top:24px}"
-".warning-title{color:#7c2d12;font-weight:700;font-size:14px;margin-bottom:8px}"
-".warning-text{color:#744210;font-size:13px;margin:4px 0}"
-
-"</style>"
-"</head>"
-"<body>"
-"<div class='container'>"
-"<h1>🔄 OTA Firmware Update</h1>"
-"<p class='subtitle'>Upload new firmware (.bin file)</p>"
-
-"<a href='/' class='btn btn-back'>← Back to WiFi Setup</a>"
-
-// Info box
-"<div class='info-box'>"
-"<div class='info-row'><span class='info-label'>Current Version</span><span class='info-value' id='version'>...</span></div>"
-"<div class='info-row'><span class='info-label'>Running Partition</span><span class='info-value' id='partition'>...</span></div>"
-"<div class='info-row'><span class='info-label'>Free Space</span><span class='info-value' id='freeSpace'>...</span></div>"
-"</div>"
-
-// Upload area
-"<div class='upload-area' id='uploadArea' onclick='document.getElementById(\"fileInput\").click()'>"
-"<div class='upload-icon'>📁</div>"
-"<div class='upload-text'>Click to select firmware file</div>"
-"<div class='upload-hint'>or drag and drop .bin file here</div>"
-"<div class='file-name' id='fileName' style='display:none'></div>"
-"</div>"
-
-"<input type='file' id='fileInput' class='file-input' accept='.bin'>"
-"<button class='btn btn-upload' id='uploadBtn' onclick='uploadFirmware()' disabled>Upload Firmware</button>"
-
-// Progress
-"<div class='progress-container' id='progressContainer'>"
-"<div class='progress-bar'>"
-"<div class='progress-fill' id='progressFill' style='width:0%'></div>"
-"<div class='progress-text' id='progressText'>0%</div>"
-"</div>"
-"<div class='progress-msg info' id='progressMsg'>Uploading...</div>"
-"</div>"
-
-// Warning
-"<div class='warning-box'>"
-"<div class='warning-title'>⚠️ Important Notes</div>"
-"<div class='warning-text'>• Do not power off or disconnect during update</div>"
-"<div class='warning-text'>• Device will restart automatically after update</div>"
-"<div class='warning-text'>• Current configuration will be preserved</div>"
-"</div>"
-
-"</div>"
-
-"<script>"
-"let selectedFile=null;"
-
-// Load info
-"function loadInfo(){"
-"fetch('/api/ota/info').then(r=>r.json()).then(d=>{"
-"document.getElementById('version').textContent=d.version||'Unknown';"
-"document.getElementById('partition').textContent=d.partition||'Unknown';"
-"const freeMB=d.free_space?((d.free_space/1024/1024).toFixed(2)+' MB'):'Unknown';"  // FIX HERE
-"document.getElementById('freeSpace').textContent=freeMB;"
-"}).catch(e=>{console.error(e);document.getElementById('freeSpace').textContent='Error';});}"
-"loadInfo();"
-
-// Drag & drop
-"const area=document.getElementById('uploadArea');"
-"const fileInput=document.getElementById('fileInput');"
-"area.addEventListener('dragover',e=>{e.preventDefault();area.classList.add('drag-over');});"
-"area.addEventListener('dragleave',()=>area.classList.remove('drag-over'));"
-"area.addEventListener('drop',e=>{"
-"e.preventDefault();"
-"area.classList.remove('drag-over');"
-"if(e.dataTransfer.files.length>0)handleFile(e.dataTransfer.files[0]);"
-"});"
-"fileInput.addEventListener('change',e=>{if(e.target.files.length>0)handleFile(e.target.files[0]);});"
-
-// Handle file
-"function handleFile(file){"
-"if(!file.name.endsWith('.bin')){alert('Please select a .bin file');return;}"
-"selectedFile=file;"
-"const fn=document.getElementById('fileName');"
-"fn.textContent='📄 '+file.name+' ('+(file.size/1024/1024).toFixed(2)+' MB)';"
-"fn.style.display='block';"
-"document.getElementById('uploadBtn').disabled=false;"
-"}"
-
-// Upload
-"function uploadFirmware(){"
-"if(!selectedFile)return;"
-"const formData=new FormData();"
-"formData.append('file',selectedFile);"
-"const btn=document.getElementById('uploadBtn');"
-"const pc=document.getElementById('progressContainer');"
-"const pf=document.getElementById('progressFill');"
-"const pt=document.getElementById('progressText');"
-"const pm=document.getElementById('progressMsg');"
-"btn.disabled=true;"
-"pc.style.display='block';"
-"const xhr=new XMLHttpRequest();"
-"xhr.upload.addEventListener('progress',e=>{"
-"if(e.lengthComputable){"
-"const pct=Math.round((e.loaded/e.total)*100);"
-"pf.style.width=pct+'%';"
-"pt.textContent=pct+'%';"
-"}"
-"});"
-"xhr.addEventListener('load',()=>{"
-"if(xhr.status===200){"
-"try{"
-"const resp=JSON.parse(xhr.responseText);"
-"if(resp.success){"
-"pm.className='progress-msg success';"
-"pm.textContent='✓ Update successful! Device restarting in 3 seconds...';"
-"setTimeout(()=>location.reload(),3000);"
-"}else{"
-"pm.className='progress-msg error';"
-"pm.textContent='✗ Update failed: '+(resp.message||'Unknown error');"
-"btn.disabled=false;"
-"}"
-"}catch(e){"
-"pm.className='progress-msg error';"
-"pm.textContent='✗ Invalid response from device';"
-"btn.disabled=false;"
-"}"
-"}else{"
-"pm.className='progress-msg error';"
-"pm.textContent='✗ Upload error: HTTP '+xhr.status;"
-"btn.disabled=false;"
-"}"
-"});"
-"xhr.addEventListener('error',()=>{"
-"pm.className='progress-msg error';"
-"pm.textContent='✗ Network error occurred';"
-"btn.disabled=false;"
-"});"
-"xhr.open('POST','/api/ota/update',true);"
-"xhr.send(formData);"
-"}"
-"</script>"
-"</body>"
-"</html>";
+ * Check if an If-None-Match header lists the asset's ETag (or is "*")
+ */
+static bool asset_not_modified(httpd_req_t *req, const web_asset_t *asset)
+{
+    char value[128];
+    
+    size_t len = httpd_req_get_hdr_value_len(req, "If-None-Match");
+    if (len == 0 || len >= sizeof(value) ||
+        httpd_req_get_hdr_value_str(req, "If-None-Match", value, sizeof(value)) != ESP_OK) {
+        return false;
+    }
+    
+    // Weak comparison: W/"tag" matches "tag"
+    return strcmp(value, "*") == 0 || strstr(value, asset->etag) != NULL;
+}
+
+/**
+ * Send a gzipped asset, or 304 Not Modified if the client has it cached
+ */
+static esp_err_t send_asset(httpd_req_t *req, const web_asset_t *asset)
+{
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    httpd_resp_set_hdr(req, "Cache-Control", WEB_PAGE_CACHE_CONTROL);
+    
+    if (asset_not_modified(req, asset)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+    
+    // Every browser accepts gzip, so there is no uncompressed copy
+    httpd_resp_set_type(req, asset->type);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    return httpd_resp_send(req, (const char *)asset->start, asset->end - asset->start);
+}
+
+// ============================================================================
+// JSON RESPONSES
+// ============================================================================
+
+/**
+ * Send a full writer buffer as one chunk
+ */
+static bool json_response_flush(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len) == ESP_OK;
+}
+
+/**
+ * Start a JSON response written through buf (no heap allocation)
+ */
+static void json_response_begin(httpd_req_t *req, json_writer_t *json, char *buf, size_t size)
+{
+    httpd_resp_set_type(req, "application/json");
+    json_writer_init(json, buf, size, json_response_flush, req);
+}
+
+/**
+ * Finish a JSON response
+ * A document that fit in the buffer goes out in one send with Content-Length,
+ * a longer one ends with its last chunk.
+ */
+static esp_err_t json_response_end(httpd_req_t *req, json_writer_t *json)
+{
+    if (!json_writer_end(json)) {
+        ESP_LOGW(TAG, "JSON response to %s failed", req->uri);
+        if (json->flushed == 0) {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Response failed");
+        }
+        return ESP_FAIL;
+    }
+    
+    if (json->flushed == 0) {
+        return httpd_resp_send(req, json->buf, json->len);
+    }
+    if (!json_writer_flush(json)) {
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
 
 // ============================================================================
 // HTTP HANDLERS
@@ -458,8 +169,7 @@ static const char *ota_html =
  */
 static esp_err_t root_handler(httpd_req_t *req)
 {
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, provisioning_html, strlen(provisioning_html));
+    send_asset(req, &provisioning_page);
     return ESP_OK;
 }
 
@@ -468,23 +178,20 @@ static esp_err_t root_handler(httpd_req_t *req)
  */
 static esp_err_t ota_page_handler(httpd_req_t *req)
 {
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, ota_html, strlen(ota_html));
+    send_asset(req, &ota_page);
     return ESP_OK;
 }
 
 /**
- * WiFi status API
+ * Write WiFi status members
  */
-static esp_err_t api_status_handler(httpd_req_t *req)
+static void write_status_json(json_writer_t *json)
 {
-    cJSON *root = cJSON_CreateObject();
-    
     wifi_state_t state = wifi_manager_get_state();
     bool is_connected = (state == WIFI_STATE_STA_CONNECTED);
     
-    cJSON_AddBoolToObject(root, "connected", is_connected);
-    cJSON_AddStringToObject(root, "ap_ip", WIFI_AP_IP);
+    json_writer_bool(json, "connected", is_connected);
+    json_writer_string(json, "ap_ip", WIFI_AP_IP);
     
     if (is_connected) {
         esp_netif_t *netif_sta = wifi_manager_get_sta_netif();
@@ -497,78 +204,173 @@ static esp_err_t api_status_handler(httpd_req_t *req)
             snprintf(subnet_str, sizeof(subnet_str), IPSTR, IP2STR(&ip_info.netmask));
             snprintf(gw_str, sizeof(gw_str), IPSTR, IP2STR(&ip_info.gw));
             
-            cJSON_AddStringToObject(root, "ip", ip_str);
-            cJSON_AddStringToObject(root, "subnet", subnet_str);
-            cJSON_AddStringToObject(root, "gateway", gw_str);
+            json_writer_string(json, "ip", ip_str);
+            json_writer_string(json, "subnet", subnet_str);
+            json_writer_string(json, "gateway", gw_str);
             
             wifi_credentials_t creds;
             if (wifi_manager_load_credentials(&creds) == ESP_OK) {
-                cJSON_AddStringToObject(root, "ssid", creds.ssid);
+                json_writer_string(json, "ssid", creds.ssid);
             }
         }
     }
-    
-    char *json_str = cJSON_Print(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-    
-    free(json_str);
-    cJSON_Delete(root);
-    return ESP_OK;
 }
 
 /**
- * Time API
+ * Write WiFi status document
  */
-static esp_err_t api_time_handler(httpd_req_t *req)
+static void write_status_document(json_writer_t *json)
+{
+    json_writer_object_begin(json, NULL);
+    write_status_json(json);
+    json_writer_object_end(json);
+}
+
+// Rebuilt on WiFi state changes only, so NVS is not read per request
+static char status_body[320];
+static web_cache_t status_cache = WEB_CACHE_INIT(wifi_manager_get_state_version, write_status_document, status_body);
+
+/**
+ * WiFi status API
+ */
+static esp_err_t api_status_handler(httpd_req_t *req)
 {
-    cJSON *root = cJSON_CreateObject();
+    return web_cache_send(req, &status_cache);
+}
+
+/**
+ * Offset of local time from UTC in seconds
+ */
+static int32_t utc_offset_s(time_t now)
+{
+    struct tm local, utc;
+    localtime_r(&now, &local);
+    gmtime_r(&now, &utc);
     
+    int32_t days = local.tm_yday - utc.tm_yday;
+    if (days > 1) {
+        days = -1;      // Local time is still in the previous year
+    } else if (days < -1) {
+        days = 1;       // Local time is already in the next year
+    }
+    return ((days * 24 + local.tm_hour - utc.tm_hour) * 60 + local.tm_min - utc.tm_min) * 60;
+}
+
+/**
+ * Write time info members
+ */
+static void write_time_json(json_writer_t *json)
+{
     struct tm timeinfo;
     bool time_valid = sntp_sync_get_time(&timeinfo);
     
-    cJSON_AddBoolToObject(root, "synced", sntp_sync_is_synced());
+    json_writer_bool(json, "synced", sntp_sync_is_synced());
     
     if (time_valid) {
         char time_str[100];
         strftime(time_str, sizeof(time_str), "%d.%m.%Y %H:%M:%S", &timeinfo);
-        cJSON_AddStringToObject(root, "time", time_str);
-        cJSON_AddNumberToObject(root, "year", timeinfo.tm_year + 1900);
-        cJSON_AddNumberToObject(root, "month", timeinfo.tm_mon + 1);
-        cJSON_AddNumberToObject(root, "day", timeinfo.tm_mday);
-        cJSON_AddNumberToObject(root, "hour", timeinfo.tm_hour);
-        cJSON_AddNumberToObject(root, "minute", timeinfo.tm_min);
-        cJSON_AddNumberToObject(root, "second", timeinfo.tm_sec);
-        cJSON_AddNumberToObject(root, "epoch", (double)sntp_sync_get_epoch());
+        json_writer_string(json, "time", time_str);
+        json_writer_int(json, "year", timeinfo.tm_year + 1900);
+        json_writer_int(json, "month", timeinfo.tm_mon + 1);
+        json_writer_int(json, "day", timeinfo.tm_mday);
+        json_writer_int(json, "hour", timeinfo.tm_hour);
+        json_writer_int(json, "minute", timeinfo.tm_min);
+        json_writer_int(json, "second", timeinfo.tm_sec);
+        json_writer_int(json, "epoch", sntp_sync_get_epoch());
+        json_writer_int(json, "utc_offset", utc_offset_s(sntp_sync_get_epoch()));
     } else {
-        cJSON_AddStringToObject(root, "time", "Not synchronized");
+        json_writer_string(json, "time", "Not synchronized");
     }
+}
+
+/**
+ * Time API
+ */
+static esp_err_t api_time_handler(httpd_req_t *req)
+{
+    char buf[JSON_RESPONSE_BUF_SIZE];
+    json_writer_t json;
+    json_response_begin(req, &json, buf, sizeof(buf));
     
-    char *json_str = cJSON_Print(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
+    json_writer_object_begin(&json, NULL);
+    write_time_json(&json);
+    json_writer_object_end(&json);
     
-    free(json_str);
-    cJSON_Delete(root);
-    return ESP_OK;
+    return json_response_end(req, &json);
 }
 
 /**
- * Weather API handler
+ * Resolve optional ?station=<index|name> (defaults to the primary station)
+ * @return station index, or -1 if unknown
  */
-static esp_err_t api_weather_handler(httpd_req_t *req)
+static int get_station_param(const char *query)
 {
-    cJSON *root = cJSON_CreateObject();
+    char param[32];
+    if (httpd_query_key_value(query, "station", param, sizeof(param)) != ESP_OK) {
+        return 0;
+    }
+    
+    char *end;
+    long index = strtol(param, &end, 10);
+    int station = (*end == '\0') ? (int)index : weather_client_find_station(param);
     
+    if (station < 0 || station >= (int)weather_client_get_station_count()) {
+        return -1;
+    }
+    return station;
+}
+
+/**
+ * Write temperature (0.01 °C) and humidity (0.1 %) statistics
+ */
+static void write_temp_hum_stats(json_writer_t *json, int16_t temp_min, int16_t temp_max, int16_t temp_mean,
+                                 uint16_t hum_min, uint16_t hum_max, uint16_t hum_mean)
+{
+    json_writer_fixed(json, "temp_min", temp_min, FIXED_TEMP_DECIMALS);
+    json_writer_fixed(json, "temp_max", temp_max, FIXED_TEMP_DECIMALS);
+    json_writer_fixed(json, "temp_mean", temp_mean, FIXED_TEMP_DECIMALS);
+    json_writer_fixed(json, "hum_min", hum_min, FIXED_HUM_DECIMALS);
+    json_writer_fixed(json, "hum_max", hum_max, FIXED_HUM_DECIMALS);
+    json_writer_fixed(json, "hum_mean", hum_mean, FIXED_HUM_DECIMALS);
+}
+
+/**
+ * Write rolling window statistics
+ */
+static void write_window_stats(json_writer_t *json, const char *name, const weather_window_stats_t *stats)
+{
+    json_writer_object_begin(json, name);
+    json_writer_int(json, "samples", stats->count);
+    if (stats->count > 0) {
+        write_temp_hum_stats(json, stats->temp_min, stats->temp_max, stats->temp_mean,
+                             stats->hum_min, stats->hum_max, stats->hum_mean);
+    }
+    json_writer_object_end(json);
+}
+
+/**
+ * Write weather data members of a station
+ */
+static void write_weather_json(json_writer_t *json, int station)
+{
     weather_data_t weather;
-    bool has_data = weather_client_get_data(&weather);
+    bool has_data = weather_client_get_station_data(station, &weather);
     
-    cJSON_AddBoolToObject(root, "valid", has_data);
+    json_writer_string(json, "station", weather_client_get_station_name(station));
+    json_writer_int(json, "station_index", station);
+    json_writer_int(json, "station_count", weather_client_get_station_count());
+    json_writer_bool(json, "valid", has_data);
     
     if (has_data) {
-        cJSON_AddNumberToObject(root, "temperature", weather.temperature);
-        cJSON_AddNumberToObject(root, "humidity", weather.humidity);
-        cJSON_AddNumberToObject(root, "last_update", (double)weather.last_update);
+        json_writer_fixed(json, "temperature", weather.temperature, FIXED_TEMP_DECIMALS);
+        json_writer_fixed(json, "humidity", weather.humidity, FIXED_HUM_DECIMALS);
+        json_writer_bool(json, "interpolated", weather.is_interpolated);
+        json_writer_fixed(json, "dew_point", weather.dew_point, FIXED_TEMP_DECIMALS);
+        json_writer_fixed(json, "heat_index", weather.heat_index, FIXED_TEMP_DECIMALS);
+        json_writer_fixed(json, "apparent_temperature", weather.apparent_temperature, FIXED_TEMP_DECIMALS);
+        write_window_stats(json, "last_1h", &weather.window_1h);
+        write_window_stats(json, "last_24h", &weather.window_24h);
+        json_writer_int(json, "last_update", weather.last_update);
         
         // Format last update time
         if (weather.last_update > 0) {
@@ -576,23 +378,488 @@ static esp_err_t api_weather_handler(httpd_req_t *req)
             localtime_r(&weather.last_update, &timeinfo);
             char time_str[64];
             strftime(time_str, sizeof(time_str), "%d.%m.%Y %H:%M:%S", &timeinfo);
-            cJSON_AddStringToObject(root, "last_update_str", time_str);
+            json_writer_string(json, "last_update_str", time_str);
         }
     } else {
-        cJSON_AddStringToObject(root, "message", "No weather data available");
+        json_writer_string(json, "message", "No weather data available");
+    }
+}
+
+// Interpolated values follow the clock; they are republished this often
+#define WEATHER_INTERPOLATED_REFRESH_S  60
+
+/**
+ * Version of the primary station's weather as written by write_weather_json
+ * While values are interpolated from the forecast they change without a new
+ * fetch, so the version then also advances every WEATHER_INTERPOLATED_REFRESH_S.
+ */
+static uint32_t primary_weather_version(void)
+{
+    uint32_t version = weather_client_get_version();
+    weather_data_t weather;
+    
+    if (weather_client_get_data(&weather) && weather.is_interpolated) {
+        version += (uint32_t)(sntp_sync_get_epoch() / WEATHER_INTERPOLATED_REFRESH_S);
+    }
+    return version;
+}
+
+/**
+ * Weather API handler
+ */
+static esp_err_t api_weather_handler(httpd_req_t *req)
+{
+    char query[128];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) {
+        query[0] = '\0';
+    }
+    
+    int station = get_station_param(query);
+    if (station < 0) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Unknown station");
+        return ESP_FAIL;
+    }
+    
+    char buf[JSON_RESPONSE_BUF_SIZE];
+    json_writer_t json;
+    json_response_begin(req, &json, buf, sizeof(buf));
+    
+    json_writer_object_begin(&json, NULL);
+    write_weather_json(&json, station);
+    
+    // Connection reuse / TLS resumption counters
+    weather_fetch_stats_t stats;
+    if (weather_client_get_fetch_stats(&stats)) {
+        json_writer_object_begin(&json, "fetch");
+        json_writer_int(&json, "count", stats.fetch_count);
+        json_writer_int(&json, "failures", stats.failure_count);
+        json_writer_int(&json, "reused", stats.reused_count);
+        json_writer_int(&json, "resumed", stats.resumed_count);
+        json_writer_int(&json, "full_handshake", stats.full_handshake_count);
+        json_writer_string(&json, "last_connection", weather_client_conn_type_str(stats.last_conn_type));
+        json_writer_int(&json, "last_duration_ms", stats.last_fetch_ms);
+        json_writer_int(&json, "consecutive_failures", stats.consecutive_failures);
+        json_writer_int(&json, "next_fetch_in_s", stats.next_fetch_in_s);
+        json_writer_int(&json, "triggers", stats.triggers);
+        json_writer_int(&json, "collapsed_triggers", stats.collapsed_triggers);
+        json_writer_string(&json, "format", WEATHER_API_FORMAT_NAME);
+        json_writer_int(&json, "last_body_bytes", stats.last_body_bytes);
+        json_writer_int(&json, "last_decode_us", stats.last_decode_us);
+        json_writer_string(&json, "last_endpoint", stats.last_endpoint ? "secondary" : "primary");
+        json_writer_int(&json, "timeout_ms", stats.timeout_ms);
+        json_writer_int(&json, "hedge_delay_ms", stats.hedge_delay_ms);
+        json_writer_int(&json, "hedged", stats.hedged_count);
+        json_writer_int(&json, "failovers", stats.failover_count);
+        json_writer_int(&json, "secondary_wins", stats.secondary_wins);
+        
+        // Full handshake cost per trust mode
+        json_writer_object_begin(&json, "tls");
+        json_writer_string(&json, "trust", weather_client_tls_trust_str(stats.tls_trust));
+        json_writer_int(&json, "fallbacks", stats.tls_fallbacks);
+        for (int i = 0; i < WEATHER_TLS_TRUST_COUNT; i++) {
+            json_writer_object_begin(&json, weather_client_tls_trust_str((weather_tls_trust_t)i));
+            json_writer_int(&json, "handshakes", stats.tls[i].handshakes);
+            json_writer_int(&json, "avg_handshake_ms", stats.tls[i].avg_handshake_ms);
+            json_writer_int(&json, "max_handshake_ms", stats.tls[i].max_handshake_ms);
+            json_writer_int(&json, "peak_heap_bytes", stats.tls[i].peak_heap_bytes);
+            json_writer_object_end(&json);
+        }
+        json_writer_object_end(&json);
+        json_writer_object_end(&json);
+    }
+    json_writer_object_end(&json);
+    
+    return json_response_end(req, &json);
+}
+
+/**
+ * Dashboard state version (the sum changes whenever one of the parts does)
+ */
+static uint32_t dashboard_version(void)
+{
+    return primary_weather_version() + sntp_sync_get_version() + wifi_manager_get_state_version();
+}
+
+/**
+ * Write dashboard document, without the current time
+ */
+static void write_dashboard_document(json_writer_t *json)
+{
+    json_writer_object_begin(json, NULL);
+    
+    json_writer_object_begin(json, "status");
+    write_status_json(json);
+    json_writer_object_end(json);
+    
+    json_writer_object_begin(json, "weather");
+    write_weather_json(json, 0);
+    json_writer_object_end(json);
+    
+    json_writer_object_begin(json, "time");
+    json_writer_bool(json, "synced", sntp_sync_is_synced());
+    json_writer_int(json, "utc_offset", utc_offset_s(sntp_sync_get_epoch()));
+    json_writer_object_end(json);
+    
+    json_writer_object_end(json);
+}
+
+// Dashboard body, rebuilt when weather, time sync or WiFi state changes, and
+// every minute while the weather is interpolated
+static char dashboard_body[1280];
+static web_cache_t dashboard_cache = WEB_CACHE_INIT(dashboard_version, write_dashboard_document, dashboard_body);
+
+/**
+ * Dashboard API - status, primary station weather and time in one response
+ * The cached body is sent with the current epoch appended as last member.
+ */
+static esp_err_t api_dashboard_handler(httpd_req_t *req)
+{
+    // Response buffer is static: all handlers run on the single httpd task
+    static char response[sizeof(dashboard_body) + 32];
+    
+    size_t len;
+    const char *body = web_cache_get(&dashboard_cache, &len);
+    if (body == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Response failed");
+        return ESP_FAIL;
     }
     
-    char *json_str = cJSON_Print(root);
+    // Replace the closing brace of the body
+    memcpy(response, body, len - 1);
+    len += snprintf(response + len - 1, sizeof(response) - (len - 1), ",\"epoch\":%lld}",
+                    (long long)sntp_sync_get_epoch()) - 1;
+    
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
+    return httpd_resp_send(req, response, len);
+}
+
+// Streaming state for the flash log tier
+typedef struct {
+    json_writer_t json;
+    uint8_t station;
+    uint32_t limit;
+    uint32_t sent;
+    char buf[512];
+} log_stream_t;
+
+/**
+ * Emit one log record
+ */
+static bool log_stream_record(const weather_log_record_t *record, void *ctx)
+{
+    log_stream_t *stream = (log_stream_t *)ctx;
+    
+    if (record->station != stream->station) {
+        return true;
+    }
+    
+    int16_t temperature;
+    uint16_t humidity;
+    weather_log_record_values(record, &temperature, &humidity);
+    
+    json_writer_object_begin(&stream->json, NULL);
+    json_writer_int(&stream->json, "t", record->timestamp);
+    json_writer_fixed(&stream->json, "temp", temperature, FIXED_TEMP_DECIMALS);
+    json_writer_fixed(&stream->json, "hum", humidity, FIXED_HUM_DECIMALS);
+    json_writer_object_end(&stream->json);
+    stream->sent++;
+    return !stream->json.error && stream->sent < stream->limit;
+}
+
+/**
+ * Stream raw samples from the flash log (records are read in place, never copied to RAM)
+ */
+static esp_err_t send_weather_log(httpd_req_t *req, int station, uint32_t from, uint32_t to, uint32_t limit)
+{
+    // Stream state is static: all handlers run on the single httpd task
+    static log_stream_t stream;
+    
+    if (!weather_log_is_ready()) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Weather log not available");
+        return ESP_FAIL;
+    }
+    
+    stream.station = (uint8_t)station;
+    stream.limit = limit;
+    stream.sent = 0;
+    
+    json_writer_t *json = &stream.json;
+    json_response_begin(req, json, stream.buf, sizeof(stream.buf));
+    json_writer_object_begin(json, NULL);
+    json_writer_string(json, "station", weather_client_get_station_name(station));
+    json_writer_string(json, "tier", "log");
+    json_writer_array_begin(json, "points");
+    if (limit > 0) {
+        weather_log_iterate(from, to, log_stream_record, &stream);
+    }
+    json_writer_array_end(json);
+    
+    weather_log_stats_t stats;
+    weather_log_get_stats(&stats);
+    json_writer_object_begin(json, "log");
+    json_writer_int(json, "records", stats.record_count);
+    json_writer_int(json, "capacity", stats.capacity);
+    json_writer_int(json, "sectors", stats.sector_count);
+    json_writer_int(json, "erase_cycles", stats.erase_cycles);
+    json_writer_int(json, "pending", stats.pending);
+    json_writer_int(json, "avg_append_us", stats.avg_append_us);
+    json_writer_int(json, "query_us", stats.last_query_us);
+    json_writer_int(json, "query_records", stats.last_query_records);
+    json_writer_object_end(json);
+    json_writer_object_end(json);
+    
+    return json_response_end(req, json);
+}
+
+/**
+ * Weather history API
+ * ?station=<index|name>&tier=raw|hourly|daily|log&from=<epoch>&to=<epoch>[&limit=<n>]
+ */
+static esp_err_t api_weather_history_handler(httpd_req_t *req)
+{
+    // Result buffer is static: all handlers run on the single httpd task
+    static weather_history_agg_t points[WEATHER_HISTORY_MAX_POINTS];
+    
+    char query[128];
+    char param[16];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) {
+        query[0] = '\0';
+    }
+    
+    int station = get_station_param(query);
+    if (station < 0) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Unknown station");
+        return ESP_FAIL;
+    }
+    
+    uint32_t from = 0;
+    uint32_t to = UINT32_MAX;
+    if (httpd_query_key_value(query, "from", param, sizeof(param)) == ESP_OK) {
+        from = strtoul(param, NULL, 10);
+    }
+    if (httpd_query_key_value(query, "to", param, sizeof(param)) == ESP_OK) {
+        to = strtoul(param, NULL, 10);
+    }
+    
+    weather_history_tier_t tier = WEATHER_HISTORY_HOURLY;
+    if (httpd_query_key_value(query, "tier", param, sizeof(param)) == ESP_OK) {
+        if (strcmp(param, "log") == 0) {
+            uint32_t limit = WEATHER_LOG_DEFAULT_LIMIT;
+            if (httpd_query_key_value(query, "limit", param, sizeof(param)) == ESP_OK) {
+                limit = strtoul(param, NULL, 10);
+            }
+            return send_weather_log(req, station, from, to, limit);
+        }
+        if (!weather_history_tier_from_str(param, &tier)) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid tier");
+            return ESP_FAIL;
+        }
+    }
+    
+    size_t count = weather_client_get_history(station, tier, from, to,
+                                              points, sizeof(points) / sizeof(points[0]));
+    
+    char buf[JSON_RESPONSE_BUF_SIZE];
+    json_writer_t json;
+    json_response_begin(req, &json, buf, sizeof(buf));
+    
+    json_writer_object_begin(&json, NULL);
+    json_writer_string(&json, "station", weather_client_get_station_name(station));
+    json_writer_string(&json, "tier", weather_history_tier_str(tier));
+    
+    json_writer_array_begin(&json, "points");
+    for (size_t i = 0; i < count; i++) {
+        json_writer_object_begin(&json, NULL);
+        json_writer_int(&json, "t", points[i].start);
+        json_writer_int(&json, "n", points[i].count);
+        write_temp_hum_stats(&json, points[i].temp_min, points[i].temp_max, points[i].temp_mean,
+                             points[i].hum_min, points[i].hum_max, points[i].hum_mean);
+        json_writer_object_end(&json);
+    }
+    json_writer_array_end(&json);
+    json_writer_object_end(&json);
+    
+    return json_response_end(req, &json);
+}
+
+/**
+ * Weather fetch trace API
+ * Rolling p50/p95/p99 per phase over the last WEATHER_TRACE_LEN fetches, and
+ * the traces themselves (newest first). Times are in microseconds; phases a
+ * request did not reach (e.g. DNS on a kept-alive connection) are null.
+ */
+static esp_err_t api_weather_trace_handler(httpd_req_t *req)
+{
+    // Trace copy is static: all handlers run on the single httpd task
+    static weather_trace_t trace;
+    weather_client_get_trace(&trace);
+    
+    char buf[JSON_RESPONSE_BUF_SIZE];
+    json_writer_t json;
+    json_response_begin(req, &json, buf, sizeof(buf));
+    
+    json_writer_object_begin(&json, NULL);
+    json_writer_int(&json, "count", trace.count);
+    json_writer_int(&json, "total", trace.total);
+    
+    json_writer_object_begin(&json, "phases");
+    for (int phase = 0; phase < WEATHER_PHASE_COUNT; phase++) {
+        uint32_t samples;
+        json_writer_object_begin(&json, weather_trace_phase_name(phase));
+        json_writer_int(&json, "p50", weather_trace_percentile(&trace, phase, 50, &samples));
+        json_writer_int(&json, "p95", weather_trace_percentile(&trace, phase, 95, NULL));
+        json_writer_int(&json, "p99", weather_trace_percentile(&trace, phase, 99, NULL));
+        json_writer_int(&json, "samples", samples);
+        json_writer_object_end(&json);
+    }
+    json_writer_object_end(&json);
     
-    free(json_str);
+    json_writer_array_begin(&json, "recent");
+    const weather_trace_entry_t *entry;
+    for (uint32_t i = 0; (entry = weather_trace_get(&trace, i)) != NULL; i++) {
+        json_writer_object_begin(&json, NULL);
+        json_writer_int(&json, "time", entry->time);
+        json_writer_string(&json, "endpoint", entry->endpoint ? "secondary" : "primary");
+        json_writer_string(&json, "connection", weather_client_conn_type_str((weather_conn_type_t)entry->conn_type));
+        json_writer_bool(&json, "success", entry->success);
+        for (int phase = 0; phase < WEATHER_PHASE_COUNT; phase++) {
+            if (entry->measured & (1u << phase)) {
+                json_writer_int(&json, weather_trace_phase_name(phase), entry->phase_us[phase]);
+            } else {
+                json_writer_null(&json, weather_trace_phase_name(phase));
+            }
+        }
+        json_writer_object_end(&json);
+    }
+    json_writer_array_end(&json);
+    json_writer_object_end(&json);
+    
+    return json_response_end(req, &json);
+}
+
+/**
+ * Heap debug API - allocation counters for load tests (tools/http_bench.py)
+ */
+static esp_err_t api_debug_heap_handler(httpd_req_t *req)
+{
+    heap_stats_t heap;
+    heap_stats_get(&heap);
+    
+    char buf[JSON_RESPONSE_BUF_SIZE];
+    json_writer_t json;
+    json_response_begin(req, &json, buf, sizeof(buf));
+    
+    json_writer_object_begin(&json, NULL);
+    json_writer_int(&json, "allocs", heap.allocs);
+    json_writer_int(&json, "frees", heap.frees);
+    json_writer_int(&json, "alloc_bytes", heap.alloc_bytes);
+    json_writer_int(&json, "free_bytes", heap.free_bytes);
+    json_writer_int(&json, "min_free_bytes", heap.min_free_bytes);
+    json_writer_int(&json, "largest_free_block", heap.largest_free_block);
+    json_writer_int(&json, "uptime_ms", esp_timer_get_time() / 1000);
+    json_writer_object_end(&json);
+    
+    return json_response_end(req, &json);
+}
+
+#if WEB_LIMIT_EXEMPT_ENABLE
+/**
+ * Limit debug API (bench builds, runs on a worker) - exempt one source
+ * address from the rate and connection limits for a while, e.g. the PC
+ * running tools/http_bench.py: {"exempt": "192.168.1.10", "ttl_s": 300},
+ * "" to limit every source again
+ */
+static esp_err_t api_debug_limit_handler(httpd_req_t *req)
+{
+    char buf[96];
+    int ret = httpd_req_recv(req, buf, MIN(req->content_len, sizeof(buf) - 1));
+    
+    if (ret <= 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No data");
+        return ESP_FAIL;
+    }
+    buf[ret] = '\0';
+    
+    cJSON *root = cJSON_Parse(buf);
+    cJSON *exempt_json = cJSON_GetObjectItem(root, "exempt");
+    if (!cJSON_IsString(exempt_json)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "exempt address required");
+        return ESP_FAIL;
+    }
+    
+    cJSON *ttl_json = cJSON_GetObjectItem(root, "ttl_s");
+    uint32_t ttl_s = WEB_LIMIT_EXEMPT_TTL_S;
+    if (cJSON_IsNumber(ttl_json) && ttl_json->valuedouble > 0) {
+        ttl_s = (ttl_json->valuedouble < WEB_LIMIT_EXEMPT_MAX_TTL_S) ? (uint32_t)ttl_json->valuedouble
+                                                                     : WEB_LIMIT_EXEMPT_MAX_TTL_S;
+    }
+    
+    esp_err_t err = web_limit_set_exempt(exempt_json->valuestring, ttl_s);
     cJSON_Delete(root);
-    return ESP_OK;
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid address");
+        return ESP_FAIL;
+    }
+    
+    char exempt[WEB_LIMIT_ADDR_STR_LEN];
+    web_limit_get_exempt(exempt, sizeof(exempt), &ttl_s);
+    
+    char response[JSON_RESPONSE_BUF_SIZE];
+    json_writer_t json;
+    json_response_begin(req, &json, response, sizeof(response));
+    json_writer_object_begin(&json, NULL);
+    json_writer_string(&json, "exempt", exempt);
+    json_writer_int(&json, "ttl_s", ttl_s);
+    json_writer_object_end(&json);
+    
+    return json_response_end(req, &json);
+}
+#endif
+
+/**
+ * Metrics in Prometheus text exposition format, streamed in chunks
+ */
+static esp_err_t metrics_handler(httpd_req_t *req)
+{
+    char buf[JSON_RESPONSE_BUF_SIZE];
+    httpd_resp_set_type(req, "text/plain; version=0.0.4; charset=utf-8");
+    
+    if (!metrics_render(buf, sizeof(buf), json_response_flush, req)) {
+        ESP_LOGW(TAG, "Metrics response failed");
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * Restart timer callback
+ */
+static void restart_timer_cb(void *arg)
+{
+    esp_restart();
+}
+
+/**
+ * Restart after RESTART_DELAY_MS without blocking the calling task
+ * (the response just sent still reaches the browser)
+ */
+static void schedule_restart(void)
+{
+    static esp_timer_handle_t restart_timer = NULL;
+    
+    if (restart_timer == NULL) {
+        esp_timer_create_args_t args = {.callback = restart_timer_cb, .name = "restart"};
+        if (esp_timer_create(&args, &restart_timer) != ESP_OK) {
+            vTaskDelay(pdMS_TO_TICKS(RESTART_DELAY_MS));
+            esp_restart();
+        }
+    }
+    esp_timer_start_once(restart_timer, RESTART_DELAY_MS * 1000ULL);
 }
 
 /**
- * WiFi save API
+ * WiFi save API (runs on a worker: the NVS commit can block)
  */
 static esp_err_t api_wifi_save_handler(httpd_req_t *req)
 {
@@ -630,11 +897,7 @@ static esp_err_t api_wifi_save_handler(httpd_req_t *req)
     if (err == ESP_OK) {
         const char *resp = "{\"success\":true}";
         httpd_resp_send(req, resp, strlen(resp));
-        
-        cJSON_Delete(root);
-        
-        vTaskDelay(pdMS_TO_TICKS(3000));
-        esp_restart();
+        schedule_restart();
     } else {
         const char *resp = "{\"success\":false,\"message\":\"Save failed\"}";
         httpd_resp_send(req, resp, strlen(resp));
@@ -645,89 +908,443 @@ static esp_err_t api_wifi_save_handler(httpd_req_t *req)
 }
 
 /**
- * OTA info API
+ * Write firmware info document
  */
-static esp_err_t api_ota_info_handler(httpd_req_t *req)
+static void write_ota_info_document(json_writer_t *json)
 {
-    cJSON *root = cJSON_CreateObject();
-    
-    cJSON_AddStringToObject(root, "version", ota_manager_get_version());
-    cJSON_AddStringToObject(root, "partition", ota_manager_get_partition());
+    json_writer_object_begin(json, NULL);
+    json_writer_string(json, "version", ota_manager_get_version());
+    json_writer_string(json, "partition", ota_manager_get_partition());
     
     const esp_partition_t *update_part = ota_manager_get_update_partition();
     if (update_part) {
-        cJSON_AddNumberToObject(root, "free_space", update_part->size);
+        json_writer_int(json, "free_space", update_part->size);
     }
-    
-    char *json_str = cJSON_Print(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-    
-    free(json_str);
-    cJSON_Delete(root);
-    return ESP_OK;
+    json_writer_object_end(json);
 }
 
+// Firmware info does not change while running: built once at server start
+static char ota_info_body[192];
+static web_cache_t ota_info_cache = WEB_CACHE_INIT(NULL, write_ota_info_document, ota_info_body);
+
 /**
- * OTA update API
+ * OTA info API
+ */
+static esp_err_t api_ota_info_handler(httpd_req_t *req)
+{
+    return web_cache_send(req, &ota_info_cache);
+}
+
+/**
+ * OTA update API (runs on a worker for the whole upload)
+ * The body is received into pipeline buffers while a writer task flashes the
+ * previous ones (see ota_pipeline.h).
  */
 static esp_err_t api_ota_update_handler(httpd_req_t *req)
 {
-    char buf[512];
     int remaining = req->content_len;
-    int received = 0;
-    bool first_chunk = true;
     
     ESP_LOGI(TAG, "Starting OTA, size: %d bytes", remaining);
     
+    if (ota_pipeline_start(req->content_len) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA begin failed");
+        return ESP_FAIL;
+    }
+    
     while (remaining > 0) {
-        int recv_len = httpd_req_recv(req, buf, MIN(remaining, sizeof(buf)));
-        
-        if (recv_len == HTTPD_SOCK_ERR_TIMEOUT) {
-            continue;
-        } else if (recv_len <= 0) {
-            ESP_LOGE(TAG, "Receive failed");
-            ota_manager_abort();
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Upload failed");
+        // Blocks while every buffer waits for the flash (backpressure)
+        uint8_t *buf = ota_pipeline_acquire();
+        if (buf == NULL) {
+            ota_pipeline_abort();
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Write failed");
             return ESP_FAIL;
         }
         
-        if (first_chunk) {
-            if (ota_manager_begin(req->content_len) != ESP_OK) {
-                httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA begin failed");
+        size_t filled = 0;
+        while (filled < OTA_PIPELINE_BUF_SIZE && remaining > 0) {
+            int recv_len = httpd_req_recv(req, (char *)buf + filled, MIN(remaining, OTA_PIPELINE_BUF_SIZE - filled));
+            
+            if (recv_len == HTTPD_SOCK_ERR_TIMEOUT) {
+                continue;
+            } else if (recv_len <= 0) {
+                ESP_LOGE(TAG, "Receive failed");
+                ota_pipeline_abort();
+                httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Upload failed");
                 return ESP_FAIL;
             }
-            first_chunk = false;
+            
+            filled += recv_len;
+            remaining -= recv_len;
         }
         
-        if (ota_manager_write(buf, recv_len) != ESP_OK) {
-            ota_manager_abort();
+        if (ota_pipeline_submit(buf, filled) != ESP_OK) {
+            ota_pipeline_abort();
             httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Write failed");
             return ESP_FAIL;
         }
-        
-        received += recv_len;
-        remaining -= recv_len;
     }
     
-    if (ota_manager_end() != ESP_OK) {
+    if (ota_pipeline_finish() != ESP_OK) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA end failed");
         return ESP_FAIL;
     }
     
     ESP_LOGI(TAG, "OTA successful! Rebooting...");
     
-    const char *resp = "{\"success\":true}";
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, resp, strlen(resp));
+    // Stage throughput, to compare OTA windows between builds
+    ota_pipeline_stats_t stats;
+    ota_pipeline_get_stats(&stats);
+    
+    char buf[JSON_RESPONSE_BUF_SIZE];
+    json_writer_t json;
+    json_response_begin(req, &json, buf, sizeof(buf));
+    json_writer_object_begin(&json, NULL);
+    json_writer_bool(&json, "success", true);
+    json_writer_object_begin(&json, "stats");
+    json_writer_int(&json, "bytes", stats.bytes);
+    json_writer_int(&json, "elapsed_ms", stats.elapsed_ms);
+    json_writer_int(&json, "kbps", ota_pipeline_kbps(stats.bytes, stats.elapsed_ms));
+    json_writer_int(&json, "receive_ms", stats.receive_ms);
+    json_writer_int(&json, "receive_kbps", ota_pipeline_kbps(stats.bytes, stats.receive_ms));
+    json_writer_int(&json, "write_ms", stats.write_ms);
+    json_writer_int(&json, "write_kbps", ota_pipeline_kbps(stats.bytes, stats.write_ms));
+    json_writer_int(&json, "sequential_ms", stats.receive_ms + stats.write_ms);
+    json_writer_int(&json, "receive_stall_ms", stats.receive_stall_ms);
+    json_writer_int(&json, "write_idle_ms", stats.write_idle_ms);
+    json_writer_int(&json, "max_queued", stats.max_queued);
+    json_writer_object_end(&json);
+    json_writer_object_end(&json);
+    json_response_end(req, &json);
     
     led_set_system_status(LED_SYSTEM_CONNECTED);
-    vTaskDelay(pdMS_TO_TICKS(3000));
-    esp_restart();
+    schedule_restart();
+    return ESP_OK;
+}
+
+// ============================================================================
+// PUSH TOPICS
+// ============================================================================
+
+/**
+ * Weather of the primary station, pushed to the dashboard
+ */
+static void write_primary_weather_json(json_writer_t *json)
+{
+    write_weather_json(json, 0);
+}
+
+// State pushed to open dashboards over WEB_PUSH_URI when it changes
+static const web_push_topic_t push_topics[] = {
+    {"weather", primary_weather_version, write_primary_weather_json},
+    {"time", sntp_sync_get_version, write_time_json},
+    {"status", wifi_manager_get_state_version, write_status_json},
+};
+
+// ============================================================================
+// ROUTES
+// ============================================================================
+
+// Handler latency buckets (us), exported as seconds
+#define ROUTE_LATENCY_BUCKETS   10
+static const uint32_t route_latency_bounds_us[ROUTE_LATENCY_BUCKETS] = {
+    250, 500, 1000, 2500, 5000, 10000, 25000, 100000, 1000000, 10000000,
+};
+
+// Response status classes: nothing sent by the handler, 1xx .. 5xx
+#define ROUTE_STATUS_CLASSES    6
+
+// Registered endpoint with its instrumentation. Requests and latency are
+// exported (/metrics), the rest is reported by /api/debug/http.
+typedef struct {
+    httpd_uri_t uri;            // Handler and user_ctx of the endpoint
+    bool async;                 // Handler runs on a web_async worker
+    web_limit_class_t limit;    // Admission class (web_limit.h)
+    metric_t requests;          // http_requests_total{uri}
+    metric_t latency;           // http_request_duration_seconds{uri}
+    atomic_uint latency_buckets[ROUTE_LATENCY_BUCKETS + 1];
+    atomic_uint max_us;
+    atomic_uint responses[ROUTE_STATUS_CLASSES];
+    atomic_uint response_bytes; // Status line, headers and body
+    atomic_int heap_delta;      // Sum of free heap drops across the handler
+} web_route_t;
+
+// path must be a string literal; optional httpd_uri_t fields follow the handler
+#define WEB_ROUTE_INIT(path, method_, handler_, async_, limit_, ...) \
+    { .uri = {.uri = path, .method = (method_), .handler = (handler_), __VA_ARGS__}, \
+      .async = (async_), \
+      .limit = (limit_), \
+      .requests = METRIC_COUNTER_INIT("http_requests_total", \
+                                      "HTTP requests by URI (WebSocket: handshakes and frames)", \
+                                      "uri=\"" path "\""), \
+      .latency = METRIC_HISTOGRAM_INIT("http_request_duration_seconds", "Handler time by URI", \
+                                       "uri=\"" path "\"", route_latency_bounds_us, NULL, 6) }
+
+#define WEB_PAGE_ROUTE(path, handler_)                  WEB_ROUTE_INIT(path, HTTP_GET, handler_, false, WEB_LIMIT_STATIC)
+#define WEB_ROUTE(path, method_, handler_, ...)         WEB_ROUTE_INIT(path, method_, handler_, false, WEB_LIMIT_API, __VA_ARGS__)
+#define WEB_ASYNC_ROUTE(path, method_, handler_, limit_) WEB_ROUTE_INIT(path, method_, handler_, true, limit_)
+
+static esp_err_t api_debug_http_handler(httpd_req_t *req);
+
+static web_route_t routes[] = {
+    // Pages
+    WEB_PAGE_ROUTE("/", root_handler),
+    WEB_PAGE_ROUTE("/ota", ota_page_handler),
+    
+    // APIs
+    WEB_ROUTE("/api/status", HTTP_GET, api_status_handler),
+    WEB_ROUTE("/api/time", HTTP_GET, api_time_handler),
+    WEB_ASYNC_ROUTE("/api/wifi/save", HTTP_POST, api_wifi_save_handler, WEB_LIMIT_OTA),
+    WEB_ROUTE("/api/ota/info", HTTP_GET, api_ota_info_handler),
+    WEB_ASYNC_ROUTE("/api/ota/update", HTTP_POST, api_ota_update_handler, WEB_LIMIT_OTA),
+    WEB_ROUTE("/api/weather", HTTP_GET, api_weather_handler),
+    WEB_ROUTE("/api/weather/history", HTTP_GET, api_weather_history_handler),
+    WEB_ROUTE("/api/weather/trace", HTTP_GET, api_weather_trace_handler),
+    WEB_ROUTE("/api/dashboard", HTTP_GET, api_dashboard_handler),
+    WEB_ROUTE("/api/debug/heap", HTTP_GET, api_debug_heap_handler),
+    WEB_ROUTE("/api/debug/http", HTTP_GET, api_debug_http_handler),
+#if WEB_LIMIT_EXEMPT_ENABLE
+    WEB_ASYNC_ROUTE("/api/debug/limit", HTTP_POST, api_debug_limit_handler, WEB_LIMIT_OTA),
+#endif
+    WEB_ROUTE("/metrics", HTTP_GET, metrics_handler),
     
+    // Dashboard push channel
+    WEB_ROUTE(WEB_PUSH_URI, HTTP_GET, web_push_ws_handler, .is_websocket = true),
+};
+
+#define ROUTE_COUNT (sizeof(routes) / sizeof(routes[0]))
+
+// Request being served on a socket. A socket serves one request at a time,
+// on the server task or on one worker, so its entry has a single writer.
+typedef struct {
+    web_route_t *route;         // NULL outside a handler (e.g. push frames)
+    uint32_t bytes;
+    uint16_t status;
+} route_request_t;
+
+static route_request_t socket_requests[CONFIG_LWIP_MAX_SOCKETS];
+
+static route_request_t *socket_request(int sockfd)
+{
+    int index = sockfd - LWIP_SOCKET_OFFSET;
+    return (index >= 0 && index < CONFIG_LWIP_MAX_SOCKETS) ? &socket_requests[index] : NULL;
+}
+
+/**
+ * Socket send for every session: sends like the server's default and counts
+ * the bytes and the status of the request being served
+ */
+static int route_send(httpd_handle_t hd, int sockfd, const char *buf, size_t buf_len, int flags)
+{
+    if (buf == NULL) {
+        return HTTPD_SOCK_ERR_INVALID;
+    }
+    int ret = send(sockfd, buf, buf_len, flags);
+    if (ret < 0) {
+        return (errno == EAGAIN || errno == EINTR) ? HTTPD_SOCK_ERR_TIMEOUT : HTTPD_SOCK_ERR_FAIL;
+    }
+    
+    route_request_t *request = socket_request(sockfd);
+    if (request && request->route) {
+        // The first send of a response starts with its status line
+        if (request->bytes == 0 && ret >= 12 && memcmp(buf, "HTTP/1.1 ", 9) == 0) {
+            request->status = (buf[9] - '0') * 100 + (buf[10] - '0') * 10 + (buf[11] - '0');
+        }
+        request->bytes += ret;
+    }
+    return ret;
+}
+
+/**
+ * New session: apply the per-client connection limit, then route its sends
+ * through route_send (a failed override is only logged)
+ */
+static esp_err_t route_session_open(httpd_handle_t hd, int sockfd)
+{
+    if (!web_limit_session_open(sockfd)) {
+        return ESP_FAIL;
+    }
+    if (httpd_sess_set_send_override(hd, sockfd, route_send) != ESP_OK) {
+        ESP_LOGW(TAG, "Socket %d not instrumented", sockfd);
+    }
     return ESP_OK;
 }
 
+/**
+ * Session closed (the server leaves closing the socket to close_fn)
+ */
+static void route_session_close(httpd_handle_t hd, int sockfd)
+{
+    web_limit_session_close(sockfd);
+    close(sockfd);
+}
+
+/**
+ * Run the endpoint handler and record latency, status, bytes and heap delta
+ * (server task or worker)
+ */
+static esp_err_t route_run(httpd_req_t *req)
+{
+    web_route_t *route = (web_route_t *)req->user_ctx;
+    route_request_t *request = socket_request(httpd_req_to_sockfd(req));
+    if (request) {
+        *request = (route_request_t){.route = route};
+    }
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    int64_t start_us = esp_timer_get_time();
+    
+    req->user_ctx = route->uri.user_ctx;
+    esp_err_t ret = route->uri.handler(req);
+    
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+    int32_t heap_delta = (int32_t)(free_before - heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
+    
+    metrics_observe(&route->latency, elapsed_us);
+    unsigned max_us = atomic_load_explicit(&route->max_us, memory_order_relaxed);
+    while (elapsed_us > max_us &&
+           !atomic_compare_exchange_weak_explicit(&route->max_us, &max_us, elapsed_us,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+    atomic_fetch_add_explicit(&route->heap_delta, heap_delta, memory_order_relaxed);
+    
+    if (request) {
+        int status_class = request->status / 100;
+        if (status_class >= ROUTE_STATUS_CLASSES) {
+            status_class = 0;
+        }
+        atomic_fetch_add_explicit(&route->responses[status_class], 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&route->response_bytes, request->bytes, memory_order_relaxed);
+        request->route = NULL;
+    }
+    return ret;
+}
+
+/**
+ * Run an admitted request on a worker, then release its admission
+ */
+static esp_err_t route_run_async(httpd_req_t *req)
+{
+    esp_err_t ret = route_run(req);
+    web_limit_release();
+    return ret;
+}
+
+/**
+ * Handler registered for every route: count, admit, then run the endpoint
+ * handler here or on a worker
+ */
+static esp_err_t route_handler(httpd_req_t *req)
+{
+    web_route_t *route = (web_route_t *)req->user_ctx;
+    metrics_counter_inc(&route->requests);
+    
+    // WebSocket frames belong to an admitted handshake
+    if (route->uri.is_websocket && req->method != HTTP_GET) {
+        return route_run(req);
+    }
+    
+    esp_err_t ret;
+    if (!web_limit_admit(req, route->limit, &ret)) {
+        return ret;
+    }
+    
+    if (route->async) {
+        ret = web_async_dispatch(req, route_run_async);
+        if (ret != ESP_OK) {
+            web_limit_release();
+        }
+        return ret;
+    }
+    ret = route_run(req);
+    web_limit_release();
+    return ret;
+}
+
+/**
+ * HTTP debug API - per-route table of requests, responses, latency and heap
+ */
+static esp_err_t api_debug_http_handler(httpd_req_t *req)
+{
+    static const char *const status_names[ROUTE_STATUS_CLASSES] = {"none", "1xx", "2xx", "3xx", "4xx", "5xx"};
+    static const uint32_t percentiles[] = {50, 95, 99};
+    static const char *const percentile_names[] = {"p50", "p95", "p99"};
+    
+    char buf[JSON_RESPONSE_BUF_SIZE];
+    json_writer_t json;
+    json_response_begin(req, &json, buf, sizeof(buf));
+    
+    json_writer_object_begin(&json, NULL);
+    json_writer_array_begin(&json, "routes");
+    for (size_t i = 0; i < ROUTE_COUNT; i++) {
+        web_route_t *route = &routes[i];
+        uint32_t handled = metrics_histogram_count(&route->latency);
+        uint32_t max_us = atomic_load(&route->max_us);
+        int32_t heap_delta = atomic_load(&route->heap_delta);
+        uint32_t bytes = atomic_load(&route->response_bytes);
+        
+        json_writer_object_begin(&json, NULL);
+        json_writer_string(&json, "uri", route->uri.uri);
+        json_writer_string(&json, "method", http_method_str(route->uri.method));
+        json_writer_int(&json, "requests", atomic_load(&route->requests.value));
+        json_writer_int(&json, "handled", handled);
+        
+        json_writer_object_begin(&json, "responses");
+        for (int c = 0; c < ROUTE_STATUS_CLASSES; c++) {
+            json_writer_int(&json, status_names[c], atomic_load(&route->responses[c]));
+        }
+        json_writer_object_end(&json);
+        json_writer_int(&json, "bytes", bytes);
+        json_writer_int(&json, "bytes_per_response", handled ? bytes / handled : 0);
+        
+        // Bucket bounds, capped by the largest observation
+        json_writer_object_begin(&json, "latency_us");
+        json_writer_int(&json, "mean", handled ? atomic_load(&route->latency.sum) / handled : 0);
+        for (size_t p = 0; p < sizeof(percentiles) / sizeof(percentiles[0]); p++) {
+            uint32_t bound = metrics_histogram_percentile(&route->latency, percentiles[p]);
+            json_writer_int(&json, percentile_names[p], bound < max_us ? bound : max_us);
+        }
+        json_writer_int(&json, "max", max_us);
+        json_writer_object_end(&json);
+        
+        json_writer_int(&json, "heap_delta", heap_delta);
+        json_writer_int(&json, "heap_delta_per_request", handled ? heap_delta / (int32_t)handled : 0);
+        json_writer_object_end(&json);
+    }
+    json_writer_array_end(&json);
+    
+    web_async_stats_t async;
+    web_async_get_stats(&async);
+    json_writer_object_begin(&json, "async");
+    json_writer_int(&json, "queued", async.queued);
+    json_writer_int(&json, "rejected", async.rejected);
+    json_writer_int(&json, "busy", async.busy);
+    json_writer_object_end(&json);
+    
+    static const char *const class_names[WEB_LIMIT_CLASS_COUNT] = {"static", "api", "ota"};
+    web_limit_stats_t limit;
+    web_limit_get_stats(&limit);
+    json_writer_object_begin(&json, "limit");
+    json_writer_bool(&json, "enabled", WEB_LIMIT_ENABLE);
+#if WEB_LIMIT_EXEMPT_ENABLE
+    char exempt[WEB_LIMIT_ADDR_STR_LEN];
+    uint32_t exempt_ttl_s;
+    web_limit_get_exempt(exempt, sizeof(exempt), &exempt_ttl_s);
+    json_writer_string(&json, "exempt", exempt);
+    json_writer_int(&json, "exempt_ttl_s", exempt_ttl_s);
+#endif
+    json_writer_object_begin(&json, "rate_rejected");
+    for (int c = 0; c < WEB_LIMIT_CLASS_COUNT; c++) {
+        json_writer_int(&json, class_names[c], limit.rate[c]);
+    }
+    json_writer_object_end(&json);
+    json_writer_int(&json, "connections_rejected", limit.connections);
+    json_writer_int(&json, "inflight_rejected", limit.inflight);
+    json_writer_int(&json, "clients", limit.clients);
+    json_writer_object_end(&json);
+    json_writer_object_end(&json);
+    
+    return json_response_end(req, &json);
+}
+
 // ============================================================================
 // SERVER CONTROL
 // ============================================================================
@@ -745,37 +1362,44 @@ esp_err_t web_server_start(void)
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.uri_match_fn = httpd_uri_match_wildcard;
     config.lru_purge_enable = true;
-    config.max_uri_handlers = 15;
+    config.max_uri_handlers = ROUTE_COUNT;
+    config.max_open_sockets = WEB_SERVER_MAX_SOCKETS;
+    config.stack_size = WEB_SERVER_STACK_SIZE;
+    
+    config.open_fn = route_session_open;
+    config.close_fn = route_session_close;
+    
+    // Route metrics outlive a server restart, register them once
+    static bool metrics_registered = false;
+    if (!metrics_registered) {
+        for (size_t i = 0; i < ROUTE_COUNT; i++) {
+            routes[i].latency.buckets = routes[i].latency_buckets;
+            metrics_register(&routes[i].requests);
+            metrics_register(&routes[i].latency);
+        }
+        metrics_registered = true;
+    }
+    web_limit_init();
+    
+    // Immutable responses are serialized once, before the first request
+    size_t len;
+    web_cache_get(&ota_info_cache, &len);
+    
+    if (web_async_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start async workers");
+        return ESP_FAIL;
+    }
     
     ESP_LOGI(TAG, "Starting web server");
     
     if (httpd_start(&server, &config) == ESP_OK) {
-        // Provisioning page
-        httpd_uri_t root_uri = {.uri = "/", .method = HTTP_GET, .handler = root_handler};
-        httpd_register_uri_handler(server, &root_uri);
-        
-        // OTA page
-        httpd_uri_t ota_uri = {.uri = "/ota", .method = HTTP_GET, .handler = ota_page_handler};
-        httpd_register_uri_handler(server, &ota_uri);
-        
-        // APIs
-        httpd_uri_t api_status = {.uri = "/api/status", .method = HTTP_GET, .handler = api_status_handler};
-        httpd_register_uri_handler(server, &api_status);
-        
-        httpd_uri_t api_time = {.uri = "/api/time", .method = HTTP_GET, .handler = api_time_handler};
-        httpd_register_uri_handler(server, &api_time);
-        
-        httpd_uri_t api_wifi_save = {.uri = "/api/wifi/save", .method = HTTP_POST, .handler = api_wifi_save_handler};
-        httpd_register_uri_handler(server, &api_wifi_save);
-        
-        httpd_uri_t api_ota_info = {.uri = "/api/ota/info", .method = HTTP_GET, .handler = api_ota_info_handler};
-        httpd_register_uri_handler(server, &api_ota_info);
-        
-        httpd_uri_t api_ota_update = {.uri = "/api/ota/update", .method = HTTP_POST, .handler = api_ota_update_handler};
-        httpd_register_uri_handler(server, &api_ota_update);
-
-        httpd_uri_t api_weather = {.uri = "/api/weather", .method = HTTP_GET, .handler = api_weather_handler};
-        httpd_register_uri_handler(server, &api_weather);
+        for (size_t i = 0; i < ROUTE_COUNT; i++) {
+            httpd_uri_t uri = routes[i].uri;
+            uri.handler = route_handler;
+            uri.user_ctx = &routes[i];
+            httpd_register_uri_handler(server, &uri);
+        }
+        web_push_start(server, push_topics, sizeof(push_topics) / sizeof(push_topics[0]));
         
         ESP_LOGI(TAG, "Web server started successfully");
         ESP_LOGI(TAG, "  Provisioning: http://192.168.4.1/");
@@ -794,6 +1418,7 @@ esp_err_t web_server_start(void)
 esp_err_t web_server_stop(void)
 {
     if (server) {
+        web_push_stop();
         httpd_stop(server);
         server = NULL;
         ESP_LOGI(TAG, "Web server stopped");
@@ -0,0 +1,148 @@
+// Device clock minus browser clock (ms), null until synchronized
+let clockOffset = null;
+
+function pad(n) {
+    return (n < 10 ? '0' : '') + n;
+}
+
+// Show device local time, ticked by the browser between pushes
+function tickClock() {
+    if (clockOffset === null) return;
+    const t = new Date(Date.now() + clockOffset);
+    document.getElementById('timeDisplay').textContent =
+        pad(t.getUTCHours()) + ':' + pad(t.getUTCMinutes()) + ':' + pad(t.getUTCSeconds());
+    document.getElementById('dateDisplay').textContent =
+        pad(t.getUTCDate()) + '.' + pad(t.getUTCMonth() + 1) + '.' + t.getUTCFullYear();
+}
+
+// Render time
+function renderTime(d) {
+    const td = document.getElementById('timeDisplay');
+    const dd = document.getElementById('dateDisplay');
+    const sb = document.getElementById('syncBadge');
+    if (d.synced && d.epoch) {
+        // Local time as a UTC date, so the UTC getters return the device's wall clock
+        clockOffset = (d.epoch + (d.utc_offset || 0)) * 1000 - Date.now();
+        tickClock();
+        sb.textContent = '✓ Synchronized';
+        sb.className = 'sync-badge synced';
+    } else {
+        clockOffset = null;
+        td.textContent = '--:--:--';
+        dd.textContent = 'Not synced';
+        sb.textContent = '⏳ Syncing...';
+        sb.className = 'sync-badge waiting';
+    }
+}
+
+// Render weather
+function renderWeather(d) {
+    const content = document.getElementById('weatherContent');
+    document.getElementById('weatherTitle').textContent = 'Weather in ' + d.station;
+    if (d.valid) {
+        content.innerHTML =
+            '<div class="weather-display">'
+            + '<div class="weather-item">'
+            + '<div class="weather-icon">🌡️</div>'
+            + '<div><span class="weather-value">' + d.temperature.toFixed(1) + '</span><span class="weather-unit">°C</span></div>'
+            + '<div class="weather-label">Temperature</div>'
+            + '</div>'
+            + '<div class="weather-item">'
+            + '<div class="weather-icon">💧</div>'
+            + '<div><span class="weather-value">' + d.humidity + '</span><span class="weather-unit">%</span></div>'
+            + '<div class="weather-label">Humidity</div>'
+            + '</div>'
+            + '</div>'
+            + '<div class="weather-update">Last update: ' + d.last_update_str + '</div>';
+    } else {
+        content.innerHTML = '<div style="text-align:center;color:#e53e3e;padding:20px 0">⚠️ Weather data unavailable</div>';
+    }
+}
+
+// Render status
+function renderStatus(d) {
+    const card = document.getElementById('statusCard');
+    const content = document.getElementById('statusContent');
+    if (d.connected) {
+        card.className = 'card success';
+        content.innerHTML =
+            '<div class="info-row"><span class="info-label">SSID</span><span class="info-value">' + d.ssid + '</span></div>'
+            + '<div class="info-row"><span class="info-label">IP Address</span><span class="info-value">' + d.ip + '</span></div>'
+            + '<div class="info-row"><span class="info-label">Gateway</span><span class="info-value">' + d.gateway + '</span></div>'
+            + '<div class="info-row"><span class="info-label">AP IP</span><span class="info-value">' + d.ap_ip + '</span></div>';
+    } else {
+        card.className = 'card warning';
+        content.innerHTML =
+            '<div class="info-row"><span class="info-label">Mode</span><span class="info-value">AP Only</span></div>'
+            + '<div class="info-row"><span class="info-label">AP IP</span><span class="info-value">' + d.ap_ip + '</span></div>'
+            + '<div style="margin-top:12px;color:#744210;font-size:12px;text-align:center">Configure WiFi below to connect</div>';
+    }
+}
+
+// Refresh all in one request (button, and fallback while the push channel is down)
+function refreshAll() {
+    fetch('/api/dashboard').then(r => r.json()).then(d => {
+        d.time.epoch = d.epoch;
+        renderTime(d.time);
+        renderStatus(d.status);
+        renderWeather(d.weather);
+    }).catch(e => console.error(e));
+}
+
+// Push channel: the device sends the full state on connect, then only what changed
+function connectPush() {
+    const ws = new WebSocket('ws://' + location.host + '/ws');
+    ws.onmessage = e => {
+        const m = JSON.parse(e.data);
+        if (m.time) renderTime(m.time);
+        if (m.weather) renderWeather(m.weather);
+        if (m.status) renderStatus(m.status);
+    };
+    ws.onclose = () => {
+        refreshAll();
+        setTimeout(connectPush, 5000);
+    };
+}
+
+setInterval(tickClock, 1000);
+if ('WebSocket' in window) {
+    connectPush();
+} else {
+    refreshAll();
+    setInterval(refreshAll, 60000);
+}
+
+// Form submit
+document.getElementById('wifiForm').addEventListener('submit', function (e) {
+    e.preventDefault();
+    const msg = document.getElementById('statusMsg');
+    const btn = e.target.querySelector('button');
+    const ssid = document.getElementById('ssid').value;
+    const pwd = document.getElementById('password').value;
+    msg.className = 'status-msg';
+    msg.textContent = 'Connecting to ' + ssid + '...';
+    msg.classList.add('show');
+    btn.disabled = true;
+    fetch('/api/wifi/save', {
+        method: 'POST',
+        headers: {'Content-Type': 'application/json'},
+        body: JSON.stringify({ssid: ssid, password: pwd})
+    })
+        .then(r => r.json())
+        .then(d => {
+            if (d.success) {
+                msg.className = 'status-msg success show';
+                msg.textContent = '✓ WiFi saved! Device restarting in 3 seconds...';
+                setTimeout(() => location.reload(), 3000);
+            } else {
+                msg.className = 'status-msg error show';
+                msg.textContent = '✗ Failed: ' + (d.message || 'Unknown error');
+                btn.disabled = false;
+            }
+        })
+        .catch(e => {
+            msg.className = 'status-msg error show';
+            msg.textContent = '✗ Connection error: ' + e;
+            btn.disabled = false;
+        });
+});
@@ -0,0 +1,99 @@
+let selectedFile = null;
+
+// Load info
+function loadInfo() {
+    fetch('/api/ota/info').then(r => r.json()).then(d => {
+        document.getElementById('version').textContent = d.version || 'Unknown';
+        document.getElementById('partition').textContent = d.partition || 'Unknown';
+        const freeMB = d.free_space ? ((d.free_space / 1024 / 1024).toFixed(2) + ' MB') : 'Unknown';
+        document.getElementById('freeSpace').textContent = freeMB;
+    }).catch(e => {
+        console.error(e);
+        document.getElementById('freeSpace').textContent = 'Error';
+    });
+}
+loadInfo();
+
+// Drag & drop
+const area = document.getElementById('uploadArea');
+const fileInput = document.getElementById('fileInput');
+area.addEventListener('dragover', e => {
+    e.preventDefault();
+    area.classList.add('drag-over');
+});
+area.addEventListener('dragleave', () => area.classList.remove('drag-over'));
+area.addEventListener('drop', e => {
+    e.preventDefault();
+    area.classList.remove('drag-over');
+    if (e.dataTransfer.files.length > 0) handleFile(e.dataTransfer.files[0]);
+});
+fileInput.addEventListener('change', e => {
+    if (e.target.files.length > 0) handleFile(e.target.files[0]);
+});
+
+// Handle file
+function handleFile(file) {
+    if (!file.name.endsWith('.bin')) {
+        alert('Please select a .bin file');
+        return;
+    }
+    selectedFile = file;
+    const fn = document.getElementById('fileName');
+    fn.textContent = '📄 ' + file.name + ' (' + (file.size / 1024 / 1024).toFixed(2) + ' MB)';
+    fn.style.display = 'block';
+    document.getElementById('uploadBtn').disabled = false;
+}
+
+// Upload
+function uploadFirmware() {
+    if (!selectedFile) return;
+    const formData = new FormData();
+    formData.append('file', selectedFile);
+    const btn = document.getElementById('uploadBtn');
+    const pc = document.getElementById('progressContainer');
+    const pf = document.getElementById('progressFill');
+    const pt = document.getElementById('progressText');
+    const pm = document.getElementById('progressMsg');
+    btn.disabled = true;
+    pc.style.display = 'block';
+    const xhr = new XMLHttpRequest();
+    xhr.upload.addEventListener('progress', e => {
+        if (e.lengthComputable) {
+            const pct = Math.round((e.loaded / e.total) * 100);
+            pf.style.width = pct + '%';
+            pt.textContent = pct + '%';
+        }
+    });
+    xhr.addEventListener('load', () => {
+        if (xhr.status === 200) {
+            try {
+                const resp = JSON.parse(xhr.responseText);
+                if (resp.success) {
+                    pm.className = 'progress-msg success';
+                    const rate = resp.stats ? ' (' + resp.stats.kbps + ' KB/s)' : '';
+                    pm.textContent = '✓ Update successful' + rate + '! Device restarting in 3 seconds...';
+                    setTimeout(() => location.reload(), 3000);
+                } else {
+                    pm.className = 'progress-msg error';
+                    pm.textContent = '✗ Update failed: ' + (resp.message || 'Unknown error');
+                    btn.disabled = false;
+                }
+            } catch (e) {
+                pm.className = 'progress-msg error';
+                pm.textContent = '✗ Invalid response from device';
+                btn.disabled = false;
+            }
+        } else {
+            pm.className = 'progress-msg error';
+            pm.textContent = '✗ Upload error: HTTP ' + xhr.status;
+            btn.disabled = false;
+        }
+    });
+    xhr.addEventListener('error', () => {
+        pm.className = 'progress-msg error';
+        pm.textContent = '✗ Network error occurred';
+        btn.disabled = false;
+    });
+    xhr.open('POST', '/api/ota/update', true);
+    xhr.send(formData);
+}
@@ -49,6 +49,7 @@ esp_err_t wifi_manager_save_credentials(const char *ssid, const char *password);
 esp_err_t wifi_manager_load_credentials(wifi_credentials_t *creds);
 bool wifi_manager_has_credentials(void);
 wifi_state_t wifi_manager_get_state(void);
+uint32_t wifi_manager_get_state_version(void);     // Increases on every state change
 void wifi_manager_set_connected_callback(wifi_connected_cb_t callback);
 void wifi_manager_set_disconnected_callback(wifi_disconnected_cb_t callback);
 
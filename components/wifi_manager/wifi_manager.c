@@ -5,15 +5,22 @@
 #include "nvs.h"
 #include "esp_netif.h"
 #include "lwip/inet.h"
+#include "snapshot.h"
+#include "metrics.h"
 #include <string.h>
 
 static const char *TAG = "WIFI_MANAGER";
 
-// Global state
+// Global state (written from the event loop and API calls, read from any task)
 static wifi_state_t current_state = WIFI_STATE_IDLE;
+static snapshot_t state_snapshot = SNAPSHOT_INIT(&current_state, sizeof(current_state));
 static wifi_credentials_t stored_credentials = {0};
 static int retry_count = 0;
 
+// Exported metrics (/metrics)
+static metric_t disconnect_metric = METRIC_COUNTER_INIT("wifi_disconnects_total", "Station disconnects", NULL);
+static metric_t reconnect_metric = METRIC_COUNTER_INIT("wifi_reconnects_total", "Station reconnect attempts", NULL);
+
 // Callbacks
 static wifi_connected_cb_t connected_callback = NULL;
 static wifi_disconnected_cb_t disconnected_callback = NULL;
@@ -23,6 +30,13 @@ static EventGroupHandle_t wifi_event_group;
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT      BIT1
 
+/**
+ * Publish new state
+ */
+static void set_state(wifi_state_t state)
+{
+    snapshot_write(&state_snapshot, &state);
+}
 
 /**
  * WiFi event handler
@@ -51,20 +65,22 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
             case WIFI_EVENT_STA_START:
                 ESP_LOGI(TAG, "WiFi STA started, connecting...");
                 esp_wifi_connect();
-                current_state = WIFI_STATE_STA_CONNECTING;
+                set_state(WIFI_STATE_STA_CONNECTING);
                 break;
 
             case WIFI_EVENT_STA_DISCONNECTED:
                 ESP_LOGI(TAG, "WiFi disconnected");
-                current_state = WIFI_STATE_STA_DISCONNECTED;
+                set_state(WIFI_STATE_STA_DISCONNECTED);
+                metrics_counter_inc(&disconnect_metric);
                 
                 if (retry_count < WIFI_STA_MAXIMUM_RETRY) {
                     esp_wifi_connect();
                     retry_count++;
+                    metrics_counter_inc(&reconnect_metric);
                     ESP_LOGI(TAG, "Retry connecting to WiFi (%d/%d)", retry_count, WIFI_STA_MAXIMUM_RETRY);
                 } else {
                     xEventGroupSetBits(wifi_event_group, WIFI_FAIL_BIT);
-                    current_state = WIFI_STATE_STA_FAILED;
+                    set_state(WIFI_STATE_STA_FAILED);
                     ESP_LOGE(TAG, "Failed to connect to WiFi after %d retries", WIFI_STA_MAXIMUM_RETRY);
                     
                     if (disconnected_callback) {
@@ -80,7 +96,7 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
         ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
         ESP_LOGI(TAG, "Got IP Address: " IPSTR, IP2STR(&event->ip_info.ip));
         retry_count = 0;
-        current_state = WIFI_STATE_STA_CONNECTED;
+        set_state(WIFI_STATE_STA_CONNECTED);
         xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT);
         
         if (connected_callback) {
@@ -96,6 +112,9 @@ esp_err_t wifi_manager_init(void)
 {
     ESP_LOGI(TAG, "Initializing WiFi Manager");
     
+    metrics_register(&disconnect_metric);
+    metrics_register(&reconnect_metric);
+    
     // Initialize NVS
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -168,7 +187,7 @@ esp_err_t wifi_manager_start_ap(void)
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_AP, &wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
     
-    current_state = WIFI_STATE_AP_STARTED;
+    set_state(WIFI_STATE_AP_STARTED);
     
     ESP_LOGI(TAG, "WiFi AP started - SSID: %s, Password: %s, IP: %s", 
              WIFI_AP_SSID, WIFI_AP_PASSWORD, WIFI_AP_IP);
@@ -297,7 +316,7 @@ esp_err_t wifi_manager_start_apsta(void)
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config_sta));
     ESP_ERROR_CHECK(esp_wifi_start());
     
-    current_state = WIFI_STATE_AP_STARTED; // Will change to CONNECTED when STA connects
+    set_state(WIFI_STATE_AP_STARTED); // Will change to CONNECTED when STA connects
     
     ESP_LOGI(TAG, "WiFi APSTA started");
     ESP_LOGI(TAG, "  AP - SSID: %s, IP: %s", WIFI_AP_SSID, WIFI_AP_IP);
@@ -500,7 +519,17 @@ bool wifi_manager_has_credentials(void)
  */
 wifi_state_t wifi_manager_get_state(void)
 {
-    return current_state;
+    wifi_state_t state;
+    snapshot_read(&state_snapshot, &state);
+    return state;
+}
+
+/**
+ * Get state version
+ */
+uint32_t wifi_manager_get_state_version(void)
+{
+    return snapshot_version(&state_snapshot);
 }
 
 /**
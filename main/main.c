@@ -12,6 +12,8 @@
 #include "ota_manager.h"
 #include "web_server.h"
 #include "weather_client.h"
+#include "json_writer.h"
+#include "heap_stats.h"
 
 static const char *TAG = "MAIN";
 
@@ -81,6 +83,24 @@ void app_main(void)
     ESP_ERROR_CHECK(ret);
     ESP_LOGI(TAG, "✓ NVS initialized");
     
+    // Heap allocation counters and metrics (see heap_stats.h)
+    heap_stats_init();
+    
+#if WEATHER_METRICS_BENCHMARK
+    // Fixed-point vs soft-float cycle counts (see weather_metrics.h)
+    weather_metrics_benchmark();
+#endif
+    
+#if JSON_WRITER_BENCHMARK
+    // Streaming writer vs cJSON heap use and throughput (see json_writer.h)
+    json_writer_benchmark();
+#endif
+    
+#if WEATHER_DECODE_BENCHMARK
+    // cJSON vs streaming JSON vs FlatBuffers decode cost (see weather_client.h)
+    weather_decode_benchmark();
+#endif
+    
     // Initialize LED indicators
     led_init();
     led_start_blink_task();
@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+"""Build the web pages for embedding in the firmware.
+
+Called by the web_server component at build time. For every page it:
+
+  - inlines the local stylesheets and scripts the page references
+    (<link rel="stylesheet" href="x.css">, <script src="x.js"></script>),
+    so a page load stays a single request,
+  - minifies HTML, CSS and JS,
+  - writes <page>.gz (reproducible: no timestamp or file name in the header).
+
+It also writes web_assets.h with a strong ETag (content hash of the gzip file)
+and the sizes of each page, and manifest.json with the size and SHA-256 of
+every source and output. A page whose gzip size exceeds its budget fails the
+build and nothing is written:
+
+    python3 tools/build_assets.py --out build/www --budget index.html=4096 \\
+        components/web_server/www/index.html
+
+The minifiers are deliberately simple: comments and layout whitespace are
+removed, line breaks in JS are kept where automatic semicolon insertion could
+depend on them. JS regular expression literals must not contain quotes or
+"//" (use new RegExp() instead).
+"""
+
+import argparse
+import gzip
+import hashlib
+import json
+import os
+import re
+import sys
+
+LINK_RE = re.compile(r'<link rel="stylesheet" href="([^":/]+)">')
+SCRIPT_RE = re.compile(r'<script src="([^":/]+)"></script>')
+
+# A JS line break can be dropped after these characters...
+JS_JOIN_AFTER = set("{([,;=:?&|")
+# ...or before these, as the line continues the expression anyway
+JS_JOIN_BEFORE = set(".)]},;:?=&|*/%<>+-")
+# Restricted productions: a line break after these ends the statement
+JS_NO_JOIN_KEYWORDS = ("return", "break", "continue", "throw", "yield")
+
+
+def split_js(text):
+    """Split JS into (is_code, text) pieces, strings and templates kept whole, comments dropped"""
+    pieces = []
+    code = []
+    i = 0
+    while i < len(text):
+        c = text[i]
+        if c in "'\"`":
+            j = i + 1
+            while j < len(text) and text[j] != c:
+                j += 2 if text[j] == "\\" else 1
+            pieces.append((True, "".join(code)))
+            pieces.append((False, text[i:j + 1]))
+            code = []
+            i = j + 1
+        elif text.startswith("//", i):
+            j = text.find("\n", i)
+            i = len(text) if j < 0 else j
+        elif text.startswith("/*", i):
+            j = text.find("*/", i + 2)
+            i = len(text) if j < 0 else j + 2
+        else:
+            code.append(c)
+            i += 1
+    pieces.append((True, "".join(code)))
+    return pieces
+
+
+def is_word(c):
+    return c.isalnum() or c in "_$"
+
+
+def minify_js(text):
+    # Whitespace runs in code become a marker, resolved once both neighbours are known
+    tokens = []
+    for is_code, piece in split_js(text):
+        if not is_code:
+            tokens.append(piece)
+            continue
+        for part in re.split(r"(\s+)", piece):
+            if part.isspace():
+                tokens.append("\n" if "\n" in part else " ")
+            elif part:
+                tokens.append(part)
+
+    out = ""
+    pending = None
+    for token in tokens:
+        if token in (" ", "\n"):
+            pending = "\n" if token == "\n" or pending == "\n" else " "
+            continue
+        if pending and out:
+            prev, nxt = out[-1], token[0]
+            if pending == "\n":
+                restricted = (re.search(r"\b(%s)$" % "|".join(JS_NO_JOIN_KEYWORDS), out) or
+                              out.endswith(("++", "--")) or token.startswith(("++", "--")))
+                if restricted or not (prev in JS_JOIN_AFTER or nxt in JS_JOIN_BEFORE):
+                    out += "\n"
+            elif is_word(prev) and is_word(nxt):
+                out += " "
+            elif prev + nxt in ("++", "--", "+-", "-+", "//"):
+                out += " "
+        pending = None
+        out += token
+    return out
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{};:,>])\s*", r"\1", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify_html(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    out = ""
+    for line in (l.strip() for l in text.split("\n")):
+        if not line:
+            continue
+        if out and not (out.endswith(">") and line.startswith("<")):
+            out += " "
+        out += line
+    return out
+
+
+def build_page(path):
+    """Minified page with its stylesheets and scripts inlined, and the sources it was built from"""
+    base = os.path.dirname(path)
+    sources = {os.path.basename(path): read(path)}
+
+    def inline(match, tag, minify):
+        name = match.group(1)
+        sources[name] = read(os.path.join(base, name))
+        return "<%s>%s</%s>" % (tag, minify(sources[name].decode()), tag)
+
+    html = minify_html(sources[os.path.basename(path)].decode())
+    html = LINK_RE.sub(lambda m: inline(m, "style", minify_css), html)
+    html = SCRIPT_RE.sub(lambda m: inline(m, "script", minify_js), html)
+    return html.encode(), sources
+
+
+def read(path):
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def macro_name(name):
+    """WEB_ASSET_<NAME> for a file name, e.g. index.html -> WEB_ASSET_INDEX_HTML"""
+    return "WEB_ASSET_" + re.sub(r"[^A-Za-z0-9]", "_", name).upper()
+
+
+def sha256(data):
+    return hashlib.sha256(data).hexdigest()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--out", required=True, help="output directory")
+    parser.add_argument("--budget", action="append", default=[], metavar="PAGE=BYTES",
+                        help="largest allowed gzip size of a page")
+    parser.add_argument("pages", nargs="+")
+    args = parser.parse_args()
+
+    budgets = {}
+    for entry in args.budget:
+        name, _, size = entry.partition("=")
+        budgets[name] = int(size)
+
+    pages = []
+    over_budget = []
+    for path in args.pages:
+        name = os.path.basename(path)
+        minified, sources = build_page(path)
+        packed = gzip.compress(minified, compresslevel=9, mtime=0)
+        budget = budgets.get(name)
+        if budget is not None and len(packed) > budget:
+            over_budget.append("%s: %d bytes gzipped, budget %d" % (name, len(packed), budget))
+        pages.append((name, sources, minified, packed, budget))
+
+    if over_budget:
+        for line in over_budget:
+            print("error: web page over budget, %s" % line, file=sys.stderr)
+        print("Shrink the page or raise its budget in components/web_server/CMakeLists.txt", file=sys.stderr)
+        sys.exit(1)
+
+    os.makedirs(args.out, exist_ok=True)
+    header = [
+        "// Generated by tools/build_assets.py, do not edit",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+    ]
+    manifest = {}
+    total_source = total_gz = 0
+
+    for name, sources, minified, packed, budget in pages:
+        with open(os.path.join(args.out, name + ".gz"), "wb") as f:
+            f.write(packed)
+
+        digest = sha256(packed)
+        source_bytes = sum(len(data) for data in sources.values())
+        header += [
+            '#define %s_ETAG "\\"%s\\""' % (macro_name(name), digest[:16]),
+            "#define %s_SIZE %d" % (macro_name(name), len(minified)),
+            "#define %s_GZ_SIZE %d" % (macro_name(name), len(packed)),
+            "",
+        ]
+        manifest[name] = {
+            "sources": {src: {"bytes": len(data), "sha256": sha256(data)} for src, data in sources.items()},
+            "source_bytes": source_bytes,
+            "minified_bytes": len(minified),
+            "gzip_bytes": len(packed),
+            "gzip_sha256": digest,
+            "budget_bytes": budget,
+        }
+        total_source += source_bytes
+        total_gz += len(packed)
+        print("%-12s %6d -> %6d minified -> %5d gzip%s" % (
+            name, source_bytes, len(minified), len(packed),
+            " (budget %d)" % budget if budget is not None else ""))
+
+    header.append("#endif // WEB_ASSETS_H")
+    with open(os.path.join(args.out, "web_assets.h"), "w") as f:
+        f.write("\n".join(header) + "\n")
+    with open(os.path.join(args.out, "manifest.json"), "w") as f:
+        json.dump(manifest, f, indent=2, sort_keys=True)
+        f.write("\n")
+    print("web assets: %d source bytes -> %d bytes embedded" % (total_source, total_gz))
+
+
+if __name__ == "__main__":
+    main()
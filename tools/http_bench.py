@@ -0,0 +1,344 @@
+#!/usr/bin/env python3
+"""HTTP load benchmark of the web server on a running device.
+
+For each endpoint, --clients threads send GET requests over keep-alive
+connections for --duration seconds. The script reports per endpoint:
+
+  - requests/s and p50/p99 latency (client side, includes the network),
+  - heap allocations and bytes allocated per request, from the counters at
+    /api/debug/heap (heap_stats component) read before and after the run,
+  - peak heap: the largest drop of free heap below its value at the start,
+    sampled from /api/debug/heap every --sample seconds during the run.
+
+Heap figures include everything else the device did meanwhile (weather
+fetches, push messages) and the cost of the sampling requests is subtracted
+as measured before the first endpoint, so treat small values as noise.
+
+Run it before a release and compare with the numbers of the last one:
+
+    python3 tools/http_bench.py --host 192.168.1.50 --save bench.json
+    python3 tools/http_bench.py --host 192.168.1.50 --compare bench.json
+
+With --compare the script exits 1 when an endpoint got slower or allocates
+more than allowed by --max-regression. The http_bench build target runs it
+with HTTP_BENCH_HOST as the host (see the top-level CMakeLists.txt).
+
+The load is far above the per-client rate limits of the web server. On a
+bench build (WEB_LIMIT_EXEMPT_ENABLE in web_limit.h) the script exempts its
+own address for the expected length of the run (POST /api/debug/limit) and
+afterwards puts the previous setting back; the exemption also expires on its
+own if the script dies. Without that build, or with --no-exempt, it runs
+within the limits instead: a 429 or 503 answer makes the client wait for its
+Retry-After. 429 answers are counted in their own
+column, not as errors, and req/s and p99 of such an endpoint are not compared
+with the baseline (the limiter caps them).
+"""
+
+import argparse
+import http.client
+import json
+import os
+import sys
+import threading
+import time
+
+DEFAULT_ENDPOINTS = [
+    "/",
+    "/ota",
+    "/api/status",
+    "/api/time",
+    "/api/weather",
+    "/api/dashboard",
+    "/api/ota/info",
+    "/api/weather/trace",
+]
+
+HEAP_URI = "/api/debug/heap"
+HTTP_URI = "/api/debug/http"
+LIMIT_URI = "/api/debug/limit"
+CALIBRATION_REQUESTS = 10
+READING_ATTEMPTS = 10   # Heap readings around a run wait out a rate limit it exhausted
+U32 = 1 << 32
+
+
+class Device:
+    def __init__(self, host, port, timeout):
+        self.host = host
+        self.port = port
+        self.timeout = timeout
+
+    def connect(self):
+        return http.client.HTTPConnection(self.host, self.port, timeout=self.timeout)
+
+    def heap(self, conn=None, attempts=1):
+        """Heap counters, retried after Retry-After while rate limited"""
+        own = conn is None
+        conn = conn or self.connect()
+        try:
+            for attempt in range(attempts):
+                conn.request("GET", HEAP_URI)
+                resp = conn.getresponse()
+                body = resp.read()
+                if resp.status != 429 or attempt == attempts - 1:
+                    break
+                time.sleep(float(resp.getheader("Retry-After", "1")))
+            if resp.status != 200:
+                raise RuntimeError("%s: HTTP %d" % (HEAP_URI, resp.status))
+            return json.loads(body)
+        finally:
+            if own:
+                conn.close()
+
+    def exempt(self, addr=None, ttl_s=0):
+        """Exempt an address from the rate limits for ttl_s seconds ("" for
+        none, default: our own address as the device sees it)
+        @return (address, seconds left) exempted before, None if the firmware
+        cannot exempt (not a bench build)"""
+        conn = self.connect()
+        try:
+            conn.request("GET", HTTP_URI)
+            resp = conn.getresponse()
+            body = resp.read()
+            if resp.status != 200:
+                raise RuntimeError("%s: HTTP %d" % (HTTP_URI, resp.status))
+            limit = json.loads(body)["limit"]
+            if "exempt" not in limit:
+                return None
+            previous = (limit["exempt"], limit.get("exempt_ttl_s", 0))
+            if addr is None:
+                addr = conn.sock.getsockname()[0]
+            if (addr, ttl_s) != previous:
+                request = {"exempt": addr}
+                if ttl_s:
+                    request["ttl_s"] = ttl_s
+                conn.request("POST", LIMIT_URI, json.dumps(request),
+                             {"Content-Type": "application/json"})
+                resp = conn.getresponse()
+                resp.read()
+                if resp.status != 200:
+                    raise RuntimeError("%s: HTTP %d" % (LIMIT_URI, resp.status))
+            return previous
+        finally:
+            conn.close()
+
+
+def delta(after, before, key):
+    """Counter difference, the device counters wrap at 2^32"""
+    return (after[key] - before[key]) % U32
+
+
+def calibrate(device):
+    """Allocations and bytes of one /api/debug/heap request"""
+    conn = device.connect()
+    first = device.heap(conn)
+    last = first
+    for _ in range(CALIBRATION_REQUESTS):
+        last = device.heap(conn)
+    conn.close()
+    return (delta(last, first, "allocs") / CALIBRATION_REQUESTS,
+            delta(last, first, "alloc_bytes") / CALIBRATION_REQUESTS)
+
+
+def client(device, uri, deadline, latencies, counts, lock):
+    """One keep-alive client sending requests until the deadline. A 429 or
+    503 answer is followed by a pause of its Retry-After."""
+    conn = device.connect()
+    mine = []
+    failed = 0
+    limited = 0
+    while time.monotonic() < deadline:
+        start = time.monotonic()
+        retry_s = 0
+        try:
+            conn.request("GET", uri)
+            resp = conn.getresponse()
+            resp.read()
+            if resp.status == 200:
+                mine.append((time.monotonic() - start) * 1000)
+            elif resp.status == 429:
+                limited += 1
+            else:
+                failed += 1
+            if resp.status in (429, 503):
+                retry_s = float(resp.getheader("Retry-After", "1"))
+            if resp.will_close:
+                conn.close()
+                conn = device.connect()
+        except (OSError, http.client.HTTPException, ValueError):
+            failed += 1
+            conn.close()
+            conn = device.connect()
+        if retry_s:
+            time.sleep(max(0.0, min(retry_s, deadline - time.monotonic())))
+    conn.close()
+    with lock:
+        latencies.extend(mine)
+        counts["errors"] += failed
+        counts["limited"] += limited
+
+
+def sampler(device, interval, stop, samples):
+    """Record free heap until stopped"""
+    conn = device.connect()
+    while not stop.wait(interval):
+        try:
+            samples.append(device.heap(conn)["free_bytes"])
+        except (OSError, http.client.HTTPException, RuntimeError, ValueError):
+            conn.close()
+            conn = device.connect()
+    conn.close()
+
+
+def percentile(values, p):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * p / 100))]
+
+
+def run_endpoint(device, uri, args, probe_cost):
+    before = device.heap(attempts=READING_ATTEMPTS)
+    latencies, counts, lock = [], {"errors": 0, "limited": 0}, threading.Lock()
+    samples, stop = [], threading.Event()
+    watcher = threading.Thread(target=sampler, args=(device, args.sample, stop, samples))
+    watcher.start()
+
+    deadline = time.monotonic() + args.duration
+    start = time.monotonic()
+    clients = [threading.Thread(target=client, args=(device, uri, deadline, latencies, counts, lock))
+               for _ in range(args.clients)]
+    for t in clients:
+        t.start()
+    for t in clients:
+        t.join()
+    elapsed = time.monotonic() - start
+    stop.set()
+    watcher.join()
+    after = device.heap(attempts=READING_ATTEMPTS)
+
+    # The sampler's requests and the final reading are not part of the load
+    probes = len(samples) + 1
+    requests = len(latencies)
+    # Heap traffic is spread over every answer, a 429 costs a little too
+    answered = requests + counts["limited"]
+    allocs = max(0.0, delta(after, before, "allocs") - probe_cost[0] * probes)
+    alloc_bytes = max(0.0, delta(after, before, "alloc_bytes") - probe_cost[1] * probes)
+    lowest = min(samples + [after["free_bytes"]])
+    return {
+        "requests": requests,
+        "errors": counts["errors"],
+        "limited": counts["limited"],
+        "req_s": round(requests / elapsed, 1),
+        "p50_ms": round(percentile(latencies, 50), 1) if latencies else None,
+        "p99_ms": round(percentile(latencies, 99), 1) if latencies else None,
+        "allocs_per_req": round(allocs / answered, 2) if answered else None,
+        "heap_bytes_per_req": round(alloc_bytes / answered) if answered else None,
+        "peak_heap_bytes": max(0, before["free_bytes"] - lowest),
+    }
+
+
+def compare(results, baseline, args):
+    """Regressions of results against a saved run, as messages"""
+    limit = args.max_regression / 100
+    problems = []
+    for uri, now in results.items():
+        old = baseline.get(uri)
+        if not old or not now["requests"] or not old.get("requests"):
+            continue
+        # Throughput capped by the rate limiter says nothing about the handler
+        if not now["limited"] and not old.get("limited"):
+            if now["req_s"] < old["req_s"] * (1 - limit):
+                problems.append("%s: %.1f req/s, was %.1f" % (uri, now["req_s"], old["req_s"]))
+            if now["p99_ms"] > old["p99_ms"] * (1 + limit) + args.slack_ms:
+                problems.append("%s: p99 %.1f ms, was %.1f" % (uri, now["p99_ms"], old["p99_ms"]))
+        if now["allocs_per_req"] > old["allocs_per_req"] + args.slack_allocs:
+            problems.append("%s: %.2f allocs/request, was %.2f" % (
+                uri, now["allocs_per_req"], old["allocs_per_req"]))
+        if now["heap_bytes_per_req"] > old["heap_bytes_per_req"] * (1 + limit) + args.slack_bytes:
+            problems.append("%s: %d heap bytes/request, was %d" % (
+                uri, now["heap_bytes_per_req"], old["heap_bytes_per_req"]))
+    return problems
+
+
+def show(value, fmt):
+    return fmt % value if value is not None else "-"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default=os.environ.get("HTTP_BENCH_HOST"),
+                        help="device address (default: $HTTP_BENCH_HOST)")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--endpoint", action="append", metavar="URI",
+                        help="endpoint to load, repeatable (default: pages and GET APIs)")
+    parser.add_argument("--clients", type=int, default=4, help="concurrent keep-alive clients")
+    parser.add_argument("--duration", type=float, default=10, help="seconds per endpoint")
+    parser.add_argument("--sample", type=float, default=0.25, help="seconds between heap samples")
+    parser.add_argument("--timeout", type=float, default=5, help="timeout of one request (s)")
+    parser.add_argument("--no-exempt", dest="exempt", action="store_false",
+                        help="keep the rate limits for this host and honor Retry-After")
+    parser.add_argument("--save", metavar="FILE", help="write the results as JSON")
+    parser.add_argument("--compare", metavar="FILE", help="results of an earlier run to compare with")
+    parser.add_argument("--max-regression", type=float, default=20,
+                        help="allowed drop of req/s and growth of p99 and heap bytes (%%)")
+    parser.add_argument("--slack-ms", type=float, default=5, help="allowed p99 growth on top of the ratio")
+    parser.add_argument("--slack-allocs", type=float, default=0.5, help="allowed growth of allocs/request")
+    parser.add_argument("--slack-bytes", type=float, default=64, help="allowed growth of heap bytes/request")
+    args = parser.parse_args()
+    if not args.host:
+        parser.error("--host or HTTP_BENCH_HOST is required")
+
+    device = Device(args.host, args.port, args.timeout)
+    endpoints = args.endpoint or DEFAULT_ENDPOINTS
+    previous_exempt = None
+    if args.exempt:
+        # Calibration, heap readings and Retry-After waits on top of the load
+        run_s = int(len(endpoints) * (args.duration + 10) + 60)
+        previous_exempt = device.exempt(ttl_s=run_s)
+        if previous_exempt is None:
+            print("firmware cannot exempt this host (WEB_LIMIT_EXEMPT_ENABLE 0), running within the rate limits")
+            args.exempt = False
+    try:
+        probe_cost = calibrate(device)
+        print("%d clients, %g s per endpoint, rate limits %s, %s costs %.1f allocs / %.0f bytes (subtracted)" % (
+            args.clients, args.duration, "off for this host" if args.exempt else "on",
+            HEAP_URI, probe_cost[0], probe_cost[1]))
+        print("%-20s %7s %6s %6s %8s %8s %11s %11s %10s" % (
+            "endpoint", "req/s", "errors", "429", "p50 ms", "p99 ms", "allocs/req", "bytes/req", "peak heap"))
+
+        results = {}
+        for uri in endpoints:
+            r = run_endpoint(device, uri, args, probe_cost)
+            results[uri] = r
+            print("%-20s %7.1f %6d %6d %8s %8s %11s %11s %10d" % (
+                uri, r["req_s"], r["errors"], r["limited"], show(r["p50_ms"], "%.1f"), show(r["p99_ms"], "%.1f"),
+                show(r["allocs_per_req"], "%.2f"), show(r["heap_bytes_per_req"], "%d"), r["peak_heap_bytes"]))
+    finally:
+        if previous_exempt is not None:
+            device.exempt(*previous_exempt)
+
+    if args.save:
+        with open(args.save, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("results written to %s" % args.save)
+
+    failed = [uri for uri, r in results.items() if r["errors"] or not r["requests"]]
+    for uri in failed:
+        print("FAIL: %s had %d failed requests" % (uri, results[uri]["errors"]))
+
+    if args.compare:
+        if not os.path.exists(args.compare):
+            print("no baseline at %s, save one with --save to compare future runs" % args.compare)
+        else:
+            with open(args.compare) as f:
+                problems = compare(results, json.load(f), args)
+            for line in problems:
+                print("REGRESSION: %s" % line)
+            failed += problems
+            if not problems:
+                print("no regression against %s" % args.compare)
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
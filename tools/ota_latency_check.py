@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Check that /api/status stays responsive while a firmware upload runs.
+
+Polls GET /api/status for a while to get a baseline, then keeps polling
+while the firmware image is POSTed to /api/ota/update. With the upload on
+a worker (web_async.c) the httpd task stays free, so the status latency
+during the upload should stay close to the baseline:
+
+    python3 tools/ota_latency_check.py --host 192.168.1.50 \\
+        --firmware build/esp32c6-ota-weather.bin
+
+Prints p50/p95/max per phase and exits 1 when the p95 during the upload is
+above --max-ratio times the baseline p95 plus --slack-ms, or when status
+requests fail. The device installs the image and restarts a few seconds
+after the upload, so use a firmware it can boot.
+"""
+
+import argparse
+import http.client
+import os
+import sys
+import threading
+import time
+
+
+def get_status(host, port, timeout):
+    """Latency of one GET /api/status in ms, None on failure"""
+    start = time.monotonic()
+    try:
+        conn = http.client.HTTPConnection(host, port, timeout=timeout)
+        conn.request("GET", "/api/status")
+        resp = conn.getresponse()
+        resp.read()
+        conn.close()
+        if resp.status != 200:
+            return None
+    except (OSError, http.client.HTTPException):
+        return None
+    return (time.monotonic() - start) * 1000
+
+
+def poll(host, port, interval, timeout, samples, failures, until):
+    """Poll until until() is true, appending latencies and counting failures"""
+    while not until():
+        latency = get_status(host, port, timeout)
+        if latency is None:
+            failures.append(time.monotonic())
+        else:
+            samples.append(latency)
+        time.sleep(interval)
+
+
+def upload(host, port, path, result):
+    """POST the firmware as a raw body, store (status, body, seconds) in result"""
+    size = os.path.getsize(path)
+    start = time.monotonic()
+    try:
+        conn = http.client.HTTPConnection(host, port, timeout=120)
+        with open(path, "rb") as f:
+            conn.request("POST", "/api/ota/update", body=f,
+                         headers={"Content-Type": "application/octet-stream", "Content-Length": str(size)})
+            resp = conn.getresponse()
+            result.append((resp.status, resp.read().decode(errors="replace"), time.monotonic() - start))
+        conn.close()
+    except (OSError, http.client.HTTPException) as e:
+        result.append((None, str(e), time.monotonic() - start))
+
+
+def percentile(values, p):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * p / 100))]
+
+
+def report(name, samples, failures):
+    if not samples:
+        print("%-8s no successful requests, %d failed" % (name, len(failures)))
+        return None
+    p95 = percentile(samples, 95)
+    print("%-8s %4d requests  p50 %6.1f ms  p95 %6.1f ms  max %6.1f ms  %d failed" % (
+        name, len(samples), percentile(samples, 50), p95, max(samples), len(failures)))
+    return p95
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", required=True, help="device address")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--firmware", required=True, help="application image to upload")
+    parser.add_argument("--baseline", type=float, default=5, help="seconds of polling before the upload")
+    parser.add_argument("--interval", type=float, default=0.1, help="seconds between status requests")
+    parser.add_argument("--timeout", type=float, default=5, help="timeout of one status request (s)")
+    parser.add_argument("--max-ratio", type=float, default=2, help="allowed p95 growth during the upload")
+    parser.add_argument("--slack-ms", type=float, default=50, help="allowed p95 growth on top of the ratio")
+    args = parser.parse_args()
+
+    baseline, baseline_failed = [], []
+    end = time.monotonic() + args.baseline
+    poll(args.host, args.port, args.interval, args.timeout, baseline, baseline_failed,
+         lambda: time.monotonic() >= end)
+
+    result = []
+    uploader = threading.Thread(target=upload, args=(args.host, args.port, args.firmware, result))
+    during, during_failed = [], []
+    uploader.start()
+    poll(args.host, args.port, args.interval, args.timeout, during, during_failed,
+         lambda: not uploader.is_alive())
+    uploader.join()
+
+    status, body, seconds = result[0]
+    print("upload   %s in %.1f s: %s" % (status, seconds, body.strip()))
+    base_p95 = report("baseline", baseline, baseline_failed)
+    during_p95 = report("upload", during, during_failed)
+
+    if status != 200 or base_p95 is None or during_p95 is None or during_failed:
+        print("FAIL: upload or status requests failed")
+        sys.exit(1)
+    limit = base_p95 * args.max_ratio + args.slack_ms
+    if during_p95 > limit:
+        print("FAIL: p95 during upload %.1f ms > %.1f ms" % (during_p95, limit))
+        sys.exit(1)
+    print("OK: p95 during upload %.1f ms <= %.1f ms" % (during_p95, limit))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""Convert an Open-Meteo JSON response to the FlatBuffers stream format.
+
+With &format=flatbuffers the API answers one size-prefixed WeatherApiResponse
+message per location (openmeteo_sdk/fbs/weather_api.fbs). This script writes
+the same stream for a captured JSON response (single location or batch), so
+the JSON and FlatBuffers decoders can be compared on identical data:
+
+    python3 tools/weather_fb_encode.py \\
+        components/weather_client/host_test/data/open_meteo_batch.json \\
+        components/weather_client/host_test/data/open_meteo_batch.fb
+
+Only the fields the firmware reads are written: location, the current block
+and the hourly block with regular time axis. Variables are written in the
+order of the JSON keys, which is the order of the request lists; the
+variable/unit enums are left out as the decoder reads variables by position.
+"""
+
+import argparse
+import json
+import struct
+
+# Field slots (weather_api.fbs)
+RESPONSE_LATITUDE = 0
+RESPONSE_LONGITUDE = 1
+RESPONSE_ELEVATION = 2
+RESPONSE_GENERATION_TIME = 3
+RESPONSE_LOCATION_ID = 4
+RESPONSE_UTC_OFFSET = 6
+RESPONSE_TIMEZONE = 7
+RESPONSE_TIMEZONE_ABBREVIATION = 8
+RESPONSE_CURRENT = 9
+RESPONSE_HOURLY = 11
+VARIABLES_TIME = 0
+VARIABLES_TIME_END = 1
+VARIABLES_INTERVAL = 2
+VARIABLES_VARIABLES = 3
+VARIABLE_VALUE = 2
+VARIABLE_VALUES = 3
+
+SCALARS = {"f": 4, "i": 4, "q": 8}
+
+
+class Table:
+    """Table to serialize: {slot: (kind, value)}, kind a struct code or
+    "table", "string", "floats", "tables" for referenced objects"""
+
+    def __init__(self, fields):
+        self.fields = fields
+
+
+class Builder:
+    """Forward layout: every object is written before the objects it refers
+    to, so all uoffsets point forward as the format requires"""
+
+    def __init__(self):
+        self.buf = bytearray()
+
+    def align(self, n):
+        self.buf += bytes(-len(self.buf) % n)
+
+    def patch(self, at, target):
+        struct.pack_into("<I", self.buf, at, target - at)
+
+    def table(self, table):
+        slots = sorted(table.fields)
+        # Inline layout: soffset, then 8-byte scalars, then 4-byte fields
+        layout = []
+        size = 4
+        for width in (8, 4):
+            for slot in slots:
+                kind, _ = table.fields[slot]
+                if SCALARS.get(kind, 4) == width:
+                    layout.append((slot, size))
+                    size += width
+        vtable_size = 4 + 2 * (slots[-1] + 1)
+        offsets = dict(layout)
+
+        self.align(2)
+        vtable = len(self.buf)
+        self.buf += struct.pack("<HH", vtable_size, size)
+        for slot in range(slots[-1] + 1):
+            self.buf += struct.pack("<H", offsets.get(slot, 0))
+        self.align(8)
+        start = len(self.buf)
+        self.buf += struct.pack("<i", start - vtable)
+        self.buf += bytes(size - 4)
+
+        children = []
+        for slot, offset in layout:
+            kind, value = table.fields[slot]
+            if kind in SCALARS:
+                struct.pack_into("<" + kind, self.buf, start + offset, value)
+            else:
+                children.append((start + offset, kind, value))
+        for at, kind, value in children:
+            self.patch(at, self.reference(kind, value))
+        return start
+
+    def reference(self, kind, value):
+        self.align(4)
+        at = len(self.buf)
+        if kind == "table":
+            return self.table(value)
+        if kind == "string":
+            data = value.encode()
+            self.buf += struct.pack("<I", len(data)) + data + b"\0"
+        elif kind == "floats":
+            self.buf += struct.pack("<I%df" % len(value), len(value), *value)
+        elif kind == "tables":
+            self.buf += struct.pack("<I", len(value)) + bytes(4 * len(value))
+            for i, table in enumerate(value):
+                self.patch(at + 4 + 4 * i, self.table(table))
+        return at
+
+    def finish(self, root):
+        self.buf += bytes(4)
+        self.patch(0, self.table(root))
+        self.align(4)
+        return bytes(self.buf)
+
+
+def variables(block, skip):
+    """Variables of a JSON block in key order (request order)"""
+    return [(name, values) for name, values in block.items() if name not in skip]
+
+
+def response(location):
+    """WeatherApiResponse table of one location"""
+    fields = {
+        RESPONSE_LATITUDE: ("f", location["latitude"]),
+        RESPONSE_LONGITUDE: ("f", location["longitude"]),
+        RESPONSE_ELEVATION: ("f", location.get("elevation", 0.0)),
+        RESPONSE_GENERATION_TIME: ("f", location.get("generationtime_ms", 0.0)),
+        RESPONSE_LOCATION_ID: ("q", location.get("location_id", 0)),
+        RESPONSE_UTC_OFFSET: ("i", location.get("utc_offset_seconds", 0)),
+        RESPONSE_TIMEZONE: ("string", location.get("timezone", "GMT")),
+        RESPONSE_TIMEZONE_ABBREVIATION: ("string", location.get("timezone_abbreviation", "GMT")),
+    }
+
+    current = location.get("current")
+    if current:
+        fields[RESPONSE_CURRENT] = ("table", Table({
+            VARIABLES_TIME: ("q", current["time"]),
+            VARIABLES_TIME_END: ("q", current["time"] + current["interval"]),
+            VARIABLES_INTERVAL: ("i", current["interval"]),
+            VARIABLES_VARIABLES: ("tables", [
+                Table({VARIABLE_VALUE: ("f", value)})
+                for _, value in variables(current, ("time", "interval"))
+            ]),
+        }))
+
+    hourly = location.get("hourly")
+    if hourly:
+        times = hourly["time"]
+        interval = times[1] - times[0] if len(times) > 1 else 3600
+        if any(b - a != interval for a, b in zip(times, times[1:])):
+            raise SystemExit("hourly time axis is not regular")
+        fields[RESPONSE_HOURLY] = ("table", Table({
+            VARIABLES_TIME: ("q", times[0]),
+            VARIABLES_TIME_END: ("q", times[-1] + interval),
+            VARIABLES_INTERVAL: ("i", interval),
+            VARIABLES_VARIABLES: ("tables", [
+                Table({VARIABLE_VALUES: ("floats", values)})
+                for _, values in variables(hourly, ("time",))
+            ]),
+        }))
+    return Table(fields)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="JSON response (object or array of locations)")
+    parser.add_argument("output", help="size-prefixed FlatBuffers stream")
+    args = parser.parse_args()
+
+    with open(args.input) as f:
+        body = json.load(f)
+    locations = body if isinstance(body, list) else [body]
+
+    stream = bytearray()
+    for location in locations:
+        message = Builder().finish(response(location))
+        stream += struct.pack("<I", len(message)) + message
+    with open(args.output, "wb") as f:
+        f.write(stream)
+    print("%s: %d locations, %d bytes" % (args.output, len(locations), len(stream)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""Stand-in for the Open-Meteo forecast API with injected latency and errors.
+
+Serves /v1/forecast in the JSON shape the firmware requests (current and
+hourly temperature_2m / relative_humidity_2m, unix time) for any number of
+coordinates. Point WEATHER_API_BASE_URL and WEATHER_API_SECONDARY_URL at two
+instances to exercise timeouts, hedging and failover:
+
+    python3 tools/weather_standin.py --port 8081 --latency-ms 200 --jitter-ms 1500
+    python3 tools/weather_standin.py --port 8082 --error-rate 0.3
+
+    #define WEATHER_API_BASE_URL      "http://192.168.1.10:8081/v1/forecast"
+    #define WEATHER_API_SECONDARY_URL "http://192.168.1.10:8082/v1/forecast"
+
+With --tls-cert/--tls-key it serves HTTPS, for comparing the handshake cost of
+the pinned and bundle trust modes (WEATHER_TLS_BENCHMARK). --close disables
+keep-alive so every request needs a new handshake. A local CA for it:
+
+    openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:P-256 -nodes -days 365 \
+        -subj "/CN=Stand-in Root" -keyout ca.key -out ca.pem
+    openssl req -newkey ec -pkeyopt ec_paramgen_curve:P-256 -nodes -subj "/CN=192.168.1.10" \
+        -keyout server.key -out server.csr
+    openssl x509 -req -in server.csr -CA ca.pem -CAkey ca.key -CAcreateserial -days 365 \
+        -extfile <(printf "subjectAltName=IP:192.168.1.10") -out server.pem
+    python3 tools/weather_standin.py --port 8443 --tls-cert server.pem --tls-key server.key
+
+Append ca.pem to components/weather_client/certs/weather_roots.pem for the
+pinned mode, and add it to the bundle (CONFIG_MBEDTLS_CUSTOM_CERTIFICATE_BUNDLE)
+for the bundle mode.
+"""
+
+import argparse
+import json
+import random
+import ssl
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+
+def location(lat, lon, hours, now):
+    """One location of a forecast response"""
+    start = now - now % 3600 - 3600
+    times = [start + 3600 * i for i in range(hours + 1)]
+    base = 27.0 - abs(lat) * 0.1
+    return {
+        "latitude": lat,
+        "longitude": lon,
+        "current": {
+            "time": now - now % 900,
+            "interval": 900,
+            "temperature_2m": round(base + random.uniform(-1, 1), 1),
+            "relative_humidity_2m": random.randint(60, 95),
+        },
+        "hourly": {
+            "time": times,
+            "temperature_2m": [round(base + random.uniform(-2, 2), 1) for _ in times],
+            "relative_humidity_2m": [random.randint(60, 95) for _ in times],
+        },
+    }
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"  # keep-alive, like the real API
+
+    def do_GET(self):
+        args = self.server.args
+        url = urlparse(self.path)
+        if url.path != "/v1/forecast":
+            self.reply(404, b'{"error":true,"reason":"not found"}')
+            return
+
+        delay = args.latency_ms + random.uniform(0, args.jitter_ms)
+        if random.random() < args.stall_rate:
+            delay = args.stall_ms
+        time.sleep(delay / 1000.0)
+
+        if random.random() < args.error_rate:
+            self.reply(random.choice([500, 502, 503]), b'{"error":true,"reason":"injected"}')
+            return
+
+        query = parse_qs(url.query)
+        lats = [float(v) for v in query.get("latitude", ["0"])[0].split(",")]
+        lons = [float(v) for v in query.get("longitude", ["0"])[0].split(",")]
+        hours = int(query.get("forecast_hours", ["12"])[0])
+        now = int(time.time())
+        locations = [location(lat, lon, hours, now) for lat, lon in zip(lats, lons)]
+        body = json.dumps(locations[0] if len(locations) == 1 else locations).encode()
+
+        if random.random() < args.truncate_rate:
+            body = body[: len(body) // 2]
+        self.reply(200, body)
+
+    def reply(self, status, body):
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        if self.server.args.close:
+            self.send_header("Connection", "close")
+            self.close_connection = True
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, fmt, *args):
+        print("%s %s" % (self.address_string(), fmt % args))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", type=int, default=8081)
+    parser.add_argument("--latency-ms", type=float, default=100, help="fixed delay before answering")
+    parser.add_argument("--jitter-ms", type=float, default=0, help="uniform random delay added on top")
+    parser.add_argument("--error-rate", type=float, default=0, help="fraction of requests answered with 5xx")
+    parser.add_argument("--stall-rate", type=float, default=0, help="fraction of requests delayed by --stall-ms")
+    parser.add_argument("--stall-ms", type=float, default=30000)
+    parser.add_argument("--truncate-rate", type=float, default=0, help="fraction of bodies cut in half")
+    parser.add_argument("--tls-cert", help="serve HTTPS with this certificate chain (PEM)")
+    parser.add_argument("--tls-key", help="private key of --tls-cert")
+    parser.add_argument("--close", action="store_true", help="close the connection after every response")
+    args = parser.parse_args()
+
+    server = ThreadingHTTPServer(("", args.port), Handler)
+    server.args = args
+    if args.tls_cert:
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(args.tls_cert, args.tls_key)
+        server.socket = context.wrap_socket(server.socket, server_side=True)
+    print("Open-Meteo stand-in on port %d (%s)" % (args.port, "https" if args.tls_cert else "http"))
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()